@@ -0,0 +1,125 @@
+/**
+ * @file latencyBenchmark.c
+ * @brief Tail latency of shinyFreeThreadSafe() and shinyAllocateThreadSafe() on a thread-safe instance.
+ * @details Every thread keeps a ring of live blocks of mixed sizes and replaces one of them per iteration, the duration
+ * of every call is recorded and the percentiles are reported. Built with SHINYALLOCATOR_MAINTENANCE=1 the releases are
+ * left to the maintenance thread. Run by `make benchmark`.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "shinyAllocator.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef SHINYALLOCATOR_MAINTENANCE
+#define SHINYALLOCATOR_MAINTENANCE 0
+#endif
+
+#define BENCHMARK_ARENA_SIZE (8U * 1024U * 1024U)
+#define BENCHMARK_OPERATIONS 200000U
+#define BENCHMARK_THREADS 4U
+#define BENCHMARK_RING 64U
+#define BENCHMARK_PERIOD_US 500U
+#define BENCHMARK_BUDGET_US 100U
+
+typedef struct
+{
+    size_t seed;
+    uint32_t *freeLatency;
+    uint32_t *allocateLatency;
+} Workload;
+
+static shinyAllocatorThreadSafeInstance *instance;
+
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+static void *worker(void *arg)
+{
+    Workload *const workload = (Workload *)arg;
+    void *ring[BENCHMARK_RING] = {NULL};
+    size_t state = workload->seed;
+    for (size_t i = 0; i < BENCHMARK_OPERATIONS; i++)
+    {
+        state = state * 6364136223846793005U + 1442695040888963407U;
+        const size_t slot = (state >> 33U) % BENCHMARK_RING;
+        const size_t amount = 16U + ((state >> 17U) % 4096U);
+        uint64_t start = now();
+        shinyFreeThreadSafe(instance, ring[slot]);
+        workload->freeLatency[i] = (uint32_t)(now() - start);
+        start = now();
+        ring[slot] = shinyAllocateThreadSafe(instance, amount);
+        workload->allocateLatency[i] = (uint32_t)(now() - start);
+        if (ring[slot] == NULL)
+        {
+            abort();
+        }
+    }
+    for (size_t slot = 0; slot < BENCHMARK_RING; slot++)
+    {
+        shinyFreeThreadSafe(instance, ring[slot]);
+    }
+    return NULL;
+}
+
+static int compare(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a;
+    const uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, uint32_t *latency, const size_t count)
+{
+    qsort(latency, count, sizeof(uint32_t), compare);
+    printf("  %s p50 %6u ns  p99 %6u ns  p99.9 %7u ns  max %8u ns\n", name, latency[count / 2U],
+           latency[(count * 99U) / 100U], latency[(count * 999U) / 1000U], latency[count - 1U]);
+}
+
+int main(void)
+{
+    void *const arena = aligned_alloc(SHINYALLOCATOR_ALIGNMENT, BENCHMARK_ARENA_SIZE);
+    const size_t count = (size_t)BENCHMARK_OPERATIONS * BENCHMARK_THREADS;
+    uint32_t *const freeLatency = (uint32_t *)malloc(count * sizeof(uint32_t));
+    uint32_t *const allocateLatency = (uint32_t *)malloc(count * sizeof(uint32_t));
+    instance = shinyInitThreadSafe(arena, BENCHMARK_ARENA_SIZE);
+    if ((instance == NULL) || (freeLatency == NULL) || (allocateLatency == NULL))
+    {
+        return EXIT_FAILURE;
+    }
+#if SHINYALLOCATOR_MAINTENANCE
+    if (shinyStartMaintenanceThreadSafe(instance, BENCHMARK_PERIOD_US, BENCHMARK_BUDGET_US) != SHINYALLOCATOR_OK)
+    {
+        return EXIT_FAILURE;
+    }
+    printf("maintenance thread, %u thread(s)\n", BENCHMARK_THREADS);
+#else
+    printf("releases under the lock, %u thread(s)\n", BENCHMARK_THREADS);
+#endif
+    pthread_t thread[BENCHMARK_THREADS];
+    Workload workload[BENCHMARK_THREADS];
+    for (size_t t = 0; t < BENCHMARK_THREADS; t++)
+    {
+        workload[t].seed = t + 1U;
+        workload[t].freeLatency = &freeLatency[t * BENCHMARK_OPERATIONS];
+        workload[t].allocateLatency = &allocateLatency[t * BENCHMARK_OPERATIONS];
+        pthread_create(&thread[t], NULL, worker, &workload[t]);
+    }
+    for (size_t t = 0; t < BENCHMARK_THREADS; t++)
+    {
+        pthread_join(thread[t], NULL);
+    }
+    report("free    ", freeLatency, count);
+    report("allocate", allocateLatency, count);
+    shinyDeinitThreadSafe(instance);
+    free(allocateLatency);
+    free(freeLatency);
+    free(arena);
+    return EXIT_SUCCESS;
+}
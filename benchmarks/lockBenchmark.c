@@ -0,0 +1,79 @@
+/**
+ * @file lockBenchmark.c
+ * @brief Per-operation cost of the thread-safe API under the configured lock backend (SHINYALLOCATOR_LOCK).
+ * @details Every thread runs allocate/free pairs of a small block on a shared instance, the cost of one operation is
+ * reported for an increasing number of threads. Built and run for every hosted backend by `make benchmark`.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "shinyAllocator.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef SHINYALLOCATOR_LOCK
+#define SHINYALLOCATOR_LOCK 0
+#endif
+
+#define BENCHMARK_ARENA_SIZE (1024U * 1024U)
+#define BENCHMARK_OPERATIONS 1000000U
+#define BENCHMARK_THREADS_MAX 8U
+#define BENCHMARK_BLOCK_SIZE 48U
+
+static const char *const lockNames[] = {"mutex", "spin-then-block", "ticket", "priority-inheritance"};
+
+static shinyAllocatorThreadSafeInstance *instance;
+
+static void *worker(void *arg)
+{
+    const size_t operations = *(const size_t *)arg;
+    for (size_t i = 0; i < operations; i++)
+    {
+        void *const block = shinyAllocateThreadSafe(instance, BENCHMARK_BLOCK_SIZE);
+        if (block == NULL)
+        {
+            abort();
+        }
+        shinyFreeThreadSafe(instance, block);
+    }
+    return NULL;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(void)
+{
+    void *const arena = aligned_alloc(SHINYALLOCATOR_ALIGNMENT, BENCHMARK_ARENA_SIZE);
+    instance = shinyInitThreadSafe(arena, BENCHMARK_ARENA_SIZE);
+    if (instance == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    printf("%-22s", lockNames[SHINYALLOCATOR_LOCK]);
+    for (size_t threads = 1U; threads <= BENCHMARK_THREADS_MAX; threads *= 2U)
+    {
+        pthread_t thread[BENCHMARK_THREADS_MAX];
+        size_t operations = BENCHMARK_OPERATIONS / threads;
+        const double start = now();
+        for (size_t t = 0; t < threads; t++)
+        {
+            pthread_create(&thread[t], NULL, worker, &operations);
+        }
+        for (size_t t = 0; t < threads; t++)
+        {
+            pthread_join(thread[t], NULL);
+        }
+        // Every pair is two locked operations
+        const double elapsed = now() - start;
+        printf("  %zu thread(s): %7.1f ns/op", threads, elapsed / (double)(operations * threads * 2U));
+    }
+    printf("\n");
+    shinyDeinitThreadSafe(instance);
+    free(arena);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file scalingBenchmark.c
+ * @brief Scaling of the thread-safe designs with the number of threads.
+ * @details Every thread keeps a ring of live blocks of mixed sizes and replaces one of them per iteration. The default
+ * build compares the plain thread-safe instance with a sharded instance, built with SHINYALLOCATOR_COMBINING=1,
+ * SHINYALLOCATOR_PERCPU=1 or SHINYALLOCATOR_FINE_LOCKING=1 it measures that thread-safe design. Run by `make benchmark`.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "shinyAllocator.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef SHINYALLOCATOR_COMBINING
+#define SHINYALLOCATOR_COMBINING 0
+#endif
+
+#ifndef SHINYALLOCATOR_PERCPU
+#define SHINYALLOCATOR_PERCPU 0
+#endif
+
+#ifndef SHINYALLOCATOR_FINE_LOCKING
+#define SHINYALLOCATOR_FINE_LOCKING 0
+#endif
+
+#define BENCHMARK_FRONT_END (SHINYALLOCATOR_COMBINING || SHINYALLOCATOR_PERCPU || SHINYALLOCATOR_FINE_LOCKING)
+
+#define BENCHMARK_ARENA_SIZE (8U * 1024U * 1024U)
+#define BENCHMARK_OPERATIONS 1000000U
+#define BENCHMARK_THREADS_MAX 16U
+#define BENCHMARK_RING 16U
+#define BENCHMARK_SHARDS 4U
+
+typedef void *(*AllocateFunction)(void *pool, size_t amount);
+typedef SHINY_STATUS (*FreeFunction)(void *pool, void *pointer);
+
+typedef struct
+{
+    void *pool;
+    AllocateFunction allocate;
+    FreeFunction release;
+    size_t operations;
+} Workload;
+
+static void *allocateThreadSafe(void *pool, size_t amount)
+{
+    return shinyAllocateThreadSafe((shinyAllocatorThreadSafeInstance *)pool, amount);
+}
+
+static SHINY_STATUS freeThreadSafe(void *pool, void *pointer)
+{
+    return shinyFreeThreadSafe((shinyAllocatorThreadSafeInstance *)pool, pointer);
+}
+
+#if !BENCHMARK_FRONT_END
+static void *allocateSharded(void *pool, size_t amount)
+{
+    return shinyAllocateSharded((shinyAllocatorShardedInstance *)pool, amount);
+}
+
+static SHINY_STATUS freeSharded(void *pool, void *pointer)
+{
+    return shinyFreeSharded((shinyAllocatorShardedInstance *)pool, pointer);
+}
+#endif
+
+static void *worker(void *arg)
+{
+    const Workload *const workload = (const Workload *)arg;
+    void *ring[BENCHMARK_RING] = {NULL};
+    // The pairs are counted as two operations
+    for (size_t i = 0; i < workload->operations / 2U; i++)
+    {
+        const size_t r = i % BENCHMARK_RING;
+        workload->release(workload->pool, ring[r]);
+        ring[r] = workload->allocate(workload->pool, 16U + ((i * 37U) % 240U));
+        if (ring[r] == NULL)
+        {
+            abort();
+        }
+    }
+    for (size_t r = 0; r < BENCHMARK_RING; r++)
+    {
+        workload->release(workload->pool, ring[r]);
+    }
+    return NULL;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void run(const char *const name, void *const pool, const AllocateFunction allocate, const FreeFunction release)
+{
+    printf("%-16s", name);
+    for (size_t threads = 1U; threads <= BENCHMARK_THREADS_MAX; threads *= 2U)
+    {
+        pthread_t thread[BENCHMARK_THREADS_MAX];
+        Workload workload = {pool, allocate, release, BENCHMARK_OPERATIONS / threads};
+        const double start = now();
+        for (size_t t = 0; t < threads; t++)
+        {
+            pthread_create(&thread[t], NULL, worker, &workload);
+        }
+        for (size_t t = 0; t < threads; t++)
+        {
+            pthread_join(thread[t], NULL);
+        }
+        const double elapsed = now() - start;
+        printf("  %2zu: %7.1f ns/op", threads, elapsed / (double)(workload.operations * threads));
+    }
+    printf("\n");
+}
+
+int main(void)
+{
+    void *const arena = aligned_alloc(SHINYALLOCATOR_ALIGNMENT, BENCHMARK_ARENA_SIZE);
+    shinyAllocatorThreadSafeInstance *const threadSafe = shinyInitThreadSafe(arena, BENCHMARK_ARENA_SIZE);
+    if (threadSafe == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+#if BENCHMARK_FRONT_END
+    run(SHINYALLOCATOR_COMBINING ? "flat-combining" : (SHINYALLOCATOR_PERCPU ? "per-cpu rseq" : "per-bin locks"), threadSafe,
+        allocateThreadSafe, freeThreadSafe);
+    shinyFlushThreadCacheThreadSafe(threadSafe);
+    shinyDeinitThreadSafe(threadSafe);
+#else
+    run("mutex", threadSafe, allocateThreadSafe, freeThreadSafe);
+    shinyDeinitThreadSafe(threadSafe);
+    shinyAllocatorShardedInstance *const sharded = shinyInitSharded(arena, BENCHMARK_ARENA_SIZE, BENCHMARK_SHARDS);
+    if (sharded == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    run("sharded", sharded, allocateSharded, freeSharded);
+    shinyDeinitSharded(sharded);
+#endif
+    free(arena);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file tlbBenchmark.c
+ * @brief dTLB misses of random accesses to the blocks of a pool on small pages and of a pool made by shinyInitHuge().
+ * @details The pool is filled with blocks of mixed sizes and one cache line of a random block is read per iteration.
+ * The misses are counted with perf_event_open() where the kernel allows it, the duration is reported in any case.
+ * Built with SHINYALLOCATOR_HUGE_PAGES=1 and run by `make benchmark`.
+ */
+#define _GNU_SOURCE
+#include "shinyAllocator.h"
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCHMARK_POOL_SIZE (256U * 1024U * 1024U)
+#define BENCHMARK_BLOCKS 4096U
+#define BENCHMARK_ACCESSES 20000000U
+
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @return file descriptor of a disabled dTLB load miss counter of this thread, -1 if the kernel does not allow it
+ */
+static int openCounter(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8U) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void run(const char *name, shinyAllocatorInstance *const pool)
+{
+    static char *block[BENCHMARK_BLOCKS];
+    static size_t length[BENCHMARK_BLOCKS];
+    size_t state = 1U;
+    size_t count = 0U;
+    // Blocks from 64 bytes up to 256 KiB, large enough to spread the working set over the whole pool
+    while (count < BENCHMARK_BLOCKS)
+    {
+        state = state * 6364136223846793005U + 1442695040888963407U;
+        length[count] = 64U << ((state >> 33U) % 13U);
+        block[count] = (char *)shinyAllocate(pool, length[count]);
+        if (block[count] == NULL)
+        {
+            break;
+        }
+        memset(block[count], (int)count, length[count]);
+        count++;
+    }
+
+    const int counter = openCounter();
+    if (counter >= 0)
+    {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    const uint64_t start = now();
+    size_t sum = 0U;
+    for (size_t i = 0; i < BENCHMARK_ACCESSES; i++)
+    {
+        state = state * 6364136223846793005U + 1442695040888963407U;
+        const size_t slot = (state >> 33U) % count;
+        sum += (size_t)block[slot][(state >> 7U) % length[slot]];
+    }
+    const uint64_t elapsed = now() - start;
+    uint64_t misses = 0U;
+    if (counter >= 0)
+    {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) != (ssize_t)sizeof(misses))
+        {
+            misses = 0U;
+        }
+        close(counter);
+    }
+
+    if (counter >= 0)
+    {
+        printf("  %s %5zu blocks  %8.2f dTLB misses per 1000 accesses  %6.2f ns per access (checksum %zu)\n", name, count,
+               (double)misses * 1000.0 / BENCHMARK_ACCESSES, (double)elapsed / BENCHMARK_ACCESSES, sum & 0xFFU);
+    }
+    else
+    {
+        printf("  %s %5zu blocks  dTLB misses n/a  %6.2f ns per access (checksum %zu)\n", name, count,
+               (double)elapsed / BENCHMARK_ACCESSES, sum & 0xFFU);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        shinyFree(pool, block[i]);
+    }
+}
+
+int main(void)
+{
+    printf("random block accesses, %u MiB pool\n", BENCHMARK_POOL_SIZE / (1024U * 1024U));
+
+    // The baseline keeps transparent huge pages away from its pool even if they are enabled system wide
+    void *const arena = mmap(NULL, BENCHMARK_POOL_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED)
+    {
+        return EXIT_FAILURE;
+    }
+#ifdef MADV_NOHUGEPAGE
+    (void)madvise(arena, BENCHMARK_POOL_SIZE, MADV_NOHUGEPAGE);
+#endif
+    shinyAllocatorInstance *const small = shinyInit(arena, BENCHMARK_POOL_SIZE);
+    if (small == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    run("small pages", small);
+    munmap(arena, BENCHMARK_POOL_SIZE);
+
+    shinyAllocatorInstance *const huge = shinyInitHuge(BENCHMARK_POOL_SIZE);
+    if (huge == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    run("huge pages ", huge);
+    shinyDeinitHuge(huge);
+    return EXIT_SUCCESS;
+}
@@ -11,6 +11,11 @@
 #ifndef __shinyAllocator_h
 #define __shinyAllocator_h
 
+#ifdef SHINYALLOCATOR_CONFIG_HEADER
+// The layout of the public types depends on the flags of the configuration, so it is read before any flag is tested
+#include SHINYALLOCATOR_CONFIG_HEADER
+#endif
+
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -26,17 +31,77 @@ extern "C"
 #define SHINYALLOCATOR_VERSION_MAJOR 1
 #define SHINYALLOCATOR_VERSION_MINOR 0
 
+/**
+ * @brief status codes returned by SHINY_STATUS functions
+ */
+#define SHINYALLOCATOR_ERROR -1
+#define SHINYALLOCATOR_OK 0
+
+/**
+ * @brief Selects the compact fragment header
+ * @details The header is a single size word with the used flags packed into its low bits, and the physical neighbours
+ * are derived from boundary tags instead of stored pointers. It has to be defined the same way for the library and its users.
+ */
+#ifndef SHINYALLOCATOR_COMPACT_HEADER
+#define SHINYALLOCATOR_COMPACT_HEADER 0
+#endif
+
+/**
+ * @brief Width of the internal links, 0 for pointers or 16/32 for offsets relative to the allocator instance
+ * @details Offset links shrink the instance and the fragment metadata but limit the pool to 64 KiB or 4 GiB, anything
+ * beyond that is left unused by shinyInit(). It has to be defined the same way for the library and its users.
+ */
+#ifndef SHINYALLOCATOR_OFFSET_BITS
+#define SHINYALLOCATOR_OFFSET_BITS 0
+#endif
+
+/**
+ * @brief Provides the fixed-block pool, which needs C11 atomics or the __atomic builtins on hosts
+ * @details It defaults to on wherever one of them is available, and on FreeRTOS and Cortex-M0 which mask the
+ * interrupts instead.
+ */
+#ifndef SHINYALLOCATOR_BLOCK_POOL
+#if defined(SHINYALLOCATOR_FREERTOS) || defined(__ARM_ARCH_6M__) || defined(__GNUC__) || defined(__clang__) || \
+    (defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__))
+#define SHINYALLOCATOR_BLOCK_POOL 1
+#else
+#define SHINYALLOCATOR_BLOCK_POOL 0
+#endif
+#endif
+
 /**
  * @brief Memory alignment based on platform pointer (8/16/32)
- *
+ * @details It may be overridden with any power of two big enough for the selected fragment header.
  */
+#ifndef SHINYALLOCATOR_ALIGNMENT
+#if SHINYALLOCATOR_COMPACT_HEADER
+#define SHINYALLOCATOR_ALIGNMENT (sizeof(void *) * 2U)
+#elif SHINYALLOCATOR_OFFSET_BITS
+#define SHINYALLOCATOR_ALIGNMENT ((size_t)SHINYALLOCATOR_OFFSET_BITS / 2U)
+#else
 #define SHINYALLOCATOR_ALIGNMENT (sizeof(void *) * 4U)
+#endif
+#endif
+
+/**
+ * @brief Bytes of metadata stored in front of every allocated block
+ */
+#if SHINYALLOCATOR_COMPACT_HEADER && SHINYALLOCATOR_OFFSET_BITS
+#define SHINYALLOCATOR_OVERHEAD ((size_t)SHINYALLOCATOR_OFFSET_BITS / 8U)
+#elif SHINYALLOCATOR_COMPACT_HEADER
+#define SHINYALLOCATOR_OVERHEAD (sizeof(size_t))
+#else
+#define SHINYALLOCATOR_OVERHEAD SHINYALLOCATOR_ALIGNMENT
+#endif
 
     /**
      * @brief encapsulation of the structure instance
      */
     typedef struct shinyAllocatorInstance shinyAllocatorInstance;
     typedef struct shinyAllocatorThreadSafeInstance shinyAllocatorThreadSafeInstance;
+    typedef struct shinySlabInstance shinySlabInstance;
+    typedef struct shinyBlockPoolInstance shinyBlockPoolInstance;
+    typedef struct shinyAllocatorShardedInstance shinyAllocatorShardedInstance;
     typedef  int_fast8_t SHINY_STATUS;
     /**
      * @brief shinyAllocator instance
@@ -49,6 +114,18 @@ extern "C"
      * @param peakAllocated the maximum memory ever allocated in the pool(Max. allocated)
      * @param peakRequestSize the maximum size ever allocator tried to allocate
      * @param outOfMemeoryCount non-decreasing number of times the allocation request failed due to lack of memory
+     * @param reallocInPlaceCount number of reallocations served without moving the memory block
+     * @param reallocMovedCount number of reallocations which had to move the memory block to a new fragment
+     * @param remoteFreeCount number of blocks released in bulk from the pending free list of a thread-safe instance
+     * (SHINYALLOCATOR_REMOTE_FREE and SHINYALLOCATOR_MAINTENANCE only)
+     * @param splitSavedCount number of allocations served from the quick lists without searching and splitting a
+     * fragment (SHINYALLOCATOR_QUICK_LISTS only)
+     * @param mergeSavedCount number of releases to the quick lists which skipped merging a free neighbour
+     * (SHINYALLOCATOR_QUICK_LISTS only)
+     * @param purged free bytes whose pages were returned to the OS, the free bytes still resident are
+     * capacity - allocated - purged (SHINYALLOCATOR_PURGE only)
+     * @param mapped bytes in the direct mappings of large blocks, which are neither part of the capacity nor of the
+     * allocated bytes (SHINYALLOCATOR_LARGE_MAPPINGS only)
      */
     typedef struct
     {
@@ -57,6 +134,21 @@ extern "C"
         size_t peakAllocated;
         size_t peakRequestSize;
         size_t outOfMemeoryCount;
+        size_t reallocInPlaceCount;
+        size_t reallocMovedCount;
+#if SHINYALLOCATOR_REMOTE_FREE || SHINYALLOCATOR_MAINTENANCE
+        size_t remoteFreeCount;
+#endif
+#if SHINYALLOCATOR_QUICK_LISTS
+        size_t splitSavedCount;
+        size_t mergeSavedCount;
+#endif
+#if SHINYALLOCATOR_PURGE
+        size_t purged;
+#endif
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        size_t mapped;
+#endif
     } shinyAllocatorDiagnostics;
 
     /**
@@ -69,6 +161,11 @@ extern "C"
      */
     size_t sizeof_shinyAllocatorThreadSafeInstance(void);
 
+    /**
+     * @return size of the shinyAllocatorShardedInstance
+     */
+    size_t sizeof_shinyAllocatorShardedInstance(void);
+
     /**
      * @param handle pointer
      * @return current diagnostics
@@ -79,12 +176,87 @@ extern "C"
      * @brief Initializes the shinyAllocator for the given base pointer and size.
      * @param base base pointer for the pool, it should be aligned to SHINYALLOCATOR_ALIGNMENT.
      * @param size size of the pool, this parameter should not exceed SIZE_MAX/2.
-     * @details allocator occupy 40+ bytes (up to 600 bytes depending on architecture) of the pool for holding its configuration.
+     * @details allocator occupy 40+ bytes (up to 600 bytes depending on architecture, far less with SHINYALLOCATOR_OFFSET_BITS) of the pool for holding its configuration.
      * @returns NULL if the pool is not sufficient for the given size otherwise returns a pointer to the newly initialized allocator.
-     * @note An initialized any resources, hence you can discard it without any de-initialization if it is not needed.
+     * @note An initialized allocator holds no resources besides its pool, hence you can discard it without any
+     * de-initialization if it is not needed. With SHINYALLOCATOR_LARGE_MAPPINGS the blocks mapped on their own have to
+     * be freed or released with shinyDeinit() first.
      */
     shinyAllocatorInstance *shinyInit(void *const base, const size_t size);
 
+    /**
+     * @brief Unmaps the blocks of an allocator which have a mapping of their own (SHINYALLOCATOR_LARGE_MAPPINGS),
+     * the pool itself stays with the caller and the blocks in it stay valid.
+     * @param handle allocator handle.
+     * @return SHINYALLOCATOR_ERROR if the handle is NULL.
+     * @details Without SHINYALLOCATOR_LARGE_MAPPINGS it has no effect.
+     */
+    SHINY_STATUS shinyDeinit(shinyAllocatorInstance *const handle);
+
+    /**
+     * @brief Adds a disjoint memory region to the pool, its space is served by the same bins as the rest of the pool.
+     * @param handle allocator handle.
+     * @param base start of the region, it must not overlap the pool or any region added before.
+     * @param size size of the region.
+     * @return SHINYALLOCATOR_ERROR if the region cannot hold a single fragment, with SHINYALLOCATOR_OFFSET_BITS also if
+     * it does not lie behind the instance within reach of the offsets.
+     * @details Fragments are never coalesced across the gaps between regions, so a request has to fit into a single
+     * region. The capacity of the diagnostics grows by the usable size of the region.
+     */
+    SHINY_STATUS shinyAddRegion(shinyAllocatorInstance *const handle, void *const base, const size_t size);
+
+#if SHINYALLOCATOR_RESERVE
+    /**
+     * @brief Initializes the shinyAllocator on a reserved address range which is committed on demand (hosted builds only).
+     * @param reserve size of the address range, rounded up to SHINYALLOCATOR_COMMIT_GRANULE.
+     * @param commit size of the range committed up front, rounded up to SHINYALLOCATOR_COMMIT_GRANULE.
+     * @returns NULL if the range could not be mapped or cannot hold the allocator otherwise a pointer to the newly
+     * initialized allocator.
+     * @details The range is mapped without access and without swap reservation. Allocations which cannot be served
+     * commit the following granules and grow the last free fragment of the pool instead of failing, the capacity of
+     * the diagnostics is the committed part of the pool. It has to be released with shinyDeinitReserved().
+     */
+    shinyAllocatorInstance *shinyInitReserved(const size_t reserve, const size_t commit);
+
+    /**
+     * @brief Unmaps the address range of an allocator made by shinyInitReserved(), outstanding blocks become invalid.
+     * @param handle allocator handle.
+     * @return SHINYALLOCATOR_ERROR if the allocator was not made by shinyInitReserved().
+     */
+    SHINY_STATUS shinyDeinitReserved(shinyAllocatorInstance *const handle);
+#endif // SHINYALLOCATOR_RESERVE
+
+#if SHINYALLOCATOR_HUGE_PAGES
+    /**
+     * @brief Initializes the shinyAllocator on a pool backed by huge pages (hosted builds only).
+     * @param size size of the pool, rounded up to SHINYALLOCATOR_HUGE_PAGE_SIZE.
+     * @returns NULL if the pool could not be mapped otherwise a pointer to the newly initialized allocator.
+     * @details The pool is mapped with MAP_HUGETLB. When no huge pages are reserved it silently falls back to a
+     * mapping aligned to SHINYALLOCATOR_HUGE_PAGE_SIZE which is advised with MADV_HUGEPAGE, and to small pages if
+     * transparent huge pages are disabled. The payload of blocks of at least a huge page starts on a huge page boundary
+     * whenever the fragment found for them has room for it. It has to be released with shinyDeinitHuge().
+     */
+    shinyAllocatorInstance *shinyInitHuge(const size_t size);
+
+    /**
+     * @brief Unmaps the pool of an allocator made by shinyInitHuge(), outstanding blocks become invalid.
+     * @param handle allocator handle.
+     * @return SHINYALLOCATOR_ERROR if the allocator was not made by shinyInitHuge().
+     */
+    SHINY_STATUS shinyDeinitHuge(shinyAllocatorInstance *const handle);
+#endif // SHINYALLOCATOR_HUGE_PAGES
+
+#if SHINYALLOCATOR_PURGE
+    /**
+     * @brief Returns the pages of every free fragment which are not purged yet to the OS (hosted builds only).
+     * @param handle allocator handle.
+     * @return number of bytes purged by this call.
+     * @details Only the whole pages behind the metadata of a free fragment are discarded with madvise(), they are
+     * faulted in again when the fragment is allocated. Fragments purged before are skipped.
+     */
+    size_t shinyTrim(shinyAllocatorInstance *const handle);
+#endif // SHINYALLOCATOR_PURGE
+
     /**
      * @brief Allocated the requested memory to the given the pool handle, returns NULL if it fails.
      * @param handle allocater handle to the pool.
@@ -93,17 +265,124 @@ extern "C"
      */
     void *shinyAllocate(shinyAllocatorInstance *const handle, const size_t amount);
 
+    /**
+     * @brief Allocates the requested memory with a stricter alignment and an optional boundary constraint, returns NULL if it fails.
+     * @param handle allocater handle to the pool.
+     * @param amount the requested allocation size.
+     * @param alignment power of two alignment of the returned pointer, the natural alignment of the pool is always satisfied.
+     * @param boundary power of two boundary the returned block must not cross, zero for no constraint.
+     * @details The aligned block is carved out of a larger free fragment and the leading and trailing slack is returned to the pool.
+     */
+    void *shinyAllocateAligned(shinyAllocatorInstance *const handle, const size_t amount, const size_t alignment, const size_t boundary);
+
     /**
      * @brief Frees the memory allocated to the given the pool handle.
      * @param handle allocator handle to the pool.
      * @param pointer pointer to the allocated memory.
+     * @details With SHINYALLOCATOR_LARGE_MAPPINGS a page aligned pointer is first looked up in the table of the
+     * SHINYALLOCATOR_LARGE_SLOTS mappings, which takes a comparison per slot.
      */
     void shinyFree(shinyAllocatorInstance *const handle, void *const pointer);
 
     /**
-     * @brief Thread-safe wrapper for shinyGetDiagnostics().
+     * @brief Allocates count blocks of the same size to the given pool handle, all or nothing.
+     * @param handle allocator handle to the pool.
+     * @param amount the requested size of every block.
+     * @param count number of blocks.
+     * @param out array of count pointers receiving the blocks, it is filled with NULL on failure.
+     * @return SHINYALLOCATOR_OK if all blocks were allocated otherwise SHINYALLOCATOR_ERROR.
+     */
+    SHINY_STATUS shinyAllocateBatch(shinyAllocatorInstance *const handle, const size_t amount, const size_t count, void **const out);
+
+    /**
+     * @brief Frees count blocks allocated to the given pool handle.
+     * @param handle allocator handle to the pool.
+     * @param pointers array of pointers to the allocated memory, NULL entries are skipped.
+     * @param count number of pointers.
+     * @note The array is sorted by address in place, in O(count log count), so that adjacent blocks are coalesced in
+     * one step.
+     */
+    void shinyFreeBatch(shinyAllocatorInstance *const handle, void **const pointers, const size_t count);
+
+    /**
+     * @brief Resizes the memory block allocated to the given pool handle, returns NULL if it fails.
+     * @param handle allocator handle to the pool.
+     * @param pointer pointer to the allocated memory, NULL behaves like shinyAllocate().
+     * @param amount the requested new size, zero behaves like shinyFree() and returns NULL.
+     * @details The block is shrunk in place or grown in place into a free right neighbour when possible,
+     * otherwise it is moved to a new fragment. On failure the original block is left untouched.
+     */
+    void *shinyReallocate(shinyAllocatorInstance *const handle, void *const pointer, const size_t amount);
+
+    /**
+     * @brief Initializes a slab front-end for small objects on top of the given pool.
+     * @param handle allocator handle to the pool the slabs are carved from.
+     * @returns NULL if the pool has no room for the slab state otherwise a pointer to the slab front-end.
+     * @details Objects of up to SHINYALLOCATOR_SLAB_CLASSES*sizeof(void *) bytes are served from SHINYALLOCATOR_SLAB_SIZE slabs
+     * without a per-object header, they are aligned to sizeof(void *).
+     */
+    shinySlabInstance *shinySlabInit(shinyAllocatorInstance *const handle);
+
+    /**
+     * @brief Allocates a small object from the slab front-end, returns NULL if it fails or the size is not a slab size class.
+     * @param slab slab front-end handle.
+     * @param amount the requested allocation size.
+     */
+    void *shinySlabAllocate(shinySlabInstance *const slab, const size_t amount);
+
+    /**
+     * @brief Frees a small object allocated by shinySlabAllocate(), empty slabs are returned to the pool.
+     * @param slab slab front-end handle.
+     * @param pointer pointer to the allocated object.
+     */
+    void shinySlabFree(shinySlabInstance *const slab, void *const pointer);
+
+    /**
+     * @brief Returns every slab and the slab state to the pool, outstanding objects become invalid.
+     * @param slab slab front-end handle.
+     */
+    void shinySlabDeinit(shinySlabInstance *const slab);
+
+#if SHINYALLOCATOR_BLOCK_POOL
+    /**
+     * @brief Carves a pool of equal-sized blocks out of a single fragment of the given pool.
+     * @param handle allocator handle to the pool the blocks are carved from.
+     * @param blockSize size of every block, rounded up to sizeof(void *) which is also the alignment of the blocks.
+     * @param count number of blocks.
+     * @returns NULL if the pool has no room for the blocks otherwise a pointer to the block pool.
+     * @details Allocation and release are lock-free on hosts and mask interrupts for a few instructions on Cortex-M0,
+     * so they may be called from any thread or interrupt handler. Initialization and deinitialization use the
+     * allocator handle and are not thread-safe.
+     */
+    shinyBlockPoolInstance *shinyBlockPoolInit(shinyAllocatorInstance *const handle, const size_t blockSize, const size_t count);
+
+    /**
+     * @brief Takes a block from the block pool in O(1), returns NULL if every block is in use.
+     * @param pool block pool handle.
+     */
+    void *shinyBlockPoolAllocate(shinyBlockPoolInstance *const pool);
+
+    /**
+     * @brief Returns a block to the block pool in O(1).
+     * @param pool block pool handle.
+     * @param pointer block taken from this pool or NULL.
+     * @return SHINYALLOCATOR_ERROR if the pointer is not a block of this pool.
+     */
+    SHINY_STATUS shinyBlockPoolFree(shinyBlockPoolInstance *const pool, void *const pointer);
+
+    /**
+     * @brief Returns the blocks and the block pool state to the parent pool, outstanding blocks become invalid.
+     * @param pool block pool handle.
+     */
+    void shinyBlockPoolDeinit(shinyBlockPoolInstance *const pool);
+#endif
+
+    /**
+     * @brief Thread-safe wrapper for shinyGetDiagnostics(), built with GCC or Clang it never takes the lock.
      * @param threadSafeHandle Thread-safe shinyAllocator instance.
-     * @return Diagnostics for the shinyAllocator instance.
+     * @return Diagnostics published by the last thread-safe call that held the lock, blocks waiting on the pending
+     * free list are released first if the lock is free. Other compilers lack the atomics of the sequence lock and read
+     * the diagnostics under the lock.
      */
     shinyAllocatorDiagnostics shinyGetDiagnosticsThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle);
 
@@ -115,6 +394,24 @@ extern "C"
      */
     shinyAllocatorThreadSafeInstance *shinyInitThreadSafe(void *const base, const size_t size);
 
+    /**
+     * @brief Adds a disjoint memory region to a thread-safe shinyAllocator instance, see shinyAddRegion().
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param base start of the region.
+     * @param size size of the region.
+     */
+    SHINY_STATUS shinyAddRegionThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const base, const size_t size);
+
+#if SHINYALLOCATOR_PURGE
+    /**
+     * @brief Thread-safe wrapper for shinyTrim(), the pending releases are applied first.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @return number of bytes purged by this call.
+     * @details A running maintenance thread also trims the pool after every period without releases.
+     */
+    size_t shinyTrimThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle);
+#endif // SHINYALLOCATOR_PURGE
+
     /**
      * @brief Allocates memory from a thread-safe shinyAllocator instance.
      * @param threadSafeHandle Thread-safe shinyAllocator instance.
@@ -123,6 +420,17 @@ extern "C"
      */
     void *shinyAllocateThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount);
 
+    /**
+     * @brief Allocates aligned memory from a thread-safe shinyAllocator instance.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param amount Amount of memory to allocate.
+     * @param alignment Power of two alignment of the returned pointer.
+     * @param boundary Power of two boundary the memory must not cross, zero for no constraint.
+     * @return Pointer to the allocated memory.
+     */
+    void *shinyAllocateAlignedThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount,
+                                         const size_t alignment, const size_t boundary);
+
     /**
      * @brief Frees memory allocated by a thread-safe shinyAllocator instance.
      * @param threadSafeHandle Thread-safe shinyAllocator instance.
@@ -130,12 +438,178 @@ extern "C"
      */
     SHINY_STATUS shinyFreeThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const pointer);
 
+    /**
+     * @brief Resizes memory allocated by a thread-safe shinyAllocator instance.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param pointer Pointer to the memory to be resized.
+     * @param amount New size of the memory.
+     * @return Pointer to the resized memory.
+     */
+    void *shinyReallocateThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const pointer, const size_t amount);
+
+    /**
+     * @brief Allocates count blocks from a thread-safe shinyAllocator instance under a single lock, all or nothing.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param amount Size of every block.
+     * @param count Number of blocks.
+     * @param out Array receiving the blocks.
+     * @return SHINYALLOCATOR_OK if all blocks were allocated otherwise SHINYALLOCATOR_ERROR.
+     */
+    SHINY_STATUS shinyAllocateBatchThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount,
+                                             const size_t count, void **const out);
+
+    /**
+     * @brief Frees count blocks of a thread-safe shinyAllocator instance under a single lock.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param pointers Array of pointers to the memory to be freed, sorted in place.
+     * @param count Number of pointers.
+     */
+    SHINY_STATUS shinyFreeBatchThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void **const pointers,
+                                          const size_t count);
+
+    /**
+     * @brief Returns the blocks held back by the caches and deferred releases of the build to the pool.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @details Cached and queued blocks keep counting as allocated until they are flushed. Depending on the build it
+     * - releases the pending free list (SHINYALLOCATOR_REMOTE_FREE) and the blocks queued for the maintenance thread
+     *   (SHINYALLOCATOR_MAINTENANCE),
+     * - returns the magazines of the calling thread and the shared depot (SHINYALLOCATOR_MAGAZINES), exiting threads
+     *   flush their own magazines, the ones other threads still hold are dropped by shinyDeinitThreadSafe(),
+     * - drains the cache of every CPU in the affinity mask of the calling thread, which is pinned to each of them in
+     *   turn, the caches of other CPUs are left alone (SHINYALLOCATOR_PERCPU),
+     * - merges the free neighbours a busy bin lock kept apart (SHINYALLOCATOR_FINE_LOCKING),
+     * - coalesces the quick lists (SHINYALLOCATOR_QUICK_LISTS),
+     * - releases the blocks freed from interrupts and refills the interrupt reserve (SHINYALLOCATOR_FREERTOS).
+     * Without any of them it has no effect.
+     */
+    SHINY_STATUS shinyFlushThreadCacheThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle);
+
     /**
      * @brief Deinitializes a thread-safe shinyAllocator instance
      *
      * @param threadSafeHandle
      */
     SHINY_STATUS shinyDeinitThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle);
+
+#if SHINYALLOCATOR_MAINTENANCE
+    /**
+     * @brief Starts the maintenance thread of a thread-safe instance, shinyFreeThreadSafe() only queues blocks while
+     * it runs.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param periodMicroseconds time between two wake-ups of the thread.
+     * @param budgetMicroseconds time the thread may spend releasing queued blocks per wake-up, the rest is left for
+     * the next one.
+     * @return SHINYALLOCATOR_ERROR if the thread is already running or could not be started.
+     * @details Allocations which cannot be served release the whole queue themselves.
+     */
+    SHINY_STATUS shinyStartMaintenanceThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle,
+                                                 const uint32_t periodMicroseconds, const uint32_t budgetMicroseconds);
+
+    /**
+     * @brief Stops the maintenance thread and releases the queued blocks, called by shinyDeinitThreadSafe().
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @return SHINYALLOCATOR_ERROR if the thread is not running.
+     */
+    SHINY_STATUS shinyStopMaintenanceThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle);
+#endif // SHINYALLOCATOR_MAINTENANCE
+
+#if SHINYALLOCATOR_EPOCH
+    /**
+     * @brief Enters a read-side critical section of the epoch-based reclamation.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param guard receives the reader slot, it has to be passed to shinyRetireThreadSafe() and
+     * shinyEpochExitThreadSafe().
+     * @details Blocks retired by any thread are not released while a critical section entered before their
+     * retirement is still open. Waits while all SHINYALLOCATOR_EPOCH_SLOTS slots are taken.
+     */
+    SHINY_STATUS shinyEpochEnterThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, size_t *const guard);
+
+    /**
+     * @brief Leaves a read-side critical section, the guard must not be used afterwards.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param guard the reader slot returned by shinyEpochEnterThreadSafe().
+     */
+    SHINY_STATUS shinyEpochExitThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t guard);
+
+    /**
+     * @brief Releases a block once no reader can hold it anymore.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param guard the reader slot of the calling thread's critical section.
+     * @param pointer block already unlinked from every shared structure, or NULL.
+     * @return SHINYALLOCATOR_ERROR if the block could not be retired and is still owned by the caller.
+     * @details Retired blocks keep counting as allocated until they are released in bulk, by the retirement which
+     * fills up the slot or by shinyReclaimThreadSafe().
+     */
+    SHINY_STATUS shinyRetireThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t guard,
+                                       void *const pointer);
+
+    /**
+     * @brief Advances the epoch if every reader has seen the current one and releases the retired blocks whose grace
+     * period has elapsed under a single lock acquisition.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @details Two calls without readers in between release every block retired before them, the remaining ones are
+     * released by shinyDeinitThreadSafe().
+     */
+    SHINY_STATUS shinyReclaimThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle);
+#endif // SHINYALLOCATOR_EPOCH
+
+#ifdef SHINYALLOCATOR_FREERTOS
+    /**
+     * @brief Allocates from the interrupt reserve of a thread-safe instance, callable from interrupt handlers.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param amount the requested allocation size, at most SHINYALLOCATOR_ISR_BLOCK_SIZE.
+     * @return NULL if the request is too large or the reserve is empty otherwise the memory block.
+     * @details The block is a regular block of the pool, tasks may release it with shinyFreeThreadSafe(). The reserve
+     * is topped up by the next thread-safe call made from a task.
+     */
+    void *shinyAllocateFromISR(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount);
+
+    /**
+     * @brief Releases any block of a thread-safe instance from an interrupt handler.
+     * @param threadSafeHandle Thread-safe shinyAllocator instance.
+     * @param pointer the block to be released or NULL.
+     * @details The block is returned to the pool by the next thread-safe call made from a task.
+     */
+    SHINY_STATUS shinyFreeFromISR(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const pointer);
+#endif // SHINYALLOCATOR_FREERTOS
+
+    /**
+     * @brief Initializes a sharded instance which splits the arena into independently locked thread-safe shards.
+     * @param base Base address of the arena, it should be aligned to SHINYALLOCATOR_ALIGNMENT.
+     * @param size Size of the arena.
+     * @param shards Number of shards, between 1 and SHINYALLOCATOR_SHARDS_MAX.
+     * @return Sharded shinyAllocator instance or NULL if the arena is too small.
+     */
+    shinyAllocatorShardedInstance *shinyInitSharded(void *const base, const size_t size, const size_t shards);
+
+    /**
+     * @brief Allocates memory from a sharded instance, returns NULL if no shard can serve the request.
+     * @param shardedHandle Sharded shinyAllocator instance.
+     * @param amount Amount of memory to allocate.
+     * @details The shards are tried without blocking starting from a per-thread shard, the locks are only waited for
+     * when every shard is busy or full.
+     */
+    void *shinyAllocateSharded(shinyAllocatorShardedInstance *const shardedHandle, const size_t amount);
+
+    /**
+     * @brief Frees memory allocated by a sharded instance, the owning shard is found by address.
+     * @param shardedHandle Sharded shinyAllocator instance.
+     * @param pointer Pointer to the memory to be freed.
+     */
+    SHINY_STATUS shinyFreeSharded(shinyAllocatorShardedInstance *const shardedHandle, void *const pointer);
+
+    /**
+     * @brief Diagnostics summed over all shards, the peaks are the sum of the per-shard peaks and outOfMemeoryCount
+     * counts every shard which could not serve a request.
+     * @param shardedHandle Sharded shinyAllocator instance.
+     */
+    shinyAllocatorDiagnostics shinyGetDiagnosticsSharded(shinyAllocatorShardedInstance *const shardedHandle);
+
+    /**
+     * @brief Deinitializes every shard of a sharded instance.
+     * @param shardedHandle Sharded shinyAllocator instance.
+     */
+    SHINY_STATUS shinyDeinitSharded(shinyAllocatorShardedInstance *const shardedHandle);
 #ifdef __cplusplus
 }
 #endif
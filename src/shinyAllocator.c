@@ -9,23 +9,33 @@
  * @copyright 2022 GNU GENERAL PUBLIC LICENSE
  *
  */
+#ifdef SHINYALLOCATOR_CONFIG_HEADER
+// The configuration decides the feature test macros below, which have to precede every system header
+#include SHINYALLOCATOR_CONFIG_HEADER
+#endif
+#if defined(__linux__) &&                                                                                               \
+    (SHINYALLOCATOR_PERCPU || SHINYALLOCATOR_RESERVE || SHINYALLOCATOR_PURGE || SHINYALLOCATOR_HUGE_PAGES ||             \
+     SHINYALLOCATOR_LARGE_MAPPINGS) &&                                                                                  \
+    !defined(_GNU_SOURCE)
+// rseq and the CPU affinity used by the per-CPU caches, MAP_ANONYMOUS, MAP_HUGETLB, madvise() and mremap() are GNU
+// extensions
+#define _GNU_SOURCE
+#endif
+#if !defined(SHINYALLOCATOR_FREERTOS) && !defined(_POSIX_C_SOURCE)
+// PTHREAD_PRIO_INHERIT and sched_yield() are hidden by strict ISO modes
+#define _POSIX_C_SOURCE 200809L
+#endif
 #include "shinyAllocator.h"
 #include <assert.h>
 #include <limits.h>
 #include <stdint.h>
 #include <stddef.h>
-
-#define SHINYALLOCATOR_ERROR -1
-#define SHINYALLOCATOR_OK 0
+#include <string.h>
 
 /***********************
  * Build configurations
  **********************/
 
-#ifdef SHINYALLOCATOR_CONFIG_HEADER
-#include SHINYALLOCATOR_CONFIG_HEADER
-#endif
-
 #ifndef SHINYALLOCATOR_ASSERT
 #define SHINYALLOCATOR_ASSERT(x) assert(x)
 #endif
@@ -52,6 +62,434 @@
 #define SHINYALLOCATOR_PRIVATE static inline
 #endif
 
+/**
+ * @brief Activates the two-level segregated fit (TLSF) bins
+ * @details Every power-of-two bin is subdivided into 2^SHINYALLOCATOR_TLSF_SL_LOG2 linear sub-bins, so fragments are
+ * split to the exact aligned size instead of the next power of two. The lookup stays O(1) at the cost of a larger instance.
+ */
+#ifndef SHINYALLOCATOR_TLSF
+#define SHINYALLOCATOR_TLSF 0
+#endif
+
+#ifndef SHINYALLOCATOR_TLSF_SL_LOG2
+#define SHINYALLOCATOR_TLSF_SL_LOG2 3
+#endif
+
+/**
+ * @brief Deferred coalescing with quick lists
+ * @details shinyFree() pushes fragments of the SHINYALLOCATOR_QUICK_CLASSES smallest fragment sizes onto a list per
+ * size instead of merging them with their neighbours, they stay marked as used and shinyAllocate() hands them out
+ * again without splitting. The lists are coalesced in bulk when an allocation cannot be served otherwise or they hold
+ * more than SHINYALLOCATOR_QUICK_LIMIT fragments. The sizes are the power-of-two fragment sizes, or the consecutive
+ * multiples of the quantum with TLSF bins.
+ */
+#ifndef SHINYALLOCATOR_QUICK_LISTS
+#define SHINYALLOCATOR_QUICK_LISTS 0
+#endif
+
+#ifndef SHINYALLOCATOR_QUICK_CLASSES
+#define SHINYALLOCATOR_QUICK_CLASSES 6U
+#endif
+
+#ifndef SHINYALLOCATOR_QUICK_LIMIT
+#define SHINYALLOCATOR_QUICK_LIMIT 64U
+#endif
+
+/**
+ * @brief Reserved pools committed on demand (hosted builds only)
+ * @details shinyInitReserved() reserves an address range with mmap() without backing it and commits only the start
+ * of it. When an allocation cannot be served the top of the pool is committed in steps of
+ * SHINYALLOCATOR_COMMIT_GRANULE bytes and merged into the last free fragment, until the reservation is used up.
+ */
+#ifndef SHINYALLOCATOR_RESERVE
+#define SHINYALLOCATOR_RESERVE 0
+#endif
+
+#ifndef SHINYALLOCATOR_COMMIT_GRANULE
+#define SHINYALLOCATOR_COMMIT_GRANULE (64U * 1024U)
+#endif
+
+#if SHINYALLOCATOR_RESERVE && (defined(SHINYALLOCATOR_FREERTOS) || !defined(__unix__))
+#error "SHINYALLOCATOR_RESERVE needs mmap()"
+#endif
+
+/**
+ * @brief Returning the pages of free fragments to the OS (hosted builds only)
+ * @details The interior of a free fragment, the whole pages behind its header and free list links, is discarded with
+ * madvise(SHINYALLOCATOR_PURGE_ADVICE) by shinyTrim() and, unless SHINYALLOCATOR_PURGE_THRESHOLD is zero, by every
+ * release which leaves a free fragment of at least that size. Purged fragments are flagged, so their pages are not
+ * discarded again before they are allocated and a merge only discards the parts which are not purged yet.
+ */
+#ifndef SHINYALLOCATOR_PURGE
+#define SHINYALLOCATOR_PURGE 0
+#endif
+
+#ifndef SHINYALLOCATOR_PURGE_THRESHOLD
+#define SHINYALLOCATOR_PURGE_THRESHOLD (256U * 1024U)
+#endif
+
+#ifndef SHINYALLOCATOR_PURGE_ADVICE
+#define SHINYALLOCATOR_PURGE_ADVICE MADV_DONTNEED
+#endif
+
+#if SHINYALLOCATOR_PURGE && (defined(SHINYALLOCATOR_FREERTOS) || !defined(__unix__))
+#error "SHINYALLOCATOR_PURGE needs madvise()"
+#endif
+
+#if SHINYALLOCATOR_PURGE && SHINYALLOCATOR_FINE_LOCKING
+#error "SHINYALLOCATOR_PURGE needs the coalescing of the mutex path"
+#endif
+
+/**
+ * @brief Huge page backed pools (hosted builds only)
+ * @details shinyInitHuge() maps the pool with MAP_HUGETLB and falls back to a mapping aligned to
+ * SHINYALLOCATOR_HUGE_PAGE_SIZE which is advised with MADV_HUGEPAGE. Blocks of at least a huge page are placed on a
+ * huge page boundary whenever the fragment found in the bins has room for it, so they span as few pages as possible.
+ */
+#ifndef SHINYALLOCATOR_HUGE_PAGES
+#define SHINYALLOCATOR_HUGE_PAGES 0
+#endif
+
+#ifndef SHINYALLOCATOR_HUGE_PAGE_SIZE
+#define SHINYALLOCATOR_HUGE_PAGE_SIZE (2U * 1024U * 1024U)
+#endif
+
+#if SHINYALLOCATOR_HUGE_PAGES && (defined(SHINYALLOCATOR_FREERTOS) || !defined(__unix__))
+#error "SHINYALLOCATOR_HUGE_PAGES needs mmap()"
+#endif
+
+/**
+ * @brief Direct mappings of large blocks (Linux builds only)
+ * @details Requests of at least SHINYALLOCATOR_LARGE_THRESHOLD bytes get a mapping of their own instead of a fragment,
+ * it is tracked in a table of SHINYALLOCATOR_LARGE_SLOTS entries in the instance. Releases unmap it right away and
+ * reallocations resize it with mremap() without copying. While the table is full large requests are served by the bins.
+ * Every release and reallocation of a page aligned block scans the whole table, so its size bounds that cost.
+ */
+#ifndef SHINYALLOCATOR_LARGE_MAPPINGS
+#define SHINYALLOCATOR_LARGE_MAPPINGS 0
+#endif
+
+#ifndef SHINYALLOCATOR_LARGE_THRESHOLD
+#define SHINYALLOCATOR_LARGE_THRESHOLD (256U * 1024U)
+#endif
+
+#ifndef SHINYALLOCATOR_LARGE_SLOTS
+#define SHINYALLOCATOR_LARGE_SLOTS 16U
+#endif
+
+#if SHINYALLOCATOR_LARGE_MAPPINGS && (defined(SHINYALLOCATOR_FREERTOS) || !defined(__linux__))
+#error "SHINYALLOCATOR_LARGE_MAPPINGS needs mremap()"
+#endif
+
+#if SHINYALLOCATOR_LARGE_MAPPINGS && SHINYALLOCATOR_FINE_LOCKING
+#error "SHINYALLOCATOR_LARGE_MAPPINGS needs the release path of the mutex"
+#endif
+
+/**
+ * @brief Slab front-end configuration
+ * @details Slabs are SHINYALLOCATOR_SLAB_SIZE aligned fragments of the pool serving SHINYALLOCATOR_SLAB_CLASSES
+ * size classes, which are multiples of sizeof(void *).
+ */
+#ifndef SHINYALLOCATOR_SLAB_SIZE
+#define SHINYALLOCATOR_SLAB_SIZE 1024U
+#endif
+
+#ifndef SHINYALLOCATOR_SLAB_CLASSES
+#define SHINYALLOCATOR_SLAB_CLASSES 8U
+#endif
+
+/**
+ * @brief Per-thread magazine caches in front of the thread-safe API (hosted builds only)
+ * @details Every thread keeps two magazines of up to SHINYALLOCATOR_MAGAZINE_SIZE blocks per size class, the size
+ * classes are the SHINYALLOCATOR_MAGAZINE_CLASSES smallest power-of-two fragment sizes. Hits are served without the
+ * lock, full and empty magazines are exchanged with a shared depot holding up to SHINYALLOCATOR_DEPOT_MAX full
+ * magazines per class.
+ */
+#ifndef SHINYALLOCATOR_MAGAZINES
+#define SHINYALLOCATOR_MAGAZINES 0
+#endif
+
+#ifndef SHINYALLOCATOR_MAGAZINE_SIZE
+#define SHINYALLOCATOR_MAGAZINE_SIZE 16U
+#endif
+
+#ifndef SHINYALLOCATOR_MAGAZINE_CLASSES
+#define SHINYALLOCATOR_MAGAZINE_CLASSES 6U
+#endif
+
+#ifndef SHINYALLOCATOR_DEPOT_MAX
+#define SHINYALLOCATOR_DEPOT_MAX 4U
+#endif
+
+#if SHINYALLOCATOR_MAGAZINES && defined(SHINYALLOCATOR_FREERTOS)
+#error "SHINYALLOCATOR_MAGAZINES needs thread-exit hooks which are only available in hosted builds"
+#endif
+
+/**
+ * @brief Lock-free pending free list of the thread-safe API
+ * @details shinyFreeThreadSafe() pushes blocks onto a per-instance list with a compare-and-swap instead of taking the
+ * lock, the list is released in bulk by the next thread-safe call that holds the lock. Needs the GCC atomic builtins.
+ */
+#ifndef SHINYALLOCATOR_REMOTE_FREE
+#define SHINYALLOCATOR_REMOTE_FREE 0
+#endif
+
+#ifndef SHINYALLOCATOR_REMOTE_FREE_BATCH
+#define SHINYALLOCATOR_REMOTE_FREE_BATCH 32U
+#endif
+
+#if SHINYALLOCATOR_REMOTE_FREE && !(defined(__GNUC__) || defined(__clang__))
+#error "SHINYALLOCATOR_REMOTE_FREE needs the __atomic builtins"
+#endif
+
+/**
+ * @brief Flat combining for the thread-safe API
+ * @details Threads publish their shinyAllocateThreadSafe() and shinyFreeThreadSafe() requests into one of
+ * SHINYALLOCATOR_COMBINING_SLOTS slots, whichever thread gets the lock executes every pending request while the pool
+ * metadata is hot in its cache. A thread finding every slot busy takes the lock itself. Needs the __atomic builtins.
+ */
+#ifndef SHINYALLOCATOR_COMBINING
+#define SHINYALLOCATOR_COMBINING 0
+#endif
+
+#ifndef SHINYALLOCATOR_COMBINING_SLOTS
+#define SHINYALLOCATOR_COMBINING_SLOTS 16U
+#endif
+
+#ifndef SHINYALLOCATOR_CACHE_LINE
+#define SHINYALLOCATOR_CACHE_LINE 64U
+#endif
+
+#if SHINYALLOCATOR_COMBINING && !(defined(__GNUC__) || defined(__clang__))
+#error "SHINYALLOCATOR_COMBINING needs the __atomic builtins"
+#endif
+
+/**
+ * @brief Restartable-sequence per-CPU caches in front of the thread-safe API (Linux only)
+ * @details Every CPU keeps a stack of up to SHINYALLOCATOR_PERCPU_DEPTH blocks for each of the
+ * SHINYALLOCATOR_PERCPU_CLASSES smallest power-of-two fragment sizes. The stacks are changed inside rseq critical
+ * sections without atomics, so the cache memory grows with the number of CPUs (at most SHINYALLOCATOR_PERCPU_CPUS)
+ * instead of the number of threads. The critical sections are implemented for x86_64, elsewhere and whenever glibc
+ * did not register rseq for the thread the locked path is taken.
+ */
+#ifndef SHINYALLOCATOR_PERCPU
+#define SHINYALLOCATOR_PERCPU 0
+#endif
+
+#ifndef SHINYALLOCATOR_PERCPU_CLASSES
+#define SHINYALLOCATOR_PERCPU_CLASSES 6U
+#endif
+
+#ifndef SHINYALLOCATOR_PERCPU_DEPTH
+#define SHINYALLOCATOR_PERCPU_DEPTH 32U
+#endif
+
+#ifndef SHINYALLOCATOR_PERCPU_CPUS
+#define SHINYALLOCATOR_PERCPU_CPUS 64U
+#endif
+
+#if SHINYALLOCATOR_PERCPU && !defined(__linux__)
+#error "SHINYALLOCATOR_PERCPU needs Linux restartable sequences"
+#endif
+
+#if SHINYALLOCATOR_PERCPU && SHINYALLOCATOR_MAGAZINES
+#error "SHINYALLOCATOR_PERCPU and SHINYALLOCATOR_MAGAZINES are alternative caches"
+#endif
+
+/**
+ * @brief Fine-grained locking engine of the thread-safe API (hosted builds only)
+ * @details shinyAllocateThreadSafe() and shinyFreeThreadSafe() only lock the bins and the fragments they touch instead
+ * of the mutex: every bin has a spinlock, every fragment header a lock byte and nonEmptyFragmentMask is updated
+ * atomically, so requests of independent size classes proceed in parallel. Fragment locks are taken from left to
+ * right, a release only tries the lock of its left neighbour and skips that merge when it is busy. Every other
+ * thread-safe call waits for the engine to drain and runs alone under the mutex. Needs the __atomic builtins, the
+ * default fragment header and power-of-two bins.
+ */
+#ifndef SHINYALLOCATOR_FINE_LOCKING
+#define SHINYALLOCATOR_FINE_LOCKING 0
+#endif
+
+#if SHINYALLOCATOR_FINE_LOCKING && !(defined(__GNUC__) || defined(__clang__))
+#error "SHINYALLOCATOR_FINE_LOCKING needs the __atomic builtins"
+#endif
+
+#if SHINYALLOCATOR_FINE_LOCKING && defined(SHINYALLOCATOR_FREERTOS)
+#error "SHINYALLOCATOR_FINE_LOCKING spins on its locks, which only pays off on multi-core hosts"
+#endif
+
+#if SHINYALLOCATOR_FINE_LOCKING && (SHINYALLOCATOR_COMPACT_HEADER || SHINYALLOCATOR_TLSF)
+#error "SHINYALLOCATOR_FINE_LOCKING needs the default fragment header and power-of-two bins"
+#endif
+
+#if SHINYALLOCATOR_FINE_LOCKING && SHINYALLOCATOR_QUICK_LISTS
+#error "SHINYALLOCATOR_FINE_LOCKING releases fragments without going through the quick lists"
+#endif
+
+#if SHINYALLOCATOR_FINE_LOCKING && (SHINYALLOCATOR_COMBINING || SHINYALLOCATOR_REMOTE_FREE)
+#error "SHINYALLOCATOR_FINE_LOCKING, SHINYALLOCATOR_COMBINING and SHINYALLOCATOR_REMOTE_FREE are alternatives to the mutex"
+#endif
+
+/**
+ * @brief Epoch-based reclamation for lock-free structures built on the thread-safe API
+ * @details Readers announce the global epoch in one of SHINYALLOCATOR_EPOCH_SLOTS slots for the duration of a
+ * critical section. Blocks retired through a slot are kept in it with the epoch of their retirement, up to
+ * SHINYALLOCATOR_EPOCH_BATCH of them. Once two epochs have passed no reader can hold them anymore and they are
+ * released in bulk under a single lock acquisition, the ones still in their grace period move to a shared limbo
+ * list allocated from the pool. Needs the __atomic builtins.
+ */
+#ifndef SHINYALLOCATOR_EPOCH
+#define SHINYALLOCATOR_EPOCH 0
+#endif
+
+#ifndef SHINYALLOCATOR_EPOCH_SLOTS
+#define SHINYALLOCATOR_EPOCH_SLOTS 8U
+#endif
+
+#ifndef SHINYALLOCATOR_EPOCH_BATCH
+#define SHINYALLOCATOR_EPOCH_BATCH 16U
+#endif
+
+#if SHINYALLOCATOR_EPOCH && !(defined(__GNUC__) || defined(__clang__))
+#error "SHINYALLOCATOR_EPOCH needs the __atomic builtins"
+#endif
+
+/**
+ * @brief Background maintenance thread of the thread-safe API (hosted builds only)
+ * @details While a thread started with shinyStartMaintenanceThreadSafe() runs, shinyFreeThreadSafe() only queues the
+ * block on the pending free list. The thread wakes up once per period and releases the queue in batches of
+ * SHINYALLOCATOR_REMOTE_FREE_BATCH sorted blocks, taking the lock once per batch, until the queue is empty or its CPU
+ * budget for the period is spent. An idle period trims the magazine depot and, with SHINYALLOCATOR_PURGE, returns free
+ * pages to the OS in steps of SHINYALLOCATOR_TRIM_STEP fragments, taking the lock once per step until the sweep is
+ * done or the budget is spent, the next idle period resumes the sweep. The queue is only released on the hot path by
+ * an allocation which could not be served otherwise. Needs pthreads and the __atomic builtins.
+ */
+#ifndef SHINYALLOCATOR_MAINTENANCE
+#define SHINYALLOCATOR_MAINTENANCE 0
+#endif
+
+#ifndef SHINYALLOCATOR_TRIM_STEP
+#define SHINYALLOCATOR_TRIM_STEP 8U
+#endif
+
+#if SHINYALLOCATOR_MAINTENANCE && (defined(SHINYALLOCATOR_FREERTOS) || !(defined(__GNUC__) || defined(__clang__)))
+#error "SHINYALLOCATOR_MAINTENANCE needs pthreads and the __atomic builtins"
+#endif
+
+#if SHINYALLOCATOR_MAINTENANCE && (SHINYALLOCATOR_COMBINING || SHINYALLOCATOR_FINE_LOCKING)
+#error "SHINYALLOCATOR_MAINTENANCE defers the releases of the mutex path"
+#endif
+
+// Blocks released by shinyFreeThreadSafe() may wait on a lock-free list
+#define PENDING_FREE (SHINYALLOCATOR_REMOTE_FREE || SHINYALLOCATOR_MAINTENANCE)
+
+// The diagnostics of a thread-safe instance are read through a sequence lock where the __atomic builtins exist, other
+// compilers copy them under the mutex
+#if defined(__GNUC__) || defined(__clang__)
+#define DIAGNOSTICS_SEQLOCK 1
+#else
+#define DIAGNOSTICS_SEQLOCK 0
+#endif
+
+// The block pool is lock-free on hosts, through <stdatomic.h> where the library is built as C11 and the __atomic
+// builtins otherwise (C++ and older GNU C), FreeRTOS and Cortex-M0 mask the interrupts instead
+#if SHINYALLOCATOR_BLOCK_POOL && !defined(SHINYALLOCATOR_FREERTOS) && !defined(__ARM_ARCH_6M__) && \
+    !defined(__cplusplus) && defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#define BLOCKPOOL_STDATOMIC 1
+#include <stdatomic.h>
+#else
+#define BLOCKPOOL_STDATOMIC 0
+#endif
+
+#if SHINYALLOCATOR_BLOCK_POOL && !BLOCKPOOL_STDATOMIC && !defined(SHINYALLOCATOR_FREERTOS) && \
+    !defined(__ARM_ARCH_6M__) && !(defined(__GNUC__) || defined(__clang__))
+#error "SHINYALLOCATOR_BLOCK_POOL needs C11 atomics or the __atomic builtins"
+#endif
+
+/**
+ * @brief Maximum number of shards of a sharded instance
+ */
+#ifndef SHINYALLOCATOR_SHARDS_MAX
+#define SHINYALLOCATOR_SHARDS_MAX 8U
+#endif
+
+/**
+ * @brief Interrupt reserve of the thread-safe API (FreeRTOS builds only)
+ * @details SHINYALLOCATOR_ISR_RESERVE blocks of SHINYALLOCATOR_ISR_BLOCK_SIZE bytes are kept aside for
+ * shinyAllocateFromISR(), the reserve and the list of blocks released by shinyFreeFromISR() are only touched with
+ * interrupts masked. Both are serviced by the next thread-safe call made from a task.
+ */
+#ifndef SHINYALLOCATOR_ISR_RESERVE
+#define SHINYALLOCATOR_ISR_RESERVE 4U
+#endif
+
+#ifndef SHINYALLOCATOR_ISR_BLOCK_SIZE
+#define SHINYALLOCATOR_ISR_BLOCK_SIZE 64U
+#endif
+
+/**
+ * @brief Lock backend of the thread-safe API
+ * @details
+ *  - SHINYALLOCATOR_LOCK_MUTEX blocks on a FreeRTOS or pthread mutex (default).
+ *  - SHINYALLOCATOR_LOCK_SPIN tries the mutex SHINYALLOCATOR_SPIN_COUNT times before blocking on it, which avoids the
+ *    sleep and wake-up for the short critical sections of the allocator on multi-core hosts.
+ *  - SHINYALLOCATOR_LOCK_TICKET is a fair FIFO ticket lock which backs off to the scheduler after
+ *    SHINYALLOCATOR_SPIN_COUNT polls, needs the __atomic builtins and atomic read-modify-write instructions, which
+ *    ARMv6-M (Cortex-M0) lacks.
+ *  - SHINYALLOCATOR_LOCK_PI is a pthread mutex with PTHREAD_PRIO_INHERIT for RT Linux, FreeRTOS mutexes inherit
+ *    priority already.
+ *  - SHINYALLOCATOR_LOCK_CRITICAL enters a FreeRTOS critical section, on Cortex-M0 interrupts are masked with PRIMASK
+ *    for the duration of a single call, FreeRTOS only.
+ */
+#define SHINYALLOCATOR_LOCK_MUTEX 0
+#define SHINYALLOCATOR_LOCK_SPIN 1
+#define SHINYALLOCATOR_LOCK_TICKET 2
+#define SHINYALLOCATOR_LOCK_PI 3
+#define SHINYALLOCATOR_LOCK_CRITICAL 4
+
+#ifndef SHINYALLOCATOR_LOCK
+#define SHINYALLOCATOR_LOCK SHINYALLOCATOR_LOCK_MUTEX
+#endif
+
+#ifndef SHINYALLOCATOR_SPIN_COUNT
+#define SHINYALLOCATOR_SPIN_COUNT 64U
+#endif
+
+#if (SHINYALLOCATOR_LOCK < SHINYALLOCATOR_LOCK_MUTEX) || (SHINYALLOCATOR_LOCK > SHINYALLOCATOR_LOCK_CRITICAL)
+#error "SHINYALLOCATOR_LOCK has to be one of the SHINYALLOCATOR_LOCK_* backends"
+#endif
+
+#if (SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_PI) && defined(SHINYALLOCATOR_FREERTOS)
+#error "SHINYALLOCATOR_LOCK_PI is for pthreads, FreeRTOS mutexes already inherit priority"
+#endif
+
+#if (SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_CRITICAL) && !defined(SHINYALLOCATOR_FREERTOS)
+#error "SHINYALLOCATOR_LOCK_CRITICAL needs SHINYALLOCATOR_FREERTOS"
+#endif
+
+#if (SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_TICKET) && !(defined(__GNUC__) || defined(__clang__))
+#error "SHINYALLOCATOR_LOCK_TICKET needs the __atomic builtins"
+#endif
+
+#if (SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_TICKET) && defined(__ARM_ARCH_6M__)
+#error "SHINYALLOCATOR_LOCK_TICKET needs libatomic on ARMv6-M, use SHINYALLOCATOR_LOCK_MUTEX or SHINYALLOCATOR_LOCK_CRITICAL"
+#endif
+
+#ifndef SHINYALLOCATOR_CPU_RELAX
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SHINYALLOCATOR_CPU_RELAX() __builtin_ia32_pause()
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__aarch64__) || (defined(__ARM_ARCH) && (__ARM_ARCH >= 7)))
+#define SHINYALLOCATOR_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define SHINYALLOCATOR_CPU_RELAX() ((void)0)
+#endif
+#endif
+
+#if defined(__cplusplus)
+#define SHINYALLOCATOR_THREAD_LOCAL thread_local
+#else
+#define SHINYALLOCATOR_THREAD_LOCAL _Thread_local
+#endif
+
 #ifndef SHINYALLOCATOR_CLZ
     SHINYALLOCATOR_PRIVATE uint_fast8_t
     SHINYALLOCATOR_CLZ(const size_t x)
@@ -69,13 +507,25 @@
 #endif // SHINYALLOCATOR_CLZ
 
 /***
- * @brief Mutex wrapper around FreeRTOS and Standard mutex interface
+ * @brief Lock backends of the thread-safe API, selected with SHINYALLOCATOR_LOCK
+ * @details Every backend provides mutex_init/destroy/lock/trylock/unlock returning SHINYALLOCATOR_OK or
+ * SHINYALLOCATOR_ERROR.
  */
 #ifdef SHINYALLOCATOR_FREERTOS
 #include <FreeRTOS.h>
 #include <task.h>
 #include <semphr.h>
+#define SHINYALLOCATOR_BACKOFF() vTaskDelay(1)
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#define SHINYALLOCATOR_BACKOFF() sched_yield()
+#endif // SHINYALLOCATOR_FREERTOS
 
+#if (SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_MUTEX) || (SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_SPIN) || \
+    (SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_PI)
+#ifdef SHINYALLOCATOR_FREERTOS
 // Standard mutex type
 typedef struct
 {
@@ -93,11 +543,11 @@ SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_init(mutex_t *mutex)
 SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_destroy(mutex_t *mutex)
 {
     vSemaphoreDelete(mutex->handle);
-    return 0;
+    return SHINYALLOCATOR_OK;
 }
 
-// @brief Lock a mutex
-SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_lock(mutex_t *mutex)
+// @brief Block on a mutex
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_block(mutex_t *mutex)
 {
     return xSemaphoreTake(mutex->handle, portMAX_DELAY) == pdTRUE ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
 }
@@ -113,85 +563,295 @@ SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_unlock(mutex_t *mutex)
     return xSemaphoreGive(mutex->handle) == pdTRUE ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
 }
 #else
-#include <pthread.h>
-
-    typedef pthread_mutex_t mutex_t;
+typedef pthread_mutex_t mutex_t;
 
 SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_init(mutex_t *mutex)
 {
-    return pthread_mutex_init(mutex, NULL);
+#if SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_PI
+    pthread_mutexattr_t attr;
+    if (pthread_mutexattr_init(&attr) != 0)
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    int err = pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    if (err == 0)
+    {
+        err = pthread_mutex_init(mutex, &attr);
+    }
+    pthread_mutexattr_destroy(&attr);
+    return (err == 0) ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
+#else
+    return (pthread_mutex_init(mutex, NULL) == 0) ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
+#endif
 }
 
 SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_destroy(mutex_t *mutex)
 {
-    return pthread_mutex_destroy(mutex);
+    return (pthread_mutex_destroy(mutex) == 0) ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
 }
 
-SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_lock(mutex_t *mutex)
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_block(mutex_t *mutex)
 {
-    return pthread_mutex_lock(mutex);
+    return (pthread_mutex_lock(mutex) == 0) ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
 }
 
 SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_trylock(mutex_t *mutex)
 {
-    return pthread_mutex_trylock(mutex);
+    return (pthread_mutex_trylock(mutex) == 0) ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
 }
 
 SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_unlock(mutex_t *mutex)
 {
-    return pthread_mutex_unlock(mutex);
+    return (pthread_mutex_unlock(mutex) == 0) ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
 }
-
 #endif // SHINYALLOCATOR_FREERTOS
 
-/****************************
- *  Encapsulated definitions
- ****************************/
-
-// #if !defined(__STDC_VERSION__) || (__STDC_VERSION__ < 199901L)
-// #error "Unsupported language: ISO C99 or a newer version is required."
-// #endif // __STDC_VERSION__ || (__STDC_VERSION__ < 199901L)
-
-#if __STDC_VERSION__ < 201112L
-#define static_assert(x, ...) typedef char _static_assert_gl(_static_assertion_, __LINE__)[(x) ? 1 : -1]
-#define _static_assert_gl(a, b) _static_assert_gl_impl(a, b)
-#define _static_assert_gl_impl(a, b) a##b
-#endif // __STDC_VERSION__ <
+// @brief Lock a mutex, the adaptive backend spins on it before blocking
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_lock(mutex_t *mutex)
+{
+#if SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_SPIN
+    for (uint_fast32_t spin = 0U; spin < SHINYALLOCATOR_SPIN_COUNT; spin++)
+    {
+        if (mutex_trylock(mutex) == SHINYALLOCATOR_OK)
+        {
+            return SHINYALLOCATOR_OK;
+        }
+        SHINYALLOCATOR_CPU_RELAX();
+    }
+#endif
+    return mutex_block(mutex);
+}
 
+#elif SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_TICKET
 /**
- * @brief The occupying space by the allocator is maximum SHINYALLOCATOR_ALIGNMENT bytes big and better to be bound
- * the over head with the maximum possible fragment size regarding the overhead of the allocation
+ * @brief FIFO ticket lock, a waiter polls until the serving counter reaches its ticket
  *
+ * @param next the ticket handed to the next waiter
+ * @param serving the ticket currently holding the lock
  */
-#define FRAGMENT_SIZE_MIN (SHINYALLOCATOR_ALIGNMENT * 2U)
-#define FRAGMENT_SIZE_MAX ((SIZE_MAX >> 1U) + 1U)
-
-/**
- * @brief The maximum number of fragments that can be allocated to the pool
- */
-#define NUM_FRAGMENTS_MAX (sizeof(size_t) * CHAR_BIT)
+typedef struct
+{
+    unsigned int next;
+    unsigned int serving;
+} mutex_t;
 
-static_assert((SHINYALLOCATOR_ALIGNMENT & (SHINYALLOCATOR_ALIGNMENT - 1U)) == 0U, "SHINYALLOCATOR_ALIGNMENT not a power of 2");
-static_assert((FRAGMENT_SIZE_MIN & (FRAGMENT_SIZE_MIN - 1U)) == 0U, "FRAGMENT_SIZE_MIN not a power of 2");
-static_assert((FRAGMENT_SIZE_MAX & (FRAGMENT_SIZE_MAX - 1U)) == 0U, "FRAGMENT_SIZE_MAX not a power of 2");
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_init(mutex_t *mutex)
+{
+    __atomic_store_n(&mutex->next, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&mutex->serving, 0U, __ATOMIC_RELEASE);
+    return SHINYALLOCATOR_OK;
+}
 
-typedef struct Fragment Fragment;
-/**
- * @brief structuer to store fragment information
- *
- * @param next stores the pointer to the next fragment
- * @param prev stores the pointer to the previous fragment
- * @param size stores the size of the fragment
- * @param used stores current used capacity of the fragment
- */
-typedef struct FragmentHeader
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_destroy(mutex_t *mutex)
 {
-    Fragment *next;
-    Fragment *prev;
-    size_t size;
+    return (__atomic_load_n(&mutex->next, __ATOMIC_ACQUIRE) == __atomic_load_n(&mutex->serving, __ATOMIC_ACQUIRE))
+               ? SHINYALLOCATOR_OK
+               : SHINYALLOCATOR_ERROR;
+}
+
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_lock(mutex_t *mutex)
+{
+    const unsigned int ticket = __atomic_fetch_add(&mutex->next, 1U, __ATOMIC_RELAXED);
+    uint_fast32_t spin = 0U;
+    while (__atomic_load_n(&mutex->serving, __ATOMIC_ACQUIRE) != ticket)
+    {
+        if (++spin < SHINYALLOCATOR_SPIN_COUNT)
+        {
+            SHINYALLOCATOR_CPU_RELAX();
+        }
+        else
+        {
+            SHINYALLOCATOR_BACKOFF();
+            spin = 0U;
+        }
+    }
+    return SHINYALLOCATOR_OK;
+}
+
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_trylock(mutex_t *mutex)
+{
+    unsigned int ticket = __atomic_load_n(&mutex->serving, __ATOMIC_RELAXED);
+    return __atomic_compare_exchange_n(&mutex->next, &ticket, ticket + 1U, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+               ? SHINYALLOCATOR_OK
+               : SHINYALLOCATOR_ERROR;
+}
+
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_unlock(mutex_t *mutex)
+{
+    // Only the holder writes serving
+    const unsigned int ticket = __atomic_load_n(&mutex->serving, __ATOMIC_RELAXED);
+    __atomic_store_n(&mutex->serving, ticket + 1U, __ATOMIC_RELEASE);
+    return SHINYALLOCATOR_OK;
+}
+
+#elif SHINYALLOCATOR_LOCK == SHINYALLOCATOR_LOCK_CRITICAL
+// Critical sections nest and cannot be contended, the type only keeps the instance layout
+typedef struct
+{
+    uint8_t unused;
+} mutex_t;
+
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_init(mutex_t *mutex)
+{
+    (void)mutex;
+    return SHINYALLOCATOR_OK;
+}
+
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_destroy(mutex_t *mutex)
+{
+    (void)mutex;
+    return SHINYALLOCATOR_OK;
+}
+
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_lock(mutex_t *mutex)
+{
+    (void)mutex;
+    taskENTER_CRITICAL();
+    return SHINYALLOCATOR_OK;
+}
+
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_trylock(mutex_t *mutex)
+{
+    return mutex_lock(mutex);
+}
+
+SHINYALLOCATOR_PRIVATE SHINY_STATUS mutex_unlock(mutex_t *mutex)
+{
+    (void)mutex;
+    taskEXIT_CRITICAL();
+    return SHINYALLOCATOR_OK;
+}
+#endif // SHINYALLOCATOR_LOCK
+
+/****************************
+ *  Encapsulated definitions
+ ****************************/
+
+// #if !defined(__STDC_VERSION__) || (__STDC_VERSION__ < 199901L)
+// #error "Unsupported language: ISO C99 or a newer version is required."
+// #endif // __STDC_VERSION__ || (__STDC_VERSION__ < 199901L)
+
+#if __STDC_VERSION__ < 201112L
+#define static_assert(x, ...) typedef char _static_assert_gl(_static_assertion_, __LINE__)[(x) ? 1 : -1]
+#define _static_assert_gl(a, b) _static_assert_gl_impl(a, b)
+#define _static_assert_gl_impl(a, b) a##b
+#endif // __STDC_VERSION__ <
+
+/**
+ * @brief The occupying space by the allocator is maximum SHINYALLOCATOR_ALIGNMENT bytes big and better to be bound
+ * the over head with the maximum possible fragment size regarding the overhead of the allocation
+ * @details FRAGMENT_QUANTUM is the granularity of fragment sizes, which keeps every payload aligned to it, and
+ * FRAGMENT_HEADER_SIZE is the distance between a fragment and its payload.
+ */
+typedef struct Fragment Fragment;
+
+/**
+ * @brief FragmentRef links fragments together and FragmentWord stores their sizes
+ * @details With SHINYALLOCATOR_OFFSET_BITS both are byte offsets relative to the allocator instance, where zero
+ * stands for NULL as the instance itself is never a fragment.
+ */
+#if SHINYALLOCATOR_OFFSET_BITS == 0
+typedef Fragment *FragmentRef;
+typedef size_t FragmentWord;
+#elif SHINYALLOCATOR_OFFSET_BITS == 16
+typedef uint16_t FragmentRef;
+typedef uint16_t FragmentWord;
+#elif SHINYALLOCATOR_OFFSET_BITS == 32
+typedef uint32_t FragmentRef;
+typedef uint32_t FragmentWord;
+#else
+#error "SHINYALLOCATOR_OFFSET_BITS must be 0, 16 or 32"
+#endif
+
+#define FRAGMENT_HEADER_SIZE SHINYALLOCATOR_OVERHEAD
+#if SHINYALLOCATOR_COMPACT_HEADER
+#define FRAGMENT_QUANTUM SHINYALLOCATOR_ALIGNMENT
+#define FRAGMENT_SIZE_MIN ((sizeof(FragmentWord) * 2U + sizeof(FragmentRef) * 2U + SHINYALLOCATOR_ALIGNMENT - 1U) & ~(SHINYALLOCATOR_ALIGNMENT - 1U))
+#define FRAGMENT_SENTINEL_SIZE FRAGMENT_HEADER_SIZE
+#else
+#define FRAGMENT_QUANTUM (SHINYALLOCATOR_ALIGNMENT * 2U)
+#define FRAGMENT_SIZE_MIN (SHINYALLOCATOR_ALIGNMENT * 2U)
+#define FRAGMENT_SENTINEL_SIZE 0U
+#endif
+#define FRAGMENT_SIZE_MAX ((SIZE_MAX >> 1U) + 1U)
+
+/**
+ * @brief The maximum number of fragments that can be allocated to the pool
+ * @details With offset links the pool never spans more than the offset range, so the bins above it are dropped.
+ */
+#if SHINYALLOCATOR_OFFSET_BITS
+#define NUM_FRAGMENTS_MAX ((size_t)SHINYALLOCATOR_OFFSET_BITS)
+#define FRAGMENT_OFFSET_MAX ((size_t)(FragmentRef)(~(FragmentRef)0U))
+#else
+#define NUM_FRAGMENTS_MAX (sizeof(size_t) * CHAR_BIT)
+#endif
+
+/**
+ * @brief The number of linear sub-bins per power-of-two bin and the total number of bins
+ */
+#if SHINYALLOCATOR_TLSF
+#define NUM_SUB_BINS (1U << SHINYALLOCATOR_TLSF_SL_LOG2)
+static_assert((SHINYALLOCATOR_TLSF_SL_LOG2 >= 1) && (SHINYALLOCATOR_TLSF_SL_LOG2 <= 5), "SHINYALLOCATOR_TLSF_SL_LOG2 out of range");
+#else
+#define NUM_SUB_BINS 1U
+#endif
+#define NUM_BINS (NUM_FRAGMENTS_MAX * NUM_SUB_BINS)
+
+static_assert((SHINYALLOCATOR_ALIGNMENT & (SHINYALLOCATOR_ALIGNMENT - 1U)) == 0U, "SHINYALLOCATOR_ALIGNMENT not a power of 2");
+static_assert(SHINYALLOCATOR_ALIGNMENT >= sizeof(size_t), "SHINYALLOCATOR_ALIGNMENT too small");
+static_assert((FRAGMENT_SIZE_MIN & (FRAGMENT_SIZE_MIN - 1U)) == 0U, "FRAGMENT_SIZE_MIN not a power of 2");
+static_assert((FRAGMENT_SIZE_MAX & (FRAGMENT_SIZE_MAX - 1U)) == 0U, "FRAGMENT_SIZE_MAX not a power of 2");
+static_assert((FRAGMENT_SIZE_MIN % FRAGMENT_QUANTUM) == 0U, "FRAGMENT_SIZE_MIN not a multiple of FRAGMENT_QUANTUM");
+static_assert((sizeof(shinyAllocatorDiagnostics) % sizeof(size_t)) == 0U, "shinyAllocatorDiagnostics not made of size_t words");
+
+#if SHINYALLOCATOR_COMPACT_HEADER
+/**
+ * @brief compact structure to store fragment information
+ * @details Free fragments repeat their size in a footer at their last word, which is the boundary tag the right
+ * neighbour uses to find them. The end of the pool is marked by a used sentinel header of size zero.
+ *
+ * @param tag stores the size of the fragment, FRAGMENT_USED, FRAGMENT_PREV_USED and FRAGMENT_PURGED are packed into its
+ * low bits
+ */
+typedef struct FragmentHeader
+{
+    FragmentWord tag;
+} FragmentHeader;
+#define FRAGMENT_USED ((FragmentWord)1U)
+#define FRAGMENT_PREV_USED ((FragmentWord)2U)
+#if SHINYALLOCATOR_PURGE
+#define FRAGMENT_PURGED ((FragmentWord)4U)
+#define FRAGMENT_FLAGS (FRAGMENT_USED | FRAGMENT_PREV_USED | FRAGMENT_PURGED)
+#else
+#define FRAGMENT_FLAGS (FRAGMENT_USED | FRAGMENT_PREV_USED)
+#endif
+static_assert((FRAGMENT_QUANTUM & FRAGMENT_FLAGS) == 0U, "SHINYALLOCATOR_ALIGNMENT too small for the compact header flags");
+#else
+/**
+ * @brief structuer to store fragment information
+ *
+ * @param next stores the pointer to the next fragment
+ * @param prev stores the pointer to the previous fragment
+ * @param size stores the size of the fragment
+ * @param used stores current used capacity of the fragment
+ * @param locked lock byte guarding the header (fine-grained locking only)
+ * @param purged the interior of the free fragment has been returned to the OS (SHINYALLOCATOR_PURGE only)
+ */
+typedef struct FragmentHeader
+{
+    FragmentRef next;
+    FragmentRef prev;
+    FragmentWord size;
     bool used;
+#if SHINYALLOCATOR_FINE_LOCKING
+    uint8_t locked;
+#endif
+#if SHINYALLOCATOR_PURGE
+    bool purged;
+#endif
 } FragmentHeader;
-static_assert(sizeof(FragmentHeader) <= SHINYALLOCATOR_ALIGNMENT, "Memory layout error");
+#endif
+static_assert(sizeof(FragmentHeader) <= FRAGMENT_HEADER_SIZE, "Memory layout error");
 
 /**
  * @brief Stores current fragment status
@@ -203,463 +863,5075 @@ static_assert(sizeof(FragmentHeader) <= SHINYALLOCATOR_ALIGNMENT, "Memory layout
 struct Fragment
 {
     FragmentHeader header;
-    Fragment *nextFree;
-    Fragment *prevFree;
+    FragmentRef nextFree;
+    FragmentRef prevFree;
 };
-static_assert(sizeof(Fragment) <= FRAGMENT_SIZE_MIN, "Memory layout error");
+static_assert((sizeof(Fragment) + (SHINYALLOCATOR_COMPACT_HEADER ? sizeof(FragmentWord) : 0U)) <= FRAGMENT_SIZE_MIN, "Memory layout error");
+
+#if SHINYALLOCATOR_RESERVE || SHINYALLOCATOR_PURGE || SHINYALLOCATOR_HUGE_PAGES || SHINYALLOCATOR_LARGE_MAPPINGS
+#include <sys/mman.h>
+#include <unistd.h>
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+#endif
+
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+/**
+ * @brief Direct mapping of a large block, the block starts at the beginning of the mapping
+ *
+ * @param base start of the mapping, NULL for an unused slot
+ * @param length size of the mapping
+ */
+typedef struct
+{
+    char *base;
+    size_t length;
+} LargeMapping;
+
+// Every mapping starts on a page boundary and no page is smaller, so other pointers are told apart without a lookup
+#define LARGE_PAGE_MIN 4096U
+#endif
 
 /**
  * @brief the allocator which stores the information about the pool structure
  *
- * @param fragments An array of pointers to all fragments
+ * @param fragments An array of references to the first free fragment of every bin
  * @param the binary Mask for representing the used/allocated fragments
+ * @param nonEmptySubFragmentMask per power-of-two bin mask of the non-empty sub-bins (TLSF only)
+ * @param quick per size list of released fragments waiting to be coalesced, linked through nextFree (quick lists only)
+ * @param quickCount number of fragments in the quick lists (quick lists only)
+ * @param reserveTop used fragment closing the committed part of the pool (reserved pools only)
+ * @param committedEnd end of the committed pages (reserved pools only)
+ * @param reserveEnd end of the reserved address range, NULL if the pool was not made by shinyInitReserved()
+ * @param hugeMapping size of the mapping, zero if the pool was not made by shinyInitHuge()
+ * @param large direct mappings of the large blocks (large mappings only)
  * @param diagnostics  The diagnostics associated with the pool
  */
 struct shinyAllocatorInstance
 {
-    Fragment *fragments[NUM_FRAGMENTS_MAX];
+    FragmentRef fragments[NUM_BINS];
     size_t nonEmptyFragmentMask;
+#if SHINYALLOCATOR_TLSF
+    uint32_t nonEmptySubFragmentMask[NUM_FRAGMENTS_MAX];
+#endif
+#if SHINYALLOCATOR_QUICK_LISTS
+    FragmentRef quick[SHINYALLOCATOR_QUICK_CLASSES];
+    size_t quickCount;
+#endif
+#if SHINYALLOCATOR_RESERVE
+    Fragment *reserveTop;
+    char *committedEnd;
+    char *reserveEnd;
+#endif
+#if SHINYALLOCATOR_HUGE_PAGES
+    size_t hugeMapping;
+#endif
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+    LargeMapping large[SHINYALLOCATOR_LARGE_SLOTS];
+#endif
     shinyAllocatorDiagnostics diagnostics;
 };
 
+#if SHINYALLOCATOR_MAGAZINES
+/**
+ * @brief Stack of cached blocks of a single size class
+ *
+ * @param next next magazine in the depot
+ * @param rounds number of cached blocks
+ * @param round the cached blocks
+ */
+typedef struct Magazine Magazine;
+struct Magazine
+{
+    Magazine *next;
+    size_t rounds;
+    void *round[SHINYALLOCATOR_MAGAZINE_SIZE];
+};
+#endif
+
+#if SHINYALLOCATOR_PERCPU
+#include <sched.h>
+#include <sys/rseq.h>
+#include <unistd.h>
+
+/**
+ * @brief Cached blocks of a single CPU, only changed inside rseq critical sections running on that CPU
+ *
+ * @param count per size class number of cached blocks
+ * @param slot per size class stack of cached blocks
+ */
+typedef struct PerCpuCache
+{
+    size_t count[SHINYALLOCATOR_PERCPU_CLASSES];
+    void *slot[SHINYALLOCATOR_PERCPU_CLASSES][SHINYALLOCATOR_PERCPU_DEPTH];
+} PerCpuCache;
+
+// Caches of neighbouring CPUs do not share cache lines
+#define PERCPU_STRIDE ((sizeof(PerCpuCache) + SHINYALLOCATOR_CACHE_LINE - 1U) & ~((size_t)SHINYALLOCATOR_CACHE_LINE - 1U))
+
+/**
+ * @return number of CPUs getting a cache, the configured CPUs capped at SHINYALLOCATOR_PERCPU_CPUS
+ */
+SHINYALLOCATOR_PRIVATE size_t perCpuCount(void)
+{
+    const long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (cpus <= 0)
+    {
+        return 0U;
+    }
+    return ((size_t)cpus < SHINYALLOCATOR_PERCPU_CPUS) ? (size_t)cpus : SHINYALLOCATOR_PERCPU_CPUS;
+}
+#endif
+
+#if SHINYALLOCATOR_COMBINING
+#define COMBINING_FREE 0U
+#define COMBINING_CLAIMED 1U
+#define COMBINING_PENDING 2U
+#define COMBINING_DONE 3U
+
+#define COMBINING_ALLOCATE 0U
+#define COMBINING_RELEASE 1U
+
+/**
+ * @brief Request slot, padded to a cache line so publishing does not disturb the other slots
+ *
+ * @param state COMBINING_FREE, COMBINING_CLAIMED while the request is written, COMBINING_PENDING until a combiner
+ * executed it and COMBINING_DONE until the result is read
+ * @param operation COMBINING_ALLOCATE or COMBINING_RELEASE
+ * @param amount requested allocation size
+ * @param pointer block to be released, or the allocated block once served
+ */
+typedef struct CombiningSlot
+{
+    unsigned int state;
+    unsigned int operation;
+    size_t amount;
+    void *pointer;
+    uint8_t padding[SHINYALLOCATOR_CACHE_LINE - (2U * sizeof(unsigned int)) - sizeof(size_t) - sizeof(void *)];
+} CombiningSlot;
+#endif
+
+#if SHINYALLOCATOR_EPOCH
+#define EPOCH_FREE 0U
+#define EPOCH_BUSY 1U
+#define EPOCH_READER 2U
+#define EPOCH_SHIFT 2U
+
+/**
+ * @brief Reader slot with the blocks retired through it
+ *
+ * @param state EPOCH_FREE, EPOCH_BUSY while claimed outside of a critical section or EPOCH_READER with the announced
+ * epoch above EPOCH_SHIFT
+ * @param count number of retired blocks
+ * @param retireEpoch per retired block the epoch of its retirement
+ * @param retired the retired blocks
+ */
+typedef struct EpochSlot
+{
+    unsigned int state;
+    size_t count;
+    unsigned int retireEpoch[SHINYALLOCATOR_EPOCH_BATCH];
+    void *retired[SHINYALLOCATOR_EPOCH_BATCH];
+} EpochSlot;
+
+/**
+ * @brief Retired blocks moved out of a full slot while still in their grace period, allocated from the pool
+ *
+ * @param next next entry of the limbo list
+ * @param epoch epoch of the latest retirement
+ * @param count number of retired blocks
+ * @param retired the retired blocks
+ */
+typedef struct EpochLimbo EpochLimbo;
+struct EpochLimbo
+{
+    EpochLimbo *next;
+    unsigned int epoch;
+    size_t count;
+    void *retired[SHINYALLOCATOR_EPOCH_BATCH];
+};
+#endif
+
 /**
  * @brief Initializes the allocator
  *
  * @param handle The allocator handle
  * @param mutex The mutex for the allocator
+ * @param depotFull per size class list of full magazines (magazines only)
+ * @param depotEmpty per size class list of empty magazines (magazines only)
+ * @param depotFullCount per size class number of full magazines (magazines only)
+ * @param magazineGeneration number of this initialization, zero once deinitialized (magazines only)
+ * @param magazineNext next live instance of the magazine registry (magazines only)
+ * @param pendingFree lock-free list of blocks waiting to be released, linked through their payload (remote free only)
+ * @param isrReserve blocks handed out by shinyAllocateFromISR(), linked through their payload (FreeRTOS only)
+ * @param isrReserveCount number of blocks in the interrupt reserve (FreeRTOS only)
+ * @param isrPendingFree blocks released by shinyFreeFromISR(), linked through their payload (FreeRTOS only)
+ * @param diagnosticsSequence sequence lock of the published diagnostics, odd while they are written (GCC and Clang
+ * only)
+ * @param diagnostics copy of the diagnostics published by every holder of the lock before releasing it (GCC and Clang
+ * only)
+ * @param combiningSlot request slots of the threads (combining only)
+ * @param perCpu caches of the CPUs, PERCPU_STRIDE apart right behind the instance (per-CPU only)
+ * @param perCpuCount number of CPUs with a cache (per-CPU only)
+ * @param fineUsers number of requests inside the fine-grained engine, FINE_EXCLUSIVE is set while the holder of the
+ * mutex keeps them out (fine-grained locking only)
+ * @param fineDetached number of engine requests holding fragments taken out of the bins (fine-grained locking only)
+ * @param fineReturned number of such requests which put their fragments back into the bins so far (fine-grained
+ * locking only)
+ * @param binLock per bin spinlock guarding its list (fine-grained locking only)
+ * @param epoch global epoch of the reclamation (epoch only)
+ * @param epochLimbo list of retired blocks waiting for their grace period, guarded by the lock (epoch only)
+ * @param epochSlot reader slots (epoch only)
+ * @param maintenanceThread the maintenance thread (maintenance only)
+ * @param maintenanceMutex guards the start and stop of the maintenance thread (maintenance only)
+ * @param maintenanceWake wakes the maintenance thread up to stop it (maintenance only)
+ * @param maintenanceRunning set while the maintenance thread runs and frees are queued (maintenance only)
+ * @param maintenancePeriod nanoseconds between two wake-ups of the maintenance thread (maintenance only)
+ * @param maintenanceBudget nanoseconds of work the maintenance thread may spend per period (maintenance only)
+ * @param maintenanceBacklog queued blocks taken off the pending free list but not released yet, guarded by the lock
+ * (maintenance only)
+ * @param maintenanceTrimBin bin the idle trim resumes from, zero when a new sweep starts, guarded by the lock
+ * (maintenance with purging only)
  */
 struct shinyAllocatorThreadSafeInstance
 {
     mutex_t mutex;
     shinyAllocatorInstance *handle;
+#if DIAGNOSTICS_SEQLOCK
+    unsigned int diagnosticsSequence;
+    shinyAllocatorDiagnostics diagnostics;
+#endif
+#if PENDING_FREE
+    void *pendingFree;
+#endif
+#ifdef SHINYALLOCATOR_FREERTOS
+    void *isrReserve;
+    size_t isrReserveCount;
+    void *isrPendingFree;
+#endif
+#if SHINYALLOCATOR_MAGAZINES
+    Magazine *depotFull[SHINYALLOCATOR_MAGAZINE_CLASSES];
+    Magazine *depotEmpty[SHINYALLOCATOR_MAGAZINE_CLASSES];
+    size_t depotFullCount[SHINYALLOCATOR_MAGAZINE_CLASSES];
+    size_t magazineGeneration;
+    shinyAllocatorThreadSafeInstance *magazineNext;
+#endif
+#if SHINYALLOCATOR_COMBINING
+    CombiningSlot combiningSlot[SHINYALLOCATOR_COMBINING_SLOTS];
+#endif
+#if SHINYALLOCATOR_PERCPU
+    uint8_t *perCpu;
+    size_t perCpuCount;
+#endif
+#if SHINYALLOCATOR_FINE_LOCKING
+    unsigned int fineUsers;
+    unsigned int fineDetached;
+    unsigned int fineReturned;
+    uint8_t binLock[NUM_BINS];
+#endif
+#if SHINYALLOCATOR_EPOCH
+    unsigned int epoch;
+    EpochLimbo *epochLimbo;
+    EpochSlot epochSlot[SHINYALLOCATOR_EPOCH_SLOTS];
+#endif
+#if SHINYALLOCATOR_MAINTENANCE
+    pthread_t maintenanceThread;
+    pthread_mutex_t maintenanceMutex;
+    pthread_cond_t maintenanceWake;
+    unsigned int maintenanceRunning;
+    uint64_t maintenancePeriod;
+    uint64_t maintenanceBudget;
+    void *maintenanceBacklog;
+#if SHINYALLOCATOR_PURGE
+    size_t maintenanceTrimBin;
+#endif
+#endif
 };
 
+#if SHINYALLOCATOR_FINE_LOCKING
+#define FINE_EXCLUSIVE (~(UINT_MAX >> 1U))
+#endif
+
 /**
- * @brief the amount of space the aligned allocator instance takes
+ * @brief Arena split into independently locked thread-safe shards of equal size
+ *
+ * @param shardCount number of shards
+ * @param shardSize distance between two consecutive shards
+ * @param shard the thread-safe instances, each at the start of its part of the arena
  */
-#define INSTANCE_SIZE_PADDED ((sizeof(shinyAllocatorInstance) + SHINYALLOCATOR_ALIGNMENT - 1U) & ~(SHINYALLOCATOR_ALIGNMENT - 1U))
-static_assert(INSTANCE_SIZE_PADDED >= sizeof(shinyAllocatorInstance), "Invalid instance footprint computation");
-static_assert((INSTANCE_SIZE_PADDED % SHINYALLOCATOR_ALIGNMENT) == 0U, "Invalid instance footprint computation");
+struct shinyAllocatorShardedInstance
+{
+    size_t shardCount;
+    size_t shardSize;
+    shinyAllocatorThreadSafeInstance *shard[SHINYALLOCATOR_SHARDS_MAX];
+};
 
-/**!
- * @brief efficient binary logarithm floor of x implementation
+#define DIAGNOSTICS_WORDS (sizeof(shinyAllocatorDiagnostics) / sizeof(size_t))
+
+/**
+ * @brief Publishes the diagnostics of the pool through the sequence lock, the lock has to be held.
+ * @details Every word is stored atomically, so readers on 32-bit and 64-bit targets never see a torn counter. Without
+ * the sequence lock the readers take the mutex and it has no effect.
  *
- * @param x
- * @return floor of x log 2
+ * @param threadSafeHandle
  */
-SHINYALLOCATOR_PRIVATE uint_fast8_t log2Floor(const size_t x)
+SHINYALLOCATOR_PRIVATE void diagnosticsPublish(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
 {
-    return (uint_fast8_t)(((sizeof(x) * CHAR_BIT) - 1U) - ((uint_fast8_t)SHINYALLOCATOR_CLZ(x)));
+#if DIAGNOSTICS_SEQLOCK
+    const shinyAllocatorDiagnostics current = shinyGetDiagnostics(threadSafeHandle->handle);
+    const size_t *const source = (const size_t *)&current;
+    size_t *const target = (size_t *)&threadSafeHandle->diagnostics;
+    // Only the holder of the lock writes the sequence
+    const unsigned int sequence = __atomic_load_n(&threadSafeHandle->diagnosticsSequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&threadSafeHandle->diagnosticsSequence, sequence + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t i = 0; i < DIAGNOSTICS_WORDS; i++)
+    {
+        __atomic_store_n(&target[i], source[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&threadSafeHandle->diagnosticsSequence, sequence + 2U, __ATOMIC_RELEASE);
+#else
+    (void)threadSafeHandle;
+#endif
 }
 
-/**!
- * @brief efficient binary logarithm ceiling of x implementation
+/**
+ * @brief Polls a busy lock, the processor is yielded to a preempted holder every SHINYALLOCATOR_SPIN_COUNT polls.
  *
- * @param x
- * @return floor of x log 2
+ * @param retry number of polls since the last yield
  */
-SHINYALLOCATOR_PRIVATE uint_fast8_t log2Ceil(const size_t x)
+SHINYALLOCATOR_PRIVATE void spinWait(uint_fast32_t *const retry)
 {
-    return (x <= 1U) ? 0U : (uint_fast8_t)((sizeof(x) * CHAR_BIT) - ((uint_fast8_t)SHINYALLOCATOR_CLZ(x - 1U)));
+    if (++(*retry) < SHINYALLOCATOR_SPIN_COUNT)
+    {
+        SHINYALLOCATOR_CPU_RELAX();
+    }
+    else
+    {
+        SHINYALLOCATOR_BACKOFF();
+        *retry = 0U;
+    }
 }
 
-/**!
- * @brief efficient x-th power of two implementation
+/**
+ * @brief Waits until the requests inside the fine-grained engine have left, the mutex has to be held.
  *
- * @param power
- * @return x-th power of 2
+ * @param threadSafeHandle
  */
-SHINYALLOCATOR_PRIVATE size_t pow2(const uint_fast8_t power)
+SHINYALLOCATOR_PRIVATE void threadSafeExclude(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
 {
-    return ((size_t)1U) << power;
+#if SHINYALLOCATOR_FINE_LOCKING
+    // New requests wait for the flag, so the ones inside cannot starve the holder of the mutex
+    __atomic_fetch_or(&threadSafeHandle->fineUsers, FINE_EXCLUSIVE, __ATOMIC_RELAXED);
+    uint_fast32_t retry = 0U;
+    while (__atomic_load_n(&threadSafeHandle->fineUsers, __ATOMIC_ACQUIRE) != FINE_EXCLUSIVE)
+    {
+        spinWait(&retry);
+    }
+#else
+    (void)threadSafeHandle;
+#endif
 }
 
 /**
- * @param x
- * @return closest power of two
+ * @brief Takes the lock of a thread-safe instance.
+ *
+ * @param threadSafeHandle
+ * @return SHINYALLOCATOR_OK once the lock is held
  */
-SHINYALLOCATOR_PRIVATE size_t roundUpToPowerOfTwo(const size_t x)
+SHINYALLOCATOR_PRIVATE SHINY_STATUS threadSafeLock(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
 {
-    SHINYALLOCATOR_ASSERT(x >= 2U);
-    return ((size_t)1U) << ((sizeof(x) * CHAR_BIT) - ((uint_fast8_t)SHINYALLOCATOR_CLZ(x - 1U)));
+    const SHINY_STATUS status = mutex_lock(&threadSafeHandle->mutex);
+    if (status == SHINYALLOCATOR_OK)
+    {
+        threadSafeExclude(threadSafeHandle);
+    }
+    return status;
+}
+
+/**
+ * @brief Tries to take the lock of a thread-safe instance without blocking on the mutex.
+ *
+ * @param threadSafeHandle
+ * @return SHINYALLOCATOR_OK if the lock is held
+ */
+SHINYALLOCATOR_PRIVATE SHINY_STATUS threadSafeTryLock(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    const SHINY_STATUS status = mutex_trylock(&threadSafeHandle->mutex);
+    if (status == SHINYALLOCATOR_OK)
+    {
+        threadSafeExclude(threadSafeHandle);
+    }
+    return status;
+}
+
+/**
+ * @brief Publishes the diagnostics and releases the lock of a thread-safe instance.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void threadSafeUnlock(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    diagnosticsPublish(threadSafeHandle);
+#if SHINYALLOCATOR_FINE_LOCKING
+    __atomic_store_n(&threadSafeHandle->fineUsers, 0U, __ATOMIC_RELEASE);
+#endif
+    mutex_unlock(&threadSafeHandle->mutex);
+}
+
+#if SHINYALLOCATOR_MAGAZINES
+/**
+ * @brief Magazines of the calling thread, they belong to a single thread-safe instance at a time
+ *
+ * @param owner the instance the cached blocks belong to
+ * @param generation the generation of the owner when the magazines were bound to it
+ * @param loaded per size class magazine serving the requests
+ * @param previous per size class spare magazine, swapped with the loaded one before touching the depot
+ */
+typedef struct MagazineCache
+{
+    shinyAllocatorThreadSafeInstance *owner;
+    size_t generation;
+    Magazine *loaded[SHINYALLOCATOR_MAGAZINE_CLASSES];
+    Magazine *previous[SHINYALLOCATOR_MAGAZINE_CLASSES];
+} MagazineCache;
+
+static SHINYALLOCATOR_THREAD_LOCAL MagazineCache magazineCache;
+static pthread_key_t magazineKey;
+static pthread_once_t magazineKeyOnce = PTHREAD_ONCE_INIT;
+
+// Live instances, so the magazines of a thread never reach an instance deinitialized after they were bound to it
+static pthread_mutex_t magazineRegistryLock = PTHREAD_MUTEX_INITIALIZER;
+static shinyAllocatorThreadSafeInstance *magazineRegistry;
+static size_t magazineGenerations;
+#endif
+
+/**
+ * @brief Header at the start of every slab
+ *
+ * @param next next slab of the size class with free objects
+ * @param prev previous slab of the size class with free objects
+ * @param freeList singly linked list of released objects
+ * @param unused start of the never allocated tail of the slab
+ * @param used number of live objects in the slab
+ * @param sizeClass index of the size class
+ */
+typedef struct Slab Slab;
+struct Slab
+{
+    Slab *next;
+    Slab *prev;
+    void *freeList;
+    char *unused;
+    size_t used;
+    size_t sizeClass;
+};
+
+/**
+ * @brief Slab front-end state, it lives in a fragment of the pool it carves slabs from
+ *
+ * @param handle the pool slabs are carved from
+ * @param partial per size class list of slabs with free objects
+ * @param full list of slabs without free objects
+ */
+struct shinySlabInstance
+{
+    shinyAllocatorInstance *handle;
+    Slab *partial[SHINYALLOCATOR_SLAB_CLASSES];
+    Slab *full;
+};
+
+#define SLAB_OBJECT_QUANTUM (sizeof(void *))
+#define SLAB_OBJECT_SIZE_MAX (SHINYALLOCATOR_SLAB_CLASSES * SLAB_OBJECT_QUANTUM)
+#define SLAB_HEADER_SIZE_PADDED ((sizeof(Slab) + SLAB_OBJECT_QUANTUM - 1U) & ~(SLAB_OBJECT_QUANTUM - 1U))
+#define SLAB_PAYLOAD_SIZE (SHINYALLOCATOR_SLAB_SIZE - FRAGMENT_HEADER_SIZE)
+static_assert((SHINYALLOCATOR_SLAB_SIZE & (SHINYALLOCATOR_SLAB_SIZE - 1U)) == 0U, "SHINYALLOCATOR_SLAB_SIZE not a power of 2");
+static_assert(SHINYALLOCATOR_SLAB_SIZE >= (FRAGMENT_SIZE_MIN * 4U), "SHINYALLOCATOR_SLAB_SIZE too small");
+static_assert(SLAB_PAYLOAD_SIZE >= (SLAB_HEADER_SIZE_PADDED + SLAB_OBJECT_SIZE_MAX * 2U), "SHINYALLOCATOR_SLAB_SIZE too small for the size classes");
+static_assert((SHINYALLOCATOR_HUGE_PAGE_SIZE & (SHINYALLOCATOR_HUGE_PAGE_SIZE - 1U)) == 0U, "SHINYALLOCATOR_HUGE_PAGE_SIZE not a power of 2");
+
+/**
+ * @brief Fixed-block pool state, followed by the links of its blocks and the blocks in a single fragment of the pool
+ *
+ * @param handle the pool the blocks are carved from
+ * @param head tagged top of the free stack, the tag above BLOCKPOOL_INDEX_BITS and the index of the top block plus
+ * one below, zero when the stack is empty
+ * @param blockSize distance between two blocks
+ * @param count number of blocks
+ * @param next per block index plus one of the block below it on the free stack
+ * @param blocks the first block
+ */
+#if SHINYALLOCATOR_BLOCK_POOL
+#if BLOCKPOOL_STDATOMIC
+typedef atomic_size_t BlockPoolLink;
+#define BLOCKPOOL_RELAXED memory_order_relaxed
+#define BLOCKPOOL_ACQUIRE memory_order_acquire
+#define BLOCKPOOL_RELEASE memory_order_release
+#define BLOCKPOOL_LOAD(object, order) atomic_load_explicit((object), (order))
+#define BLOCKPOOL_STORE(object, value, order) atomic_store_explicit((object), (value), (order))
+#define BLOCKPOOL_CAS(object, expected, desired, success, failure) \
+    atomic_compare_exchange_weak_explicit((object), (expected), (desired), (success), (failure))
+#else
+typedef size_t BlockPoolLink;
+#define BLOCKPOOL_RELAXED __ATOMIC_RELAXED
+#define BLOCKPOOL_ACQUIRE __ATOMIC_ACQUIRE
+#define BLOCKPOOL_RELEASE __ATOMIC_RELEASE
+#define BLOCKPOOL_LOAD(object, order) __atomic_load_n((object), (order))
+#define BLOCKPOOL_STORE(object, value, order) __atomic_store_n((object), (value), (order))
+#define BLOCKPOOL_CAS(object, expected, desired, success, failure) \
+    __atomic_compare_exchange_n((object), (expected), (desired), true, (success), (failure))
+#endif
+
+struct shinyBlockPoolInstance
+{
+    shinyAllocatorInstance *handle;
+    BlockPoolLink head;
+    size_t blockSize;
+    size_t count;
+    BlockPoolLink *next;
+    char *blocks;
+};
+
+// The tag changes on every push and pop, so a stale top is never mistaken for the current one
+#define BLOCKPOOL_INDEX_BITS ((sizeof(size_t) * CHAR_BIT) / 2U)
+#define BLOCKPOOL_INDEX_MASK ((((size_t)1U) << BLOCKPOOL_INDEX_BITS) - 1U)
+#define BLOCKPOOL_HEADER_SIZE_PADDED ((sizeof(shinyBlockPoolInstance) + SLAB_OBJECT_QUANTUM - 1U) & ~(SLAB_OBJECT_QUANTUM - 1U))
+#endif // SHINYALLOCATOR_BLOCK_POOL
+
+/**
+ * @brief the amount of space the aligned allocator instance takes
+ */
+#define INSTANCE_SIZE_PADDED ((sizeof(shinyAllocatorInstance) + SHINYALLOCATOR_ALIGNMENT - 1U) & ~(SHINYALLOCATOR_ALIGNMENT - 1U))
+static_assert(INSTANCE_SIZE_PADDED >= sizeof(shinyAllocatorInstance), "Invalid instance footprint computation");
+static_assert((INSTANCE_SIZE_PADDED % SHINYALLOCATOR_ALIGNMENT) == 0U, "Invalid instance footprint computation");
+
+/**!
+ * @brief efficient binary logarithm floor of x implementation
+ *
+ * @param x
+ * @return floor of x log 2
+ */
+SHINYALLOCATOR_PRIVATE uint_fast8_t log2Floor(const size_t x)
+{
+    return (uint_fast8_t)(((sizeof(x) * CHAR_BIT) - 1U) - ((uint_fast8_t)SHINYALLOCATOR_CLZ(x)));
+}
+
+/**!
+ * @brief efficient binary logarithm ceiling of x implementation
+ *
+ * @param x
+ * @return floor of x log 2
+ */
+SHINYALLOCATOR_PRIVATE uint_fast8_t log2Ceil(const size_t x)
+{
+    return (x <= 1U) ? 0U : (uint_fast8_t)((sizeof(x) * CHAR_BIT) - ((uint_fast8_t)SHINYALLOCATOR_CLZ(x - 1U)));
+}
+
+/**!
+ * @brief efficient x-th power of two implementation
+ *
+ * @param power
+ * @return x-th power of 2
+ */
+SHINYALLOCATOR_PRIVATE size_t pow2(const uint_fast8_t power)
+{
+    return ((size_t)1U) << power;
+}
+
+/**
+ * @param x
+ * @return closest power of two
+ */
+SHINYALLOCATOR_PRIVATE size_t roundUpToPowerOfTwo(const size_t x)
+{
+    SHINYALLOCATOR_ASSERT(x >= 2U);
+    return ((size_t)1U) << ((sizeof(x) * CHAR_BIT) - ((uint_fast8_t)SHINYALLOCATOR_CLZ(x - 1U)));
+}
+
+/**
+ * @param handle pointer to the allocater handler
+ * @param ref
+ * @return the fragment the reference points to or NULL
+ */
+SHINYALLOCATOR_PRIVATE Fragment *fragmentDeref(const shinyAllocatorInstance *const handle, const FragmentRef ref)
+{
+#if SHINYALLOCATOR_OFFSET_BITS
+    return (ref == 0U) ? NULL : (Fragment *)(void *)(((char *)handle) + ref);
+#else
+    (void)handle;
+    return ref;
+#endif
+}
+
+/**
+ * @param handle pointer to the allocater handler
+ * @param frag fragment or NULL
+ * @return the reference to the fragment
+ */
+SHINYALLOCATOR_PRIVATE FragmentRef fragmentRef(const shinyAllocatorInstance *const handle, Fragment *const frag)
+{
+#if SHINYALLOCATOR_OFFSET_BITS
+    SHINYALLOCATOR_ASSERT((frag == NULL) || ((((size_t)frag) - ((size_t)handle)) <= FRAGMENT_OFFSET_MAX));
+    return (frag == NULL) ? 0U : (FragmentRef)(((size_t)frag) - ((size_t)handle));
+#else
+    (void)handle;
+    return frag;
+#endif
+}
+
+/**
+ * @param frag
+ * @return size of the fragment
+ */
+SHINYALLOCATOR_PRIVATE size_t fragmentSize(const Fragment *const frag)
+{
+#if SHINYALLOCATOR_COMPACT_HEADER
+    return frag->header.tag & ~FRAGMENT_FLAGS;
+#else
+    return frag->header.size;
+#endif
+}
+
+/**
+ * @param frag
+ * @return true if the fragment is allocated
+ */
+SHINYALLOCATOR_PRIVATE bool fragmentIsUsed(const Fragment *const frag)
+{
+#if SHINYALLOCATOR_COMPACT_HEADER
+    return (frag->header.tag & FRAGMENT_USED) != 0U;
+#else
+    return frag->header.used;
+#endif
+}
+
+/**
+ * @brief Changes the size of the fragment, fragmentLink() has to be called on its right boundary afterwards.
+ *
+ * @param frag
+ * @param size
+ */
+SHINYALLOCATOR_PRIVATE void fragmentSetSize(Fragment *const frag, const size_t size)
+{
+#if SHINYALLOCATOR_COMPACT_HEADER
+    frag->header.tag = (FragmentWord)(size | (frag->header.tag & FRAGMENT_FLAGS));
+#else
+    frag->header.size = (FragmentWord)size;
+#endif
+}
+
+/**
+ * @brief Changes the used flag of the fragment, fragmentLink() has to be called on its right boundary afterwards.
+ *
+ * @param frag
+ * @param used
+ */
+SHINYALLOCATOR_PRIVATE void fragmentSetUsed(Fragment *const frag, const bool used)
+{
+#if SHINYALLOCATOR_COMPACT_HEADER
+    frag->header.tag = (FragmentWord)(used ? (frag->header.tag | FRAGMENT_USED) : (frag->header.tag & ~FRAGMENT_USED));
+#else
+    frag->header.used = used;
+#endif
+}
+
+/**
+ * @brief Writes the header of a new free fragment, it still has to be linked to its neighbours.
+ *
+ * @param frag
+ * @param size
+ */
+SHINYALLOCATOR_PRIVATE void fragmentInit(Fragment *const frag, const size_t size)
+{
+#if SHINYALLOCATOR_COMPACT_HEADER
+    frag->header.tag = (FragmentWord)size;
+#else
+    frag->header.size = (FragmentWord)size;
+    frag->header.used = false;
+#if SHINYALLOCATOR_FINE_LOCKING
+    frag->header.locked = 0U;
+#endif
+#if SHINYALLOCATOR_PURGE
+    frag->header.purged = false;
+#endif
+#endif
+}
+
+/**
+ * @param frag
+ * @return true if the interior of the free fragment has been returned to the OS, always false for used fragments
+ */
+SHINYALLOCATOR_PRIVATE bool fragmentIsPurged(const Fragment *const frag)
+{
+#if SHINYALLOCATOR_PURGE && SHINYALLOCATOR_COMPACT_HEADER
+    return (frag->header.tag & FRAGMENT_PURGED) != 0U;
+#elif SHINYALLOCATOR_PURGE
+    return frag->header.purged;
+#else
+    (void)frag;
+    return false;
+#endif
+}
+
+/**
+ * @param frag
+ * @param purged
+ */
+SHINYALLOCATOR_PRIVATE void fragmentSetPurged(Fragment *const frag, const bool purged)
+{
+#if SHINYALLOCATOR_PURGE && SHINYALLOCATOR_COMPACT_HEADER
+    frag->header.tag = (FragmentWord)(purged ? (frag->header.tag | FRAGMENT_PURGED) : (frag->header.tag & ~FRAGMENT_PURGED));
+#elif SHINYALLOCATOR_PURGE
+    frag->header.purged = purged;
+#else
+    (void)frag;
+    (void)purged;
+#endif
+}
+
+/**
+ * @brief Page-aligned address range [lo, hi) of the interior of a free fragment, empty if lo >= hi
+ */
+typedef struct PurgeRange
+{
+    size_t lo;
+    size_t hi;
+} PurgeRange;
+
+#if SHINYALLOCATOR_RESERVE || SHINYALLOCATOR_PURGE || SHINYALLOCATOR_LARGE_MAPPINGS
+/**
+ * @return size of the pages of the host
+ */
+SHINYALLOCATOR_PRIVATE size_t hostPageSize(void)
+{
+    const long page = sysconf(_SC_PAGESIZE);
+    return (page > 0) ? (size_t)page : 4096U;
+}
+#endif
+
+/**
+ * @param frag
+ * @param size size of the fragment
+ * @return the whole pages of the fragment behind its header and free list links and before the footer of the compact
+ * header, empty without SHINYALLOCATOR_PURGE
+ */
+SHINYALLOCATOR_PRIVATE PurgeRange purgeInterior(const Fragment *const frag, const size_t size)
+{
+    PurgeRange interior = {0U, 0U};
+#if SHINYALLOCATOR_PURGE
+    const size_t page = hostPageSize();
+    interior.lo = (((size_t)frag) + sizeof(Fragment) + page - 1U) & ~(page - 1U);
+    interior.hi = (((size_t)frag) + size - (SHINYALLOCATOR_COMPACT_HEADER ? sizeof(FragmentWord) : 0U)) & ~(page - 1U);
+#else
+    (void)frag;
+    (void)size;
+#endif
+    return interior;
+}
+
+/**
+ * @param frag free fragment or NULL
+ * @return the interior of the fragment if it has been purged, otherwise an empty range
+ */
+SHINYALLOCATOR_PRIVATE PurgeRange purgeKnown(const Fragment *const frag)
+{
+    const PurgeRange none = {0U, 0U};
+    return ((frag != NULL) && fragmentIsPurged(frag)) ? purgeInterior(frag, fragmentSize(frag)) : none;
+}
+
+/**
+ * @param handle pointer to the allocater handler
+ * @param frag
+ * @return the right physical neighbour of the fragment or NULL for the last fragment of the pool
+ */
+SHINYALLOCATOR_PRIVATE Fragment *fragmentNext(const shinyAllocatorInstance *const handle, const Fragment *const frag)
+{
+#if SHINYALLOCATOR_COMPACT_HEADER
+    (void)handle;
+    Fragment *const next = (Fragment *)(void *)(((char *)frag) + fragmentSize(frag));
+    return (fragmentSize(next) == 0U) ? NULL : next;
+#else
+    return fragmentDeref(handle, frag->header.next);
+#endif
+}
+
+/**
+ * @param handle pointer to the allocater handler
+ * @param frag
+ * @return the left physical neighbour of the fragment if it is free otherwise NULL
+ */
+SHINYALLOCATOR_PRIVATE Fragment *fragmentPrevFree(const shinyAllocatorInstance *const handle, const Fragment *const frag)
+{
+#if SHINYALLOCATOR_COMPACT_HEADER
+    (void)handle;
+    if ((frag->header.tag & FRAGMENT_PREV_USED) != 0U)
+    {
+        return NULL;
+    }
+    const size_t prevSize = *(const FragmentWord *)(const void *)(((const char *)frag) - sizeof(FragmentWord));
+    return (Fragment *)(void *)(((char *)frag) - prevSize);
+#else
+    Fragment *const prev = fragmentDeref(handle, frag->header.prev);
+    return ((prev != NULL) && (!prev->header.used)) ? prev : NULL;
+#endif
+}
+
+/**
+ * @brief links the given fragments previous and next fragments in  a LeftToRight manner.
+ * @details With the compact header this writes the boundary tag between them instead, that is the footer of a free
+ * left fragment and the FRAGMENT_PREV_USED flag of the right fragment.
+ *
+ * @param handle pointer to the allocater handler
+ * @param left
+ * @param right
+ */
+SHINYALLOCATOR_PRIVATE void fragmentLink(const shinyAllocatorInstance *const handle, Fragment *left, Fragment *right)
+{
+#if SHINYALLOCATOR_COMPACT_HEADER
+    (void)handle;
+    const bool leftUsed = (left == NULL) || fragmentIsUsed(left);
+    if (!leftUsed)
+    {
+        *(FragmentWord *)(void *)(((char *)left) + fragmentSize(left) - sizeof(FragmentWord)) = (FragmentWord)fragmentSize(left);
+    }
+    if (SHINYALLOCATOR_LIKELY(right != NULL))
+    {
+        right->header.tag = (FragmentWord)(leftUsed ? (right->header.tag | FRAGMENT_PREV_USED) : (right->header.tag & ~FRAGMENT_PREV_USED));
+    }
+#else
+    if (SHINYALLOCATOR_LIKELY(left != NULL))
+    {
+        left->header.next = fragmentRef(handle, right);
+    }
+    if (SHINYALLOCATOR_LIKELY(right != NULL))
+    {
+        right->header.prev = fragmentRef(handle, left);
+    }
+#endif
+}
+
+/**
+ * @brief Maps a fragment size to the bin holding it (floor mapping).
+ *
+ * @param size fragment size (at least FRAGMENT_SIZE_MIN)
+ * @return the index of the bin in the fragments array
+ */
+SHINYALLOCATOR_PRIVATE size_t binIndex(const size_t size)
+{
+    const size_t units = size / FRAGMENT_SIZE_MIN;
+    const uint_fast8_t index = log2Floor(units);
+    SHINYALLOCATOR_ASSERT(index < NUM_FRAGMENTS_MAX);
+#if SHINYALLOCATOR_TLSF
+    const size_t subIndex = (index >= SHINYALLOCATOR_TLSF_SL_LOG2) ? ((units >> (index - SHINYALLOCATOR_TLSF_SL_LOG2)) - NUM_SUB_BINS)
+                                                                   : (units - pow2(index));
+    SHINYALLOCATOR_ASSERT(subIndex < NUM_SUB_BINS);
+    return (((size_t)index) * NUM_SUB_BINS) + subIndex;
+#else
+    return index;
+#endif
+}
+
+/***
+ * @brief Appends a fragment to the allocator pool.
+ *
+ * @param handle pointer to the allocater handler
+ * @param fragment pointer to the appending fragment
+ */
+SHINYALLOCATOR_PRIVATE void appendFragment(shinyAllocatorInstance *const handle, Fragment *const fragment)
+{
+    SHINYALLOCATOR_ASSERT(handle != NULL);
+    SHINYALLOCATOR_ASSERT(fragment != NULL);
+    SHINYALLOCATOR_ASSERT(fragmentSize(fragment) >= FRAGMENT_SIZE_MIN);
+    SHINYALLOCATOR_ASSERT((fragmentSize(fragment) % FRAGMENT_QUANTUM) == 0U);
+    const size_t index = binIndex(fragmentSize(fragment));
+    Fragment *const head = fragmentDeref(handle, handle->fragments[index]);
+    fragment->nextFree = handle->fragments[index];
+    fragment->prevFree = fragmentRef(handle, NULL);
+    if (SHINYALLOCATOR_LIKELY(head != NULL))
+    {
+        head->prevFree = fragmentRef(handle, fragment);
+    }
+    handle->fragments[index] = fragmentRef(handle, fragment);
+#if SHINYALLOCATOR_PURGE
+    if (fragmentIsPurged(fragment))
+    {
+        const PurgeRange interior = purgeInterior(fragment, fragmentSize(fragment));
+        handle->diagnostics.purged += interior.hi - interior.lo;
+    }
+#endif
+#if SHINYALLOCATOR_FINE_LOCKING
+    // Bins of other size classes change their bits concurrently
+    __atomic_fetch_or(&handle->nonEmptyFragmentMask, pow2((uint_fast8_t)index), __ATOMIC_RELAXED);
+#else
+    handle->nonEmptyFragmentMask |= pow2((uint_fast8_t)(index / NUM_SUB_BINS));
+#endif
+#if SHINYALLOCATOR_TLSF
+    handle->nonEmptySubFragmentMask[index / NUM_SUB_BINS] |= ((uint32_t)1U) << (index % NUM_SUB_BINS);
+#endif
+}
+
+/***
+ * @brief Removes a fragment from the allocator pool.
+ *
+ * @param handle pointer to the allocater handler
+ * @param fragment pointer to the appending fragment
+ */
+SHINYALLOCATOR_PRIVATE void removeFragment(shinyAllocatorInstance *const handle, Fragment *const fragment)
+{
+    SHINYALLOCATOR_ASSERT(handle != NULL);
+    SHINYALLOCATOR_ASSERT(fragment != NULL);
+    SHINYALLOCATOR_ASSERT(fragmentSize(fragment) >= FRAGMENT_SIZE_MIN);
+    SHINYALLOCATOR_ASSERT((fragmentSize(fragment) % FRAGMENT_QUANTUM) == 0U);
+    const size_t index = binIndex(fragmentSize(fragment));
+    Fragment *const nextFree = fragmentDeref(handle, fragment->nextFree);
+    Fragment *const prevFree = fragmentDeref(handle, fragment->prevFree);
+#if SHINYALLOCATOR_PURGE
+    if (fragmentIsPurged(fragment))
+    {
+        const PurgeRange interior = purgeInterior(fragment, fragmentSize(fragment));
+        SHINYALLOCATOR_ASSERT(handle->diagnostics.purged >= (interior.hi - interior.lo));
+        handle->diagnostics.purged -= interior.hi - interior.lo;
+    }
+#endif
+
+    if (SHINYALLOCATOR_LIKELY(nextFree != NULL))
+    {
+        nextFree->prevFree = fragment->prevFree;
+    }
+    if (SHINYALLOCATOR_LIKELY(prevFree != NULL))
+    {
+        prevFree->nextFree = fragment->nextFree;
+    }
+
+    if (SHINYALLOCATOR_LIKELY(fragmentDeref(handle, handle->fragments[index]) == fragment))
+    {
+        SHINYALLOCATOR_ASSERT(prevFree == NULL);
+        handle->fragments[index] = fragment->nextFree;
+        if (SHINYALLOCATOR_LIKELY(nextFree == NULL))
+        {
+#if SHINYALLOCATOR_TLSF
+            handle->nonEmptySubFragmentMask[index / NUM_SUB_BINS] &= ~(((uint32_t)1U) << (index % NUM_SUB_BINS));
+            if (handle->nonEmptySubFragmentMask[index / NUM_SUB_BINS] == 0U)
+            {
+                handle->nonEmptyFragmentMask &= ~pow2((uint_fast8_t)(index / NUM_SUB_BINS));
+            }
+#elif SHINYALLOCATOR_FINE_LOCKING
+            __atomic_fetch_and(&handle->nonEmptyFragmentMask, ~pow2((uint_fast8_t)index), __ATOMIC_RELAXED);
+#else
+            handle->nonEmptyFragmentMask &= ~pow2(index);
+#endif
+        }
+    }
+}
+
+/**
+ * @brief Flags a free fragment which is about to enter the bins as purged if its whole interior is.
+ * @details The parts of the interior which were purged before the fragment was formed are given by the interiors of
+ * the purged fragments it was made of, in address order. With release set and a fragment of at least
+ * SHINYALLOCATOR_PURGE_THRESHOLD bytes the rest of the interior is purged now, otherwise the fragment stays resident.
+ *
+ * @param handle pointer to the allocater handler
+ * @param frag free fragment which is not in the bins
+ * @param lower purged interior of the lower part or an empty range
+ * @param upper purged interior of the upper part or an empty range
+ * @param release true if the fragment was formed by releasing memory
+ */
+SHINYALLOCATOR_PRIVATE void purgeSettle(shinyAllocatorInstance *const handle, Fragment *const frag, const PurgeRange lower,
+                                        const PurgeRange upper, const bool release)
+{
+    (void)handle;
+#if SHINYALLOCATOR_PURGE
+    const size_t size = fragmentSize(frag);
+    const PurgeRange interior = purgeInterior(frag, size);
+#if SHINYALLOCATOR_PURGE_THRESHOLD
+    const bool discard = release && (size >= SHINYALLOCATOR_PURGE_THRESHOLD);
+#else
+    const bool discard = false;
+    (void)release;
+#endif
+    const PurgeRange known[2] = {lower, upper};
+    bool purged = interior.lo < interior.hi;
+    size_t cursor = interior.lo;
+    for (size_t i = 0; purged && (i < 2U); i++)
+    {
+        const size_t lo = (known[i].lo > cursor) ? known[i].lo : cursor;
+        const size_t hi = (known[i].hi < interior.hi) ? known[i].hi : interior.hi;
+        if (lo < hi)
+        {
+            purged = (cursor == lo) || (discard && (madvise((void *)cursor, lo - cursor, SHINYALLOCATOR_PURGE_ADVICE) == 0));
+            cursor = hi;
+        }
+    }
+    if (purged && (cursor < interior.hi))
+    {
+        purged = discard && (madvise((void *)cursor, interior.hi - cursor, SHINYALLOCATOR_PURGE_ADVICE) == 0);
+    }
+    fragmentSetPurged(frag, purged);
+#else
+    (void)frag;
+    (void)lower;
+    (void)upper;
+    (void)release;
+#endif
+}
+
+/**
+ * @brief Shrinks a fragment which is not in the bins down to the given size and returns the tail to the bins.
+ * @details The tail is merged with the right neighbour when that one is free, so no two free fragments are ever adjacent.
+ *
+ * @param handle pointer to the allocater handler
+ * @param frag pointer to the fragment being shrunk
+ * @param size the new size of the fragment (multiple of FRAGMENT_QUANTUM)
+ */
+SHINYALLOCATOR_PRIVATE void fragmentSplit(shinyAllocatorInstance *const handle, Fragment *const frag, const size_t size)
+{
+    SHINYALLOCATOR_ASSERT(frag != NULL);
+    SHINYALLOCATOR_ASSERT(fragmentSize(frag) >= size);
+    SHINYALLOCATOR_ASSERT((size % FRAGMENT_QUANTUM) == 0U);
+    const size_t leftover = fragmentSize(frag) - size;
+    SHINYALLOCATOR_ASSERT(leftover < handle->diagnostics.capacity);
+    SHINYALLOCATOR_ASSERT(leftover % FRAGMENT_QUANTUM == 0U);
+    if (SHINYALLOCATOR_LIKELY(leftover >= FRAGMENT_SIZE_MIN))
+    {
+        // The tail of a purged fragment is still purged, its header lies in front of its interior
+        const PurgeRange lower = purgeKnown(frag);
+        PurgeRange upper = purgeKnown(NULL);
+        Fragment *next = fragmentNext(handle, frag);
+        fragmentSetSize(frag, size);
+        Fragment *const newFrag = (Fragment *)(void *)(((char *)frag) + size);
+        SHINYALLOCATOR_ASSERT((((size_t)newFrag) + FRAGMENT_HEADER_SIZE) % FRAGMENT_QUANTUM == 0U);
+        fragmentInit(newFrag, leftover);
+        if ((next != NULL) && (!fragmentIsUsed(next)))
+        {
+            upper = purgeKnown(next);
+            removeFragment(handle, next);
+            fragmentSetSize(newFrag, leftover + fragmentSize(next));
+            next = fragmentNext(handle, next);
+        }
+        fragmentLink(handle, frag, newFrag);
+        fragmentLink(handle, newFrag, next);
+        purgeSettle(handle, newFrag, lower, upper, fragmentIsUsed(frag));
+        appendFragment(handle, newFrag);
+    }
+}
+
+/**
+ * @param frag pointer to the fragment
+ * @param alignment power of two of at least FRAGMENT_QUANTUM
+ * @return the number of leading bytes to split off so the payload is aligned, zero or at least FRAGMENT_SIZE_MIN
+ */
+SHINYALLOCATOR_PRIVATE size_t fragmentLead(const Fragment *const frag, const size_t alignment)
+{
+    const size_t payload = ((size_t)frag) + FRAGMENT_HEADER_SIZE;
+    size_t lead = ((payload + alignment - 1U) & ~(alignment - 1U)) - payload;
+    while ((lead > 0U) && (lead < FRAGMENT_SIZE_MIN))
+    {
+        lead += alignment;
+    }
+    SHINYALLOCATOR_ASSERT((lead % FRAGMENT_QUANTUM) == 0U);
+    return lead;
+}
+
+/**
+ * @brief Returns the first bytes of a fragment which is not in the bins to the bins.
+ *
+ * @param handle pointer to the allocater handler
+ * @param frag pointer to the fragment
+ * @param lead the number of bytes to split off as returned by fragmentLead()
+ * @return the remaining fragment behind the lead, still out of the bins
+ */
+SHINYALLOCATOR_PRIVATE Fragment *fragmentSplitLead(shinyAllocatorInstance *const handle, Fragment *const frag, const size_t lead)
+{
+    SHINYALLOCATOR_ASSERT(fragmentSize(frag) > lead);
+    if (lead == 0U)
+    {
+        return frag;
+    }
+    Fragment *const aligned = (Fragment *)(void *)(((char *)frag) + lead);
+    Fragment *const next = fragmentNext(handle, frag);
+    fragmentInit(aligned, fragmentSize(frag) - lead);
+    fragmentSetPurged(aligned, fragmentIsPurged(frag));
+    fragmentSetSize(frag, lead);
+    fragmentLink(handle, aligned, next);
+    fragmentLink(handle, frag, aligned);
+    appendFragment(handle, frag);
+    return aligned;
+}
+
+/**
+ * @brief Moves the payload of a block of at least a huge page onto a huge page boundary if the fragment has room for it.
+ *
+ * @param handle pointer to the allocater handler
+ * @param frag pointer to the fragment taken from the bins
+ * @param size the required fragment size
+ * @return the fragment to serve the block from, still out of the bins
+ */
+SHINYALLOCATOR_PRIVATE Fragment *hugeAlign(shinyAllocatorInstance *const handle, Fragment *const frag, const size_t size)
+{
+#if SHINYALLOCATOR_HUGE_PAGES
+    if ((handle->hugeMapping != 0U) && (size >= SHINYALLOCATOR_HUGE_PAGE_SIZE))
+    {
+        const size_t lead = fragmentLead(frag, SHINYALLOCATOR_HUGE_PAGE_SIZE);
+        if ((fragmentSize(frag) - size) >= lead)
+        {
+            return fragmentSplitLead(handle, frag, lead);
+        }
+    }
+#else
+    (void)handle;
+    (void)size;
+#endif
+    return frag;
+}
+
+/**
+ * @brief Finds the first fragment of the smallest non-empty bin which is guaranteed to hold the given size.
+ *
+ * @param handle pointer to the allocater handler
+ * @param size the required fragment size (multiple of FRAGMENT_QUANTUM)
+ * @return pointer to the fragment (still in the bins) or NULL if there is none
+ */
+SHINYALLOCATOR_PRIVATE Fragment *findFragment(shinyAllocatorInstance *const handle, const size_t size)
+{
+    SHINYALLOCATOR_ASSERT((size % FRAGMENT_QUANTUM) == 0U);
+#if SHINYALLOCATOR_TLSF
+    // Round the size up to the start of the next sub-bin, so every fragment of the found sub-bin is large enough
+    size_t units = (size + FRAGMENT_SIZE_MIN - 1U) / FRAGMENT_SIZE_MIN;
+    uint_fast8_t index = log2Floor(units);
+    if (index >= SHINYALLOCATOR_TLSF_SL_LOG2)
+    {
+        units += pow2((uint_fast8_t)(index - SHINYALLOCATOR_TLSF_SL_LOG2)) - 1U;
+    }
+    const size_t optimalBin = binIndex(units * FRAGMENT_SIZE_MIN);
+    index = (uint_fast8_t)(optimalBin / NUM_SUB_BINS);
+    uint32_t subMask = handle->nonEmptySubFragmentMask[index] & (~((uint32_t)0U) << (optimalBin % NUM_SUB_BINS));
+    if (subMask == 0U)
+    {
+        const size_t suitableFragments = handle->nonEmptyFragmentMask & ~(pow2(index) | (pow2(index) - 1U));
+        if (suitableFragments == 0U)
+        {
+            return NULL;
+        }
+        index = log2Floor(suitableFragments & ~(suitableFragments - 1U));
+        subMask = handle->nonEmptySubFragmentMask[index];
+    }
+    SHINYALLOCATOR_ASSERT(subMask != 0U);
+    Fragment *const frag = fragmentDeref(handle, handle->fragments[(((size_t)index) * NUM_SUB_BINS) + log2Floor(subMask & ~(subMask - 1U))]);
+    SHINYALLOCATOR_ASSERT(frag != NULL);
+    SHINYALLOCATOR_ASSERT(fragmentSize(frag) >= size);
+    SHINYALLOCATOR_ASSERT(!fragmentIsUsed(frag));
+    return frag;
+#else
+    const uint_fast8_t optimalFragmentIndex = log2Ceil((size + FRAGMENT_SIZE_MIN - 1U) / FRAGMENT_SIZE_MIN);
+    SHINYALLOCATOR_ASSERT(optimalFragmentIndex < NUM_FRAGMENTS_MAX);
+    const size_t candidateFragmentMask = ~(pow2(optimalFragmentIndex) - 1U);
+
+    const size_t suitableFragments = handle->nonEmptyFragmentMask & candidateFragmentMask;
+    const size_t smallestFragmentMask = suitableFragments & ~(suitableFragments - 1U);
+
+    Fragment *frag = NULL;
+    if (SHINYALLOCATOR_LIKELY(smallestFragmentMask != 0))
+    {
+        SHINYALLOCATOR_ASSERT((smallestFragmentMask & (smallestFragmentMask - 1U)) == 0U);
+        const uint_fast8_t fragmentIndex = log2Floor(smallestFragmentMask);
+        SHINYALLOCATOR_ASSERT(fragmentIndex >= optimalFragmentIndex);
+        SHINYALLOCATOR_ASSERT(fragmentIndex < NUM_FRAGMENTS_MAX);
+
+        frag = fragmentDeref(handle, handle->fragments[fragmentIndex]);
+        SHINYALLOCATOR_ASSERT(frag != NULL);
+        SHINYALLOCATOR_ASSERT(fragmentSize(frag) >= size);
+        SHINYALLOCATOR_ASSERT((fragmentSize(frag) % FRAGMENT_QUANTUM) == 0U);
+        SHINYALLOCATOR_ASSERT(!fragmentIsUsed(frag));
+    }
+    return frag;
+#endif
+}
+
+/**
+ * @brief Computes the size of the fragment serving an allocation request.
+ *
+ * @param amount the requested allocation size
+ * @return the next power of two, or the next multiple of FRAGMENT_QUANTUM with TLSF bins
+ */
+SHINYALLOCATOR_PRIVATE size_t fragmentSizeFor(const size_t amount)
+{
+#if SHINYALLOCATOR_TLSF
+    const size_t size = (amount + FRAGMENT_HEADER_SIZE + FRAGMENT_QUANTUM - 1U) & ~(FRAGMENT_QUANTUM - 1U);
+#else
+    const size_t size = roundUpToPowerOfTwo(amount + FRAGMENT_HEADER_SIZE);
+#endif
+    return (size < FRAGMENT_SIZE_MIN) ? FRAGMENT_SIZE_MIN : size;
+}
+
+/**
+ * @brief Marks a detached fragment as used and accounts it in the diagnostics.
+ *
+ * @param handle pointer to the allocater handler
+ * @param frag pointer to the allocated fragment
+ * @return pointer to the payload of the fragment
+ */
+SHINYALLOCATOR_PRIVATE void *fragmentCommit(shinyAllocatorInstance *const handle, Fragment *const frag)
+{
+    SHINYALLOCATOR_ASSERT((handle->diagnostics.allocated % FRAGMENT_QUANTUM) == 0U);
+    handle->diagnostics.allocated += fragmentSize(frag);
+    SHINYALLOCATOR_ASSERT(handle->diagnostics.allocated <= handle->diagnostics.capacity);
+    if (SHINYALLOCATOR_LIKELY(handle->diagnostics.peakAllocated < handle->diagnostics.allocated))
+    {
+        handle->diagnostics.peakAllocated = handle->diagnostics.allocated;
+    }
+    fragmentSetUsed(frag, true);
+    fragmentSetPurged(frag, false);
+    fragmentLink(handle, frag, fragmentNext(handle, frag));
+    return ((char *)frag) + FRAGMENT_HEADER_SIZE;
+}
+
+/**
+ * @brief Updates the request related diagnostics after an allocation attempt.
+ *
+ * @param handle pointer to the allocater handler
+ * @param amount the requested allocation size
+ * @param out the result of the allocation
+ */
+SHINYALLOCATOR_PRIVATE void updateRequestDiagnostics(shinyAllocatorInstance *const handle, const size_t amount, const void *const out)
+{
+    if (SHINYALLOCATOR_LIKELY(handle->diagnostics.peakRequestSize < amount))
+    {
+        handle->diagnostics.peakRequestSize = amount;
+    }
+    if (SHINYALLOCATOR_LIKELY((out == NULL) && (amount > 0U)))
+    {
+        handle->diagnostics.outOfMemeoryCount++;
+    }
+}
+
+/**
+ * @brief Recovers the fragment of an allocated memory block.
+ *
+ * @param handle pointer to the allocater handler
+ * @param pointer pointer to the allocated memory
+ * @return pointer to the used fragment
+ */
+SHINYALLOCATOR_PRIVATE Fragment *fragmentFromPointer(const shinyAllocatorInstance *const handle, void *const pointer)
+{
+    Fragment *const frag = (Fragment *)(void *)(((char *)pointer) - FRAGMENT_HEADER_SIZE);
+    (void)handle;
+
+    SHINYALLOCATOR_ASSERT(((size_t)frag) % sizeof(FragmentWord) == 0U);
+#if SHINYALLOCATOR_OFFSET_BITS
+    // Regions added with shinyAddRegion() may lie anywhere within reach of the offsets
+    SHINYALLOCATOR_ASSERT(((size_t)frag) >= (((size_t)handle) + INSTANCE_SIZE_PADDED));
+    SHINYALLOCATOR_ASSERT((((size_t)frag) - ((size_t)handle)) <= (FRAGMENT_OFFSET_MAX - FRAGMENT_SIZE_MIN));
+#endif
+    SHINYALLOCATOR_ASSERT(fragmentIsUsed(frag));
+    SHINYALLOCATOR_ASSERT(fragmentSize(frag) >= FRAGMENT_SIZE_MIN);
+    SHINYALLOCATOR_ASSERT(fragmentSize(frag) <= handle->diagnostics.capacity);
+    SHINYALLOCATOR_ASSERT((fragmentSize(frag) % FRAGMENT_QUANTUM) == 0U);
+    return frag;
+}
+
+/**
+ * @brief Marks a fragment which is not in the bins as free, coalesces it with its free neighbours and returns the
+ * result to the bins.
+ *
+ * @param handle pointer to the allocater handler
+ * @param frag pointer to the released fragment
+ */
+SHINYALLOCATOR_PRIVATE void fragmentRelease(shinyAllocatorInstance *const handle, Fragment *frag)
+{
+    Fragment *const prev = fragmentPrevFree(handle, frag);
+    Fragment *next = fragmentNext(handle, frag);
+    size_t size = fragmentSize(frag);
+    const PurgeRange lower = purgeKnown(prev);
+    const PurgeRange upper = purgeKnown(((next != NULL) && (!fragmentIsUsed(next))) ? next : NULL);
+
+    if (prev != NULL)
+    {
+        removeFragment(handle, prev);
+        size += fragmentSize(prev);
+        frag = prev;
+    }
+    if ((next != NULL) && (!fragmentIsUsed(next)))
+    {
+        removeFragment(handle, next);
+        size += fragmentSize(next);
+        next = fragmentNext(handle, next);
+    }
+    SHINYALLOCATOR_ASSERT((size % FRAGMENT_QUANTUM) == 0U);
+    fragmentSetSize(frag, size);
+    fragmentSetUsed(frag, false);
+    fragmentLink(handle, frag, next);
+    purgeSettle(handle, frag, lower, upper, true);
+    appendFragment(handle, frag);
+}
+
+/**
+ * @brief Turns a region of memory into a single free fragment of the pool.
+ * @details The fragment has no physical neighbours, so it is never coalesced with anything outside of the region.
+ *
+ * @param handle pointer to the allocater handler
+ * @param frag start of the fragment, its payload on a FRAGMENT_QUANTUM boundary
+ * @param capacity size of the fragment (multiple of FRAGMENT_QUANTUM), followed by the sentinel of the compact header
+ */
+SHINYALLOCATOR_PRIVATE void regionInit(shinyAllocatorInstance *const handle, Fragment *const frag, const size_t capacity)
+{
+    SHINYALLOCATOR_ASSERT((((size_t)frag) % sizeof(FragmentWord)) == 0U);
+    SHINYALLOCATOR_ASSERT(((((size_t)frag) + FRAGMENT_HEADER_SIZE) % FRAGMENT_QUANTUM) == 0U);
+    SHINYALLOCATOR_ASSERT((capacity % FRAGMENT_QUANTUM) == 0);
+    SHINYALLOCATOR_ASSERT((capacity >= FRAGMENT_SIZE_MIN) && (capacity <= FRAGMENT_SIZE_MAX));
+#if SHINYALLOCATOR_COMPACT_HEADER
+    // The used sentinel of size zero stops the traversal and the coalescing at the end of the region
+    ((Fragment *)(void *)(((char *)frag) + capacity))->header.tag = FRAGMENT_USED;
+#endif
+    fragmentInit(frag, capacity);
+    fragmentLink(handle, NULL, frag);
+    fragmentLink(handle, frag, NULL);
+    frag->nextFree = fragmentRef(handle, NULL);
+    frag->prevFree = fragmentRef(handle, NULL);
+    appendFragment(handle, frag);
+}
+
+#if SHINYALLOCATOR_QUICK_LISTS
+/**
+ * @param size fragment size
+ * @return the quick list of fragments of exactly this size, SHINYALLOCATOR_QUICK_CLASSES if there is none
+ */
+SHINYALLOCATOR_PRIVATE size_t quickClassOf(const size_t size)
+{
+#if SHINYALLOCATOR_TLSF
+    const size_t sizeClass = (size - FRAGMENT_SIZE_MIN) / FRAGMENT_QUANTUM;
+#else
+    const size_t sizeClass = ((size & (size - 1U)) == 0U) ? log2Floor(size / FRAGMENT_SIZE_MIN) : SHINYALLOCATOR_QUICK_CLASSES;
+#endif
+    return (sizeClass < SHINYALLOCATOR_QUICK_CLASSES) ? sizeClass : SHINYALLOCATOR_QUICK_CLASSES;
+}
+#endif
+
+/**
+ * @brief Coalesces every fragment of the quick lists and returns the results to the bins.
+ *
+ * @param handle pointer to the allocater handler
+ * @return true if any fragment was coalesced, so a failed allocation is worth retrying
+ */
+SHINYALLOCATOR_PRIVATE bool quickFlush(shinyAllocatorInstance *const handle)
+{
+#if SHINYALLOCATOR_QUICK_LISTS
+    if (handle->quickCount == 0U)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < SHINYALLOCATOR_QUICK_CLASSES; i++)
+    {
+        Fragment *frag = fragmentDeref(handle, handle->quick[i]);
+        handle->quick[i] = fragmentRef(handle, NULL);
+        while (frag != NULL)
+        {
+            Fragment *const next = fragmentDeref(handle, frag->nextFree);
+            fragmentRelease(handle, frag);
+            frag = next;
+        }
+    }
+    handle->quickCount = 0U;
+    return true;
+#else
+    (void)handle;
+    return false;
+#endif
+}
+
+/**
+ * @brief Takes a fragment of exactly the given size from the quick lists.
+ *
+ * @param handle pointer to the allocater handler
+ * @param size the required fragment size
+ * @return pointer to the payload or NULL if the quick list of that size is empty
+ */
+SHINYALLOCATOR_PRIVATE void *quickAllocate(shinyAllocatorInstance *const handle, const size_t size)
+{
+#if SHINYALLOCATOR_QUICK_LISTS
+    const size_t sizeClass = quickClassOf(size);
+    Fragment *const frag = (sizeClass < SHINYALLOCATOR_QUICK_CLASSES) ? fragmentDeref(handle, handle->quick[sizeClass]) : NULL;
+    if (frag == NULL)
+    {
+        return NULL;
+    }
+    SHINYALLOCATOR_ASSERT(fragmentIsUsed(frag) && (fragmentSize(frag) == size));
+    handle->quick[sizeClass] = frag->nextFree;
+    handle->quickCount--;
+    handle->diagnostics.allocated += size;
+    if (SHINYALLOCATOR_LIKELY(handle->diagnostics.peakAllocated < handle->diagnostics.allocated))
+    {
+        handle->diagnostics.peakAllocated = handle->diagnostics.allocated;
+    }
+    handle->diagnostics.splitSavedCount++;
+    return ((char *)frag) + FRAGMENT_HEADER_SIZE;
+#else
+    (void)handle;
+    (void)size;
+    return NULL;
+#endif
+}
+
+/**
+ * @brief Pushes a released fragment onto its quick list without coalescing it, the lists are coalesced in bulk once
+ * they hold more than SHINYALLOCATOR_QUICK_LIMIT fragments.
+ *
+ * @param handle pointer to the allocater handler
+ * @param frag pointer to the released fragment, still marked as used
+ * @return false if the fragment has no quick list and has to be released to the bins
+ */
+SHINYALLOCATOR_PRIVATE bool quickRelease(shinyAllocatorInstance *const handle, Fragment *const frag)
+{
+#if SHINYALLOCATOR_QUICK_LISTS
+    const size_t sizeClass = quickClassOf(fragmentSize(frag));
+    if (sizeClass == SHINYALLOCATOR_QUICK_CLASSES)
+    {
+        return false;
+    }
+    const Fragment *const next = fragmentNext(handle, frag);
+    if ((fragmentPrevFree(handle, frag) != NULL) || ((next != NULL) && !fragmentIsUsed(next)))
+    {
+        handle->diagnostics.mergeSavedCount++;
+    }
+    frag->nextFree = handle->quick[sizeClass];
+    handle->quick[sizeClass] = fragmentRef(handle, frag);
+    handle->quickCount++;
+    if (handle->quickCount > SHINYALLOCATOR_QUICK_LIMIT)
+    {
+        (void)quickFlush(handle);
+    }
+    return true;
+#else
+    (void)handle;
+    (void)frag;
+    return false;
+#endif
+}
+
+/**
+ * @param handle pointer to the allocater handler
+ * @return the capacity the pool may reach, including the reserved pages which are not committed yet
+ */
+SHINYALLOCATOR_PRIVATE size_t capacityLimit(const shinyAllocatorInstance *const handle)
+{
+#if SHINYALLOCATOR_RESERVE
+    if (handle->reserveEnd != NULL)
+    {
+        const size_t uncommitted = (size_t)(handle->reserveEnd - handle->committedEnd);
+        return (uncommitted < (FRAGMENT_SIZE_MAX - handle->diagnostics.capacity)) ? (handle->diagnostics.capacity + uncommitted)
+                                                                                  : FRAGMENT_SIZE_MAX;
+    }
+#endif
+    return handle->diagnostics.capacity;
+}
+
+#if SHINYALLOCATOR_RESERVE
+/**
+ * @return SHINYALLOCATOR_COMMIT_GRANULE rounded up to whole pages
+ */
+SHINYALLOCATOR_PRIVATE size_t reserveGranule(void)
+{
+    const size_t pageSize = hostPageSize();
+    return ((SHINYALLOCATOR_COMMIT_GRANULE + pageSize - 1U) / pageSize) * pageSize;
+}
+
+/**
+ * @brief Writes the used fragment of FRAGMENT_SIZE_MIN which closes the committed part of a reserved pool.
+ * @details The top fragment is never released by the user, so the last free fragment below it can always be found
+ * through the regular links. It is followed by the sentinel of the compact header.
+ *
+ * @param handle pointer to the allocater handler
+ * @param top start of the fragment
+ */
+SHINYALLOCATOR_PRIVATE void reserveClose(shinyAllocatorInstance *const handle, Fragment *const top)
+{
+#if SHINYALLOCATOR_COMPACT_HEADER
+    ((Fragment *)(void *)(((char *)top) + FRAGMENT_SIZE_MIN))->header.tag = FRAGMENT_USED;
+#endif
+    fragmentInit(top, FRAGMENT_SIZE_MIN);
+    fragmentSetUsed(top, true);
+    fragmentLink(handle, top, NULL);
+    handle->reserveTop = top;
+}
+#endif
+
+/**
+ * @brief Commits the pages above the top of a reserved pool and merges them into the last free fragment.
+ *
+ * @param handle pointer to the allocater handler
+ * @param size the number of bytes the pool has to grow by at least
+ * @return true if the pool has grown
+ */
+SHINYALLOCATOR_PRIVATE bool reserveGrow(shinyAllocatorInstance *const handle, const size_t size)
+{
+#if SHINYALLOCATOR_RESERVE
+    if (handle->reserveEnd == NULL)
+    {
+        return false;
+    }
+    Fragment *const top = handle->reserveTop;
+    const size_t tail = FRAGMENT_SIZE_MIN + FRAGMENT_SENTINEL_SIZE;
+    const size_t base = (size_t)handle;
+    const size_t reserved = ((size_t)handle->reserveEnd) - base;
+    const size_t offset = ((size_t)top) - base;
+    if ((size > (reserved - offset - tail)) || (size > (FRAGMENT_SIZE_MAX - handle->diagnostics.capacity)))
+    {
+        return false;
+    }
+    // The reservation starts on a page boundary, so the granules of the offsets are whole pages
+    const size_t granule = reserveGranule();
+    size_t end = ((offset + size + tail + granule - 1U) / granule) * granule;
+    if (end > reserved)
+    {
+        end = reserved;
+    }
+    size_t delta = (end - offset - tail) & ~(FRAGMENT_QUANTUM - 1U);
+    if (delta > (FRAGMENT_SIZE_MAX - handle->diagnostics.capacity))
+    {
+        delta = FRAGMENT_SIZE_MAX - handle->diagnostics.capacity;
+    }
+    SHINYALLOCATOR_ASSERT(delta >= size);
+    if ((((size_t)handle->committedEnd) < (base + end)) &&
+        (mprotect(handle->committedEnd, (base + end) - ((size_t)handle->committedEnd), PROT_READ | PROT_WRITE) != 0))
+    {
+        return false;
+    }
+    handle->committedEnd = (char *)handle + end;
+
+    // The old top becomes a used fragment spanning the new pages and is released like any other block
+    Fragment *const next = (Fragment *)(void *)(((char *)top) + delta);
+    reserveClose(handle, next);
+    fragmentSetSize(top, delta);
+    fragmentLink(handle, top, next);
+    handle->diagnostics.capacity += delta;
+    fragmentRelease(handle, top);
+    return true;
+#else
+    (void)handle;
+    (void)size;
+    return false;
+#endif
+}
+
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+/**
+ * @brief Looks up the direct mapping of a block without the lock of a thread-safe instance.
+ * @details Only the owner of a block releases or resizes it, so its own slot is stable while other slots may change.
+ *
+ * @param handle pointer to the allocater handler
+ * @param pointer pointer to the block
+ * @return the slot of the mapping, NULL if the block lies in the pool
+ */
+SHINYALLOCATOR_PRIVATE LargeMapping *largeFind(shinyAllocatorInstance *const handle, const void *const pointer)
+{
+    if ((pointer != NULL) && ((((size_t)pointer) % LARGE_PAGE_MIN) == 0U))
+    {
+        for (size_t i = 0; i < SHINYALLOCATOR_LARGE_SLOTS; i++)
+        {
+            if (__atomic_load_n(&handle->large[i].base, __ATOMIC_RELAXED) == (const char *)pointer)
+            {
+                return &handle->large[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @param amount requested size
+ * @return size of the mapping of a block of the given size, zero if it cannot be mapped
+ */
+SHINYALLOCATOR_PRIVATE size_t largeLength(const size_t amount)
+{
+    const size_t page = hostPageSize();
+    return (amount <= (SIZE_MAX - page)) ? (((amount + page - 1U) / page) * page) : 0U;
+}
+#endif
+
+/**
+ * @param handle pointer to the allocater handler
+ * @param pointer pointer to the block
+ * @return true if the block has a direct mapping of its own
+ */
+SHINYALLOCATOR_PRIVATE bool largeOwned(shinyAllocatorInstance *const handle, const void *const pointer)
+{
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+    return largeFind(handle, pointer) != NULL;
+#else
+    (void)handle;
+    (void)pointer;
+    return false;
+#endif
+}
+
+/**
+ * @brief Maps a block of its own for a request of at least SHINYALLOCATOR_LARGE_THRESHOLD bytes.
+ *
+ * @param handle pointer to the allocater handler
+ * @param amount requested size
+ * @return pointer to the block, NULL if the request is smaller, the table is full or the mapping failed
+ */
+SHINYALLOCATOR_PRIVATE void *largeAllocate(shinyAllocatorInstance *const handle, const size_t amount)
+{
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+    if (SHINYALLOCATOR_LIKELY(amount < SHINYALLOCATOR_LARGE_THRESHOLD))
+    {
+        return NULL;
+    }
+    LargeMapping *slot = NULL;
+    for (size_t i = 0; (slot == NULL) && (i < SHINYALLOCATOR_LARGE_SLOTS); i++)
+    {
+        slot = (handle->large[i].base == NULL) ? &handle->large[i] : NULL;
+    }
+    const size_t length = largeLength(amount);
+    if ((slot == NULL) || (length == 0U))
+    {
+        return NULL;
+    }
+    void *const base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+    slot->length = length;
+    __atomic_store_n(&slot->base, (char *)base, __ATOMIC_RELAXED);
+    handle->diagnostics.mapped += length;
+    return base;
+#else
+    (void)handle;
+    (void)amount;
+    return NULL;
+#endif
+}
+
+/**
+ * @brief Unmaps a block with a direct mapping of its own.
+ *
+ * @param handle pointer to the allocater handler
+ * @param pointer pointer to the block
+ * @return false if the block lies in the pool
+ */
+SHINYALLOCATOR_PRIVATE bool largeFree(shinyAllocatorInstance *const handle, void *const pointer)
+{
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+    LargeMapping *const slot = largeFind(handle, pointer);
+    if (SHINYALLOCATOR_LIKELY(slot == NULL))
+    {
+        return false;
+    }
+    SHINYALLOCATOR_ASSERT(handle->diagnostics.mapped >= slot->length);
+    handle->diagnostics.mapped -= slot->length;
+    (void)munmap(slot->base, slot->length);
+    __atomic_store_n(&slot->base, (char *)NULL, __ATOMIC_RELAXED);
+    return true;
+#else
+    (void)handle;
+    (void)pointer;
+    return false;
+#endif
+}
+
+/**
+ * @brief Resizes a block with a direct mapping of its own, blocks shrinking below SHINYALLOCATOR_LARGE_THRESHOLD
+ * move into the pool if it has room for them.
+ *
+ * @param handle pointer to the allocater handler
+ * @param pointer pointer to the block
+ * @param amount requested size, not zero
+ * @param out receives the resized block or NULL if it could not be resized
+ * @return false if the block lies in the pool
+ */
+SHINYALLOCATOR_PRIVATE bool largeReallocate(shinyAllocatorInstance *const handle, void *const pointer, const size_t amount, void **const out)
+{
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+    LargeMapping *const slot = largeFind(handle, pointer);
+    if (SHINYALLOCATOR_LIKELY(slot == NULL))
+    {
+        return false;
+    }
+    const size_t failures = handle->diagnostics.outOfMemeoryCount;
+    *out = (amount < SHINYALLOCATOR_LARGE_THRESHOLD) ? shinyAllocate(handle, amount) : NULL;
+    if (*out != NULL)
+    {
+        memcpy(*out, pointer, amount);
+        (void)largeFree(handle, pointer);
+        handle->diagnostics.reallocMovedCount++;
+        return true;
+    }
+    // A block which does not fit into the pool keeps its mapping, which is no failure
+    handle->diagnostics.outOfMemeoryCount = failures;
+
+    if (SHINYALLOCATOR_LIKELY(handle->diagnostics.peakRequestSize < amount))
+    {
+        handle->diagnostics.peakRequestSize = amount;
+    }
+    const size_t length = largeLength(amount);
+    void *const base = (length != 0U) ? mremap(slot->base, slot->length, length, MREMAP_MAYMOVE) : MAP_FAILED;
+    if (base == MAP_FAILED)
+    {
+        handle->diagnostics.outOfMemeoryCount++;
+        return true;
+    }
+    // The pages are moved by the kernel, nothing is copied even if the address changes
+    handle->diagnostics.mapped = handle->diagnostics.mapped - slot->length + length;
+    if (base == pointer)
+    {
+        handle->diagnostics.reallocInPlaceCount++;
+    }
+    else
+    {
+        handle->diagnostics.reallocMovedCount++;
+    }
+    slot->length = length;
+    __atomic_store_n(&slot->base, (char *)base, __ATOMIC_RELAXED);
+    *out = base;
+    return true;
+#else
+    (void)handle;
+    (void)pointer;
+    (void)amount;
+    (void)out;
+    return false;
+#endif
+}
+
+/**
+ * @brief Unmaps every block with a direct mapping of its own, before the pool itself is unmapped.
+ *
+ * @param handle pointer to the allocater handler
+ */
+SHINYALLOCATOR_PRIVATE void largeReleaseAll(shinyAllocatorInstance *const handle)
+{
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+    for (size_t i = 0; i < SHINYALLOCATOR_LARGE_SLOTS; i++)
+    {
+        (void)largeFree(handle, handle->large[i].base);
+    }
+#else
+    (void)handle;
+#endif
+}
+
+/**
+ * @param page pointer to the slab
+ * @return size of the objects of the slab
+ */
+SHINYALLOCATOR_PRIVATE size_t slabObjectSize(const Slab *const page)
+{
+    return (page->sizeClass + 1U) * SLAB_OBJECT_QUANTUM;
+}
+
+/**
+ * @param page pointer to the slab
+ * @return true if the slab has neither released nor never allocated objects left
+ */
+SHINYALLOCATOR_PRIVATE bool slabIsFull(const Slab *const page)
+{
+    return (page->freeList == NULL) && ((page->unused + slabObjectSize(page)) > (((const char *)page) + SLAB_PAYLOAD_SIZE));
+}
+
+/**
+ * @brief Pushes a slab to the front of a slab list.
+ *
+ * @param list pointer to the head of the list
+ * @param page pointer to the slab
+ */
+SHINYALLOCATOR_PRIVATE void slabPush(Slab **const list, Slab *const page)
+{
+    page->prev = NULL;
+    page->next = *list;
+    if (page->next != NULL)
+    {
+        page->next->prev = page;
+    }
+    *list = page;
+}
+
+/**
+ * @brief Removes a slab from a slab list.
+ *
+ * @param list pointer to the head of the list
+ * @param page pointer to the slab
+ */
+SHINYALLOCATOR_PRIVATE void slabRemove(Slab **const list, Slab *const page)
+{
+    if (page->prev != NULL)
+    {
+        page->prev->next = page->next;
+    }
+    else
+    {
+        SHINYALLOCATOR_ASSERT(*list == page);
+        *list = page->next;
+    }
+    if (page->next != NULL)
+    {
+        page->next->prev = page->prev;
+    }
+    page->next = NULL;
+    page->prev = NULL;
+}
+
+/*********************************
+ * Public interface implementation
+ **********************************/
+
+size_t sizeof_shinyAllocatorInstance(void)
+{
+    return sizeof(shinyAllocatorInstance);
+};
+/**
+ * @return bytes in front of the pool of a thread-safe instance, the instance and the per-CPU caches
+ */
+SHINYALLOCATOR_PRIVATE size_t threadSafeHeaderSize(void)
+{
+    size_t size = sizeof(shinyAllocatorThreadSafeInstance);
+#if SHINYALLOCATOR_PERCPU
+    size = ((size + SHINYALLOCATOR_CACHE_LINE - 1U) & ~((size_t)SHINYALLOCATOR_CACHE_LINE - 1U)) + (perCpuCount() * PERCPU_STRIDE);
+#endif
+    return (size + SHINYALLOCATOR_ALIGNMENT - 1U) & ~(SHINYALLOCATOR_ALIGNMENT - 1U);
+}
+
+size_t sizeof_shinyAllocatorThreadSafeInstance(void)
+{
+    return threadSafeHeaderSize();
+};
+size_t sizeof_shinyAllocatorShardedInstance(void)
+{
+    return sizeof(shinyAllocatorShardedInstance);
+};
+
+shinyAllocatorDiagnostics shinyGetDiagnostics(shinyAllocatorInstance *handle)
+{
+    shinyAllocatorDiagnostics diagnostics = {
+        .capacity = 0U,
+        .allocated = 0U,
+        .peakAllocated = 0U,
+        .peakRequestSize = 0U,
+        .outOfMemeoryCount = 0U,
+        .reallocInPlaceCount = 0U,
+        .reallocMovedCount = 0U,
+#if PENDING_FREE
+        .remoteFreeCount = 0U,
+#endif
+#if SHINYALLOCATOR_QUICK_LISTS
+        .splitSavedCount = 0U,
+        .mergeSavedCount = 0U,
+#endif
+#if SHINYALLOCATOR_PURGE
+        .purged = 0U,
+#endif
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        .mapped = 0U,
+#endif
+    };
+    if (handle)
+    {
+        diagnostics = handle->diagnostics;
+    }
+    return diagnostics;
+}
+
+shinyAllocatorInstance *shinyInit(void *const base, const size_t size)
+{
+    shinyAllocatorInstance *out = NULL;
+    // The first fragment is shifted so that every payload lands on a FRAGMENT_QUANTUM boundary
+    const size_t lead = (FRAGMENT_QUANTUM - ((((size_t)base) + INSTANCE_SIZE_PADDED + FRAGMENT_HEADER_SIZE) % FRAGMENT_QUANTUM)) % FRAGMENT_QUANTUM;
+    if ((base != NULL) && ((((size_t)base) % SHINYALLOCATOR_ALIGNMENT) == 0U) &&
+        (size >= (INSTANCE_SIZE_PADDED + lead + FRAGMENT_SIZE_MIN + FRAGMENT_SENTINEL_SIZE)))
+    {
+        SHINYALLOCATOR_ASSERT(((size_t)base) % sizeof(shinyAllocatorInstance *) == 0U);
+        out = (shinyAllocatorInstance *)base;
+        out->nonEmptyFragmentMask = 0U;
+        for (size_t i = 0; i < NUM_BINS; i++)
+        {
+            out->fragments[i] = fragmentRef(out, NULL);
+        }
+#if SHINYALLOCATOR_TLSF
+        for (size_t i = 0; i < NUM_FRAGMENTS_MAX; i++)
+        {
+            out->nonEmptySubFragmentMask[i] = 0U;
+        }
+#endif
+#if SHINYALLOCATOR_QUICK_LISTS
+        for (size_t i = 0; i < SHINYALLOCATOR_QUICK_CLASSES; i++)
+        {
+            out->quick[i] = fragmentRef(out, NULL);
+        }
+        out->quickCount = 0U;
+#endif
+#if SHINYALLOCATOR_RESERVE
+        out->reserveTop = NULL;
+        out->committedEnd = NULL;
+        out->reserveEnd = NULL;
+#endif
+#if SHINYALLOCATOR_HUGE_PAGES
+        out->hugeMapping = 0U;
+#endif
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        for (size_t i = 0; i < SHINYALLOCATOR_LARGE_SLOTS; i++)
+        {
+            out->large[i].base = NULL;
+            out->large[i].length = 0U;
+        }
+#endif
+
+        size_t capacity = size - INSTANCE_SIZE_PADDED - lead - FRAGMENT_SENTINEL_SIZE;
+        if (capacity > FRAGMENT_SIZE_MAX)
+        {
+            capacity = FRAGMENT_SIZE_MAX;
+        }
+#if SHINYALLOCATOR_OFFSET_BITS
+        // Every fragment has to stay addressable by an offset from the instance
+        const size_t addressable = FRAGMENT_OFFSET_MAX - INSTANCE_SIZE_PADDED - lead - FRAGMENT_SENTINEL_SIZE;
+        if (capacity > addressable)
+        {
+            capacity = addressable;
+        }
+#endif
+        while ((capacity % FRAGMENT_QUANTUM) != 0)
+        {
+            SHINYALLOCATOR_ASSERT(capacity > 0U);
+            capacity--;
+        }
+        SHINYALLOCATOR_ASSERT((capacity % FRAGMENT_QUANTUM) == 0);
+        SHINYALLOCATOR_ASSERT((capacity >= FRAGMENT_SIZE_MIN) && (capacity <= FRAGMENT_SIZE_MAX));
+
+        regionInit(out, (Fragment *)(void *)(((char *)base) + INSTANCE_SIZE_PADDED + lead), capacity);
+        SHINYALLOCATOR_ASSERT(out->nonEmptyFragmentMask != 0U);
+
+        out->diagnostics.capacity = capacity;
+        out->diagnostics.allocated = 0U;
+        out->diagnostics.peakAllocated = 0U;
+        out->diagnostics.peakRequestSize = 0U;
+        out->diagnostics.outOfMemeoryCount = 0U;
+        out->diagnostics.reallocInPlaceCount = 0U;
+        out->diagnostics.reallocMovedCount = 0U;
+#if PENDING_FREE
+        out->diagnostics.remoteFreeCount = 0U;
+#endif
+#if SHINYALLOCATOR_QUICK_LISTS
+        out->diagnostics.splitSavedCount = 0U;
+        out->diagnostics.mergeSavedCount = 0U;
+#endif
+#if SHINYALLOCATOR_PURGE
+        out->diagnostics.purged = 0U;
+#endif
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        out->diagnostics.mapped = 0U;
+#endif
+    }
+
+    return out;
+}
+
+SHINY_STATUS shinyDeinit(shinyAllocatorInstance *const handle)
+{
+    if (handle == NULL)
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    largeReleaseAll(handle);
+    return SHINYALLOCATOR_OK;
+}
+
+#if SHINYALLOCATOR_RESERVE
+shinyAllocatorInstance *shinyInitReserved(const size_t reserve, const size_t commit)
+{
+    const size_t granule = reserveGranule();
+#if SHINYALLOCATOR_OFFSET_BITS
+    // Every fragment has to stay addressable by an offset from the instance, the last byte needs no offset
+    const size_t addressable = (FRAGMENT_OFFSET_MAX < FRAGMENT_SIZE_MAX) ? FRAGMENT_OFFSET_MAX : (FRAGMENT_SIZE_MAX - 1U);
+    const size_t reserveMax = ((addressable / granule) * granule) + (((addressable % granule) == (granule - 1U)) ? granule : 0U);
+#else
+    const size_t reserveMax = (FRAGMENT_SIZE_MAX / granule) * granule;
+#endif
+    const size_t reserved = (reserve < reserveMax) ? (((reserve + granule - 1U) / granule) * granule) : reserveMax;
+    size_t committed = ((commit + granule - 1U) / granule) * granule;
+    if (committed < granule)
+    {
+        committed = granule;
+    }
+    if ((reserved < committed) || (committed < (INSTANCE_SIZE_PADDED + FRAGMENT_QUANTUM + (FRAGMENT_SIZE_MIN * 2U) + FRAGMENT_SENTINEL_SIZE)))
+    {
+        return NULL;
+    }
+
+    void *const base = mmap(NULL, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+    shinyAllocatorInstance *const out = (mprotect(base, committed, PROT_READ | PROT_WRITE) == 0) ? shinyInit(base, committed) : NULL;
+    if (out == NULL)
+    {
+        (void)munmap(base, reserved);
+        return NULL;
+    }
+
+    // The only fragment gives up its end to the top fragment, which is moved up as the pool grows
+    const size_t capacity = out->diagnostics.capacity - FRAGMENT_SIZE_MIN;
+    Fragment *const frag = fragmentDeref(out, out->fragments[binIndex(out->diagnostics.capacity)]);
+    SHINYALLOCATOR_ASSERT((frag != NULL) && (fragmentSize(frag) == out->diagnostics.capacity));
+    removeFragment(out, frag);
+    fragmentSetSize(frag, capacity);
+    Fragment *const top = (Fragment *)(void *)(((char *)frag) + capacity);
+    reserveClose(out, top);
+    fragmentLink(out, frag, top);
+    appendFragment(out, frag);
+    out->diagnostics.capacity = capacity;
+    out->committedEnd = ((char *)base) + committed;
+    out->reserveEnd = ((char *)base) + reserved;
+    return out;
+}
+
+SHINY_STATUS shinyDeinitReserved(shinyAllocatorInstance *const handle)
+{
+    if ((handle == NULL) || (handle->reserveEnd == NULL))
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    largeReleaseAll(handle);
+    return (munmap(handle, (size_t)(handle->reserveEnd - (char *)handle)) == 0) ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
+}
+#endif
+
+#if SHINYALLOCATOR_HUGE_PAGES
+shinyAllocatorInstance *shinyInitHuge(const size_t size)
+{
+    const size_t huge = SHINYALLOCATOR_HUGE_PAGE_SIZE;
+    if ((size == 0U) || (size > (SIZE_MAX - (huge * 2U))))
+    {
+        return NULL;
+    }
+    const size_t mapped = ((size + huge - 1U) / huge) * huge;
+    void *base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+    flags |= (int)log2Floor(huge) << MAP_HUGE_SHIFT;
+#endif
+    base = mmap(NULL, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+#endif
+    if (base == MAP_FAILED)
+    {
+        // Transparent huge pages only back aligned ranges, so one huge page more is mapped and the excess unmapped again
+        char *const raw = (char *)mmap(NULL, mapped + huge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if ((void *)raw == MAP_FAILED)
+        {
+            return NULL;
+        }
+        const size_t head = (huge - (((size_t)raw) % huge)) % huge;
+        if (head > 0U)
+        {
+            (void)munmap(raw, head);
+        }
+        (void)munmap(raw + head + mapped, huge - head);
+        base = raw + head;
+#ifdef MADV_HUGEPAGE
+        (void)madvise(base, mapped, MADV_HUGEPAGE);
+#endif
+    }
+    shinyAllocatorInstance *const out = shinyInit(base, mapped);
+    if (out == NULL)
+    {
+        (void)munmap(base, mapped);
+        return NULL;
+    }
+    out->hugeMapping = mapped;
+    return out;
+}
+
+SHINY_STATUS shinyDeinitHuge(shinyAllocatorInstance *const handle)
+{
+    if ((handle == NULL) || (handle->hugeMapping == 0U))
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    largeReleaseAll(handle);
+    return (munmap(handle, handle->hugeMapping) == 0) ? SHINYALLOCATOR_OK : SHINYALLOCATOR_ERROR;
+}
+#endif
+
+#if SHINYALLOCATOR_PURGE
+/**
+ * @brief Purges the free fragments of the bins from *bin upwards which are not purged yet.
+ *
+ * @param handle
+ * @param bin first bin to visit, set to the bin to resume from or NUM_BINS once every bin was visited
+ * @param limit maximum number of madvise() calls
+ * @return number of bytes purged
+ */
+SHINYALLOCATOR_PRIVATE size_t trimBins(shinyAllocatorInstance *const handle, size_t *const bin, size_t limit)
+{
+    size_t released = 0U;
+    // Fragments of the lower bins are smaller than a page and have no interior
+    const size_t page = hostPageSize();
+    const size_t first = (page < handle->diagnostics.capacity) ? binIndex(page) : NUM_BINS;
+    for (*bin = (*bin < first) ? first : *bin; *bin < NUM_BINS; (*bin)++)
+    {
+        for (Fragment *frag = fragmentDeref(handle, handle->fragments[*bin]); frag != NULL; frag = fragmentDeref(handle, frag->nextFree))
+        {
+            const PurgeRange interior = purgeInterior(frag, fragmentSize(frag));
+            if ((!fragmentIsPurged(frag)) && (interior.lo < interior.hi))
+            {
+                if (limit == 0U)
+                {
+                    return released;
+                }
+                limit--;
+                if (madvise((void *)interior.lo, interior.hi - interior.lo, SHINYALLOCATOR_PURGE_ADVICE) == 0)
+                {
+                    fragmentSetPurged(frag, true);
+                    handle->diagnostics.purged += interior.hi - interior.lo;
+                    released += interior.hi - interior.lo;
+                }
+            }
+        }
+    }
+    return released;
+}
+
+size_t shinyTrim(shinyAllocatorInstance *const handle)
+{
+    size_t released = 0U;
+    if (handle != NULL)
+    {
+        (void)quickFlush(handle);
+        size_t bin = 0U;
+        released = trimBins(handle, &bin, SIZE_MAX);
+    }
+    return released;
+}
+#endif
+
+SHINY_STATUS shinyAddRegion(shinyAllocatorInstance *const handle, void *const base, const size_t size)
+{
+    if ((handle == NULL) || (base == NULL))
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    const size_t lead = (FRAGMENT_QUANTUM - ((((size_t)base) + FRAGMENT_HEADER_SIZE) % FRAGMENT_QUANTUM)) % FRAGMENT_QUANTUM;
+    if (size < (lead + FRAGMENT_SIZE_MIN + FRAGMENT_SENTINEL_SIZE))
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    size_t capacity = size - lead - FRAGMENT_SENTINEL_SIZE;
+    // The sum of the regions has to stay within FRAGMENT_SIZE_MAX like a single pool
+    if (capacity > (FRAGMENT_SIZE_MAX - handle->diagnostics.capacity))
+    {
+        capacity = FRAGMENT_SIZE_MAX - handle->diagnostics.capacity;
+    }
+#if SHINYALLOCATOR_OFFSET_BITS
+    // Offsets only reach forward from the instance
+    if ((((size_t)base) < (((size_t)handle) + INSTANCE_SIZE_PADDED)) ||
+        ((((size_t)base) - ((size_t)handle)) > (FRAGMENT_OFFSET_MAX - lead - FRAGMENT_SIZE_MIN - FRAGMENT_SENTINEL_SIZE)))
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    const size_t addressable = FRAGMENT_OFFSET_MAX - (((size_t)base) - ((size_t)handle)) - lead - FRAGMENT_SENTINEL_SIZE;
+    if (capacity > addressable)
+    {
+        capacity = addressable;
+    }
+#endif
+    capacity &= ~(FRAGMENT_QUANTUM - 1U);
+    if (capacity < FRAGMENT_SIZE_MIN)
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    regionInit(handle, (Fragment *)(void *)(((char *)base) + lead), capacity);
+    handle->diagnostics.capacity += capacity;
+    return SHINYALLOCATOR_OK;
+}
+
+void *shinyAllocate(shinyAllocatorInstance *const handle, const size_t amount)
+{
+    SHINYALLOCATOR_ASSERT(handle != NULL);
+    SHINYALLOCATOR_ASSERT(handle->diagnostics.capacity <= FRAGMENT_SIZE_MAX);
+    void *out = largeAllocate(handle, amount);
+    if (SHINYALLOCATOR_LIKELY((out == NULL) && (amount > 0U) && (amount <= (capacityLimit(handle) - FRAGMENT_HEADER_SIZE))))
+    {
+        const size_t requiredSize = fragmentSizeFor(amount);
+        SHINYALLOCATOR_ASSERT(requiredSize <= FRAGMENT_SIZE_MAX);
+        SHINYALLOCATOR_ASSERT(requiredSize >= FRAGMENT_SIZE_MIN);
+        SHINYALLOCATOR_ASSERT(requiredSize >= amount + FRAGMENT_HEADER_SIZE);
+        SHINYALLOCATOR_ASSERT((requiredSize % FRAGMENT_QUANTUM) == 0U);
+
+        out = quickAllocate(handle, requiredSize);
+        Fragment *frag = (out == NULL) ? findFragment(handle, requiredSize) : NULL;
+        if ((out == NULL) && (frag == NULL) && quickFlush(handle))
+        {
+            frag = findFragment(handle, requiredSize);
+        }
+        while ((out == NULL) && (frag == NULL) && reserveGrow(handle, requiredSize))
+        {
+            frag = findFragment(handle, requiredSize);
+        }
+        if (SHINYALLOCATOR_LIKELY(frag != NULL))
+        {
+            removeFragment(handle, frag);
+            frag = hugeAlign(handle, frag, requiredSize);
+            fragmentSplit(handle, frag, requiredSize);
+            SHINYALLOCATOR_ASSERT(fragmentSize(frag) >= amount + FRAGMENT_HEADER_SIZE);
+            out = fragmentCommit(handle, frag);
+        }
+    }
+
+    updateRequestDiagnostics(handle, amount, out);
+    return out;
+}
+
+void *shinyAllocateAligned(shinyAllocatorInstance *const handle, const size_t amount, const size_t alignment, const size_t boundary)
+{
+    SHINYALLOCATOR_ASSERT(handle != NULL);
+    SHINYALLOCATOR_ASSERT(handle->diagnostics.capacity <= FRAGMENT_SIZE_MAX);
+    if (((alignment & (alignment - 1U)) != 0U) || ((boundary & (boundary - 1U)) != 0U) ||
+        ((boundary != 0U) && (amount > boundary)))
+    {
+        return NULL;
+    }
+
+    size_t effectiveAlignment = (alignment > FRAGMENT_QUANTUM) ? alignment : FRAGMENT_QUANTUM;
+    if ((boundary != 0U) && (amount >= 2U) && (roundUpToPowerOfTwo(amount) > effectiveAlignment))
+    {
+        // A block aligned to its own power-of-two size can never cross a larger power-of-two boundary
+        effectiveAlignment = roundUpToPowerOfTwo(amount);
+    }
+    if (effectiveAlignment == FRAGMENT_QUANTUM)
+    {
+        return shinyAllocate(handle, amount);
+    }
+
+    void *out = NULL;
+    const size_t limit = capacityLimit(handle);
+    if (SHINYALLOCATOR_LIKELY((amount > 0U) && (amount <= (limit - FRAGMENT_HEADER_SIZE)) && (effectiveAlignment <= limit)))
+    {
+        const size_t requiredSize = fragmentSizeFor(amount);
+        // The leading slack must be able to hold a free fragment, so it may grow by whole alignments past FRAGMENT_SIZE_MIN
+        const size_t slackMax = effectiveAlignment - FRAGMENT_QUANTUM + ((FRAGMENT_SIZE_MIN > FRAGMENT_QUANTUM) ? FRAGMENT_SIZE_MIN : 0U);
+        const size_t searchSize = requiredSize + slackMax;
+        Fragment *frag = (searchSize <= handle->diagnostics.capacity) ? findFragment(handle, searchSize) : NULL;
+        if ((frag == NULL) && (searchSize <= handle->diagnostics.capacity) && quickFlush(handle))
+        {
+            frag = findFragment(handle, searchSize);
+        }
+        while ((frag == NULL) && (searchSize <= limit) && reserveGrow(handle, searchSize))
+        {
+            frag = findFragment(handle, searchSize);
+        }
+        if (SHINYALLOCATOR_LIKELY(frag != NULL))
+        {
+            removeFragment(handle, frag);
+            const size_t lead = fragmentLead(frag, effectiveAlignment);
+            SHINYALLOCATOR_ASSERT(lead <= slackMax);
+            SHINYALLOCATOR_ASSERT(fragmentSize(frag) >= lead + requiredSize);
+            frag = fragmentSplitLead(handle, frag, lead);
+            fragmentSplit(handle, frag, requiredSize);
+            out = fragmentCommit(handle, frag);
+            SHINYALLOCATOR_ASSERT((((size_t)out) % effectiveAlignment) == 0U);
+        }
+    }
+
+    updateRequestDiagnostics(handle, amount, out);
+    return out;
+}
+
+void shinyFree(shinyAllocatorInstance *const handle, void *const pointer)
+{
+
+    SHINYALLOCATOR_ASSERT(handle != NULL);
+    SHINYALLOCATOR_ASSERT(handle->diagnostics.capacity <= FRAGMENT_SIZE_MAX);
+    if (SHINYALLOCATOR_LIKELY((pointer != NULL) && !largeFree(handle, pointer)))
+    {
+        Fragment *const frag = fragmentFromPointer(handle, pointer);
+
+        SHINYALLOCATOR_ASSERT(handle->diagnostics.allocated >= fragmentSize(frag));
+        handle->diagnostics.allocated -= fragmentSize(frag);
+        if (!quickRelease(handle, frag))
+        {
+            fragmentRelease(handle, frag);
+        }
+    }
+}
+
+void *shinyReallocate(shinyAllocatorInstance *const handle, void *const pointer, const size_t amount)
+{
+    SHINYALLOCATOR_ASSERT(handle != NULL);
+    SHINYALLOCATOR_ASSERT(handle->diagnostics.capacity <= FRAGMENT_SIZE_MAX);
+    if (pointer == NULL)
+    {
+        return shinyAllocate(handle, amount);
+    }
+    if (amount == 0U)
+    {
+        shinyFree(handle, pointer);
+        return NULL;
+    }
+
+    void *out = NULL;
+    if (largeReallocate(handle, pointer, amount, &out))
+    {
+        return out;
+    }
+    Fragment *const frag = fragmentFromPointer(handle, pointer);
+
+    if (SHINYALLOCATOR_LIKELY(handle->diagnostics.peakRequestSize < amount))
+    {
+        handle->diagnostics.peakRequestSize = amount;
+    }
+
+    // Blocks growing past SHINYALLOCATOR_LARGE_THRESHOLD leave the pool for a mapping of their own, a block which is
+    // already that large and shrinks or keeps its size stays where it is
+    const size_t usable = fragmentSize(frag) - FRAGMENT_HEADER_SIZE;
+    out = (amount > usable) ? largeAllocate(handle, amount) : NULL;
+    if (out != NULL)
+    {
+        memcpy(out, pointer, usable);
+        shinyFree(handle, pointer);
+        handle->diagnostics.reallocMovedCount++;
+        return out;
+    }
+
+    if (SHINYALLOCATOR_LIKELY(amount <= (capacityLimit(handle) - FRAGMENT_HEADER_SIZE)))
+    {
+        const size_t requiredSize = fragmentSizeFor(amount);
+        const size_t oldSize = fragmentSize(frag);
+        Fragment *next = fragmentNext(handle, frag);
+#if SHINYALLOCATOR_RESERVE
+        // A block at the top of a reserved pool grows in place into newly committed pages
+        Fragment *const above = ((next != NULL) && (!fragmentIsUsed(next))) ? fragmentNext(handle, next) : next;
+        if ((requiredSize > oldSize) && (above != NULL) && (above == handle->reserveTop) && reserveGrow(handle, requiredSize - oldSize))
+        {
+            next = fragmentNext(handle, frag);
+        }
+#endif
+        if (requiredSize <= oldSize)
+        {
+            fragmentSplit(handle, frag, requiredSize);
+            out = pointer;
+        }
+        else if ((next != NULL) && (!fragmentIsUsed(next)) && ((oldSize + fragmentSize(next)) >= requiredSize))
+        {
+            Fragment *const nextNext = fragmentNext(handle, next);
+            removeFragment(handle, next);
+            fragmentSetSize(frag, oldSize + fragmentSize(next));
+            fragmentLink(handle, frag, nextNext);
+            fragmentSplit(handle, frag, requiredSize);
+            out = pointer;
+        }
+
+        if (out != NULL)
+        {
+            SHINYALLOCATOR_ASSERT(handle->diagnostics.allocated >= oldSize);
+            handle->diagnostics.allocated = handle->diagnostics.allocated - oldSize + fragmentSize(frag);
+            SHINYALLOCATOR_ASSERT(handle->diagnostics.allocated <= handle->diagnostics.capacity);
+            if (SHINYALLOCATOR_LIKELY(handle->diagnostics.peakAllocated < handle->diagnostics.allocated))
+            {
+                handle->diagnostics.peakAllocated = handle->diagnostics.allocated;
+            }
+            handle->diagnostics.reallocInPlaceCount++;
+            return out;
+        }
+
+        out = shinyAllocate(handle, amount);
+        if (out != NULL)
+        {
+            memcpy(out, pointer, oldSize - FRAGMENT_HEADER_SIZE);
+            shinyFree(handle, pointer);
+            handle->diagnostics.reallocMovedCount++;
+        }
+    }
+    else
+    {
+        handle->diagnostics.outOfMemeoryCount++;
+    }
+
+    return out;
+}
+
+/**
+ * @brief Moves the pointer at root down the max-heap of the first count pointers until its children are not above it.
+ *
+ * @param pointers
+ * @param root
+ * @param count
+ */
+SHINYALLOCATOR_PRIVATE void batchSiftDown(void **const pointers, size_t root, const size_t count)
+{
+    void *const key = pointers[root];
+    for (size_t child = (root * 2U) + 1U; child < count; child = (root * 2U) + 1U)
+    {
+        if (((child + 1U) < count) && (((size_t)pointers[child + 1U]) > ((size_t)pointers[child])))
+        {
+            child++;
+        }
+        if (((size_t)pointers[child]) <= ((size_t)key))
+        {
+            break;
+        }
+        pointers[root] = pointers[child];
+        root = child;
+    }
+    pointers[root] = key;
+}
+
+/**
+ * @brief Sorts a batch by address in place with a heap sort, O(n log n) for any count without extra memory.
+ *
+ * @param pointers
+ * @param count
+ */
+SHINYALLOCATOR_PRIVATE void batchSort(void **const pointers, const size_t count)
+{
+    // Batches allocated in order are usually sorted already
+    size_t sorted = 1U;
+    while ((sorted < count) && (((size_t)pointers[sorted - 1U]) <= ((size_t)pointers[sorted])))
+    {
+        sorted++;
+    }
+    if (sorted >= count)
+    {
+        return;
+    }
+    for (size_t root = count / 2U; root > 0U; root--)
+    {
+        batchSiftDown(pointers, root - 1U, count);
+    }
+    for (size_t end = count - 1U; end > 0U; end--)
+    {
+        void *const top = pointers[0];
+        pointers[0] = pointers[end];
+        pointers[end] = top;
+        batchSiftDown(pointers, 0U, end);
+    }
+}
+
+SHINY_STATUS shinyAllocateBatch(shinyAllocatorInstance *const handle, const size_t amount, const size_t count, void **const out)
+{
+    SHINYALLOCATOR_ASSERT(handle != NULL);
+    SHINYALLOCATOR_ASSERT((out != NULL) || (count == 0U));
+    const size_t peakAllocated = handle->diagnostics.peakAllocated;
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = shinyAllocate(handle, amount);
+        if (out[i] == NULL)
+        {
+            shinyFreeBatch(handle, out, i);
+            for (size_t j = 0; j < i; j++)
+            {
+                out[j] = NULL;
+            }
+            // Nothing of a failed batch was handed out, so it leaves no peak behind
+            handle->diagnostics.peakAllocated = peakAllocated;
+            return SHINYALLOCATOR_ERROR;
+        }
+    }
+    return SHINYALLOCATOR_OK;
+}
+
+void shinyFreeBatch(shinyAllocatorInstance *const handle, void **const pointers, const size_t count)
+{
+    SHINYALLOCATOR_ASSERT(handle != NULL);
+    SHINYALLOCATOR_ASSERT((pointers != NULL) || (count == 0U));
+
+    // Blocks with a mapping of their own are unmapped right away and skipped like NULL entries
+    for (size_t i = 0; i < count; i++)
+    {
+        if (largeFree(handle, pointers[i]))
+        {
+            pointers[i] = NULL;
+        }
+    }
+
+    batchSort(pointers, count);
+
+    size_t i = 0;
+    while ((i < count) && (pointers[i] == NULL))
+    {
+        i++;
+    }
+    while (i < count)
+    {
+        // Physically adjacent blocks of the batch are merged before touching the bins once for the whole run
+        Fragment *const run = fragmentFromPointer(handle, pointers[i]);
+        Fragment *last = run;
+        size_t released = fragmentSize(run);
+        for (i++; (i < count) && (pointers[i] != NULL); i++)
+        {
+            Fragment *const frag = fragmentFromPointer(handle, pointers[i]);
+            if (frag != fragmentNext(handle, last))
+            {
+                break;
+            }
+            released += fragmentSize(frag);
+            last = frag;
+        }
+
+        SHINYALLOCATOR_ASSERT(handle->diagnostics.allocated >= released);
+        handle->diagnostics.allocated -= released;
+        if (last != run)
+        {
+            fragmentLink(handle, run, fragmentNext(handle, last));
+            fragmentSetSize(run, released);
+        }
+        fragmentRelease(handle, run);
+    }
+}
+
+shinySlabInstance *shinySlabInit(shinyAllocatorInstance *const handle)
+{
+    shinySlabInstance *slab = NULL;
+    if (handle != NULL)
+    {
+        slab = (shinySlabInstance *)shinyAllocate(handle, sizeof(shinySlabInstance));
+    }
+    if (slab != NULL)
+    {
+        slab->handle = handle;
+        for (size_t i = 0; i < SHINYALLOCATOR_SLAB_CLASSES; i++)
+        {
+            slab->partial[i] = NULL;
+        }
+        slab->full = NULL;
+    }
+    return slab;
+}
+
+void *shinySlabAllocate(shinySlabInstance *const slab, const size_t amount)
+{
+    SHINYALLOCATOR_ASSERT(slab != NULL);
+    if ((amount == 0U) || (amount > SLAB_OBJECT_SIZE_MAX))
+    {
+        return NULL;
+    }
+    const size_t sizeClass = (amount - 1U) / SLAB_OBJECT_QUANTUM;
+
+    Slab *page = slab->partial[sizeClass];
+    if (page == NULL)
+    {
+        page = (Slab *)shinyAllocateAligned(slab->handle, SLAB_PAYLOAD_SIZE, SHINYALLOCATOR_SLAB_SIZE, 0U);
+        if (page == NULL)
+        {
+            return NULL;
+        }
+        page->freeList = NULL;
+        page->unused = ((char *)page) + SLAB_HEADER_SIZE_PADDED;
+        page->used = 0U;
+        page->sizeClass = sizeClass;
+        slabPush(&slab->partial[sizeClass], page);
+    }
+    SHINYALLOCATOR_ASSERT(page->sizeClass == sizeClass);
+
+    void *out = page->freeList;
+    if (out != NULL)
+    {
+        page->freeList = *(void **)out;
+    }
+    else
+    {
+        // Objects are carved lazily from the tail, so a fresh slab costs O(1)
+        out = page->unused;
+        page->unused += slabObjectSize(page);
+    }
+    page->used++;
+
+    if (slabIsFull(page))
+    {
+        slabRemove(&slab->partial[sizeClass], page);
+        slabPush(&slab->full, page);
+    }
+    return out;
+}
+
+void shinySlabFree(shinySlabInstance *const slab, void *const pointer)
+{
+    SHINYALLOCATOR_ASSERT(slab != NULL);
+    if (pointer == NULL)
+    {
+        return;
+    }
+    Slab *const page = (Slab *)(void *)(((size_t)pointer) & ~((size_t)SHINYALLOCATOR_SLAB_SIZE - 1U));
+    SHINYALLOCATOR_ASSERT(page->sizeClass < SHINYALLOCATOR_SLAB_CLASSES);
+    SHINYALLOCATOR_ASSERT(page->used > 0U);
+    const size_t sizeClass = page->sizeClass;
+
+    if (slabIsFull(page))
+    {
+        slabRemove(&slab->full, page);
+        slabPush(&slab->partial[sizeClass], page);
+    }
+    *(void **)pointer = page->freeList;
+    page->freeList = pointer;
+    page->used--;
+
+    if ((page->used == 0U) && ((page->prev != NULL) || (page->next != NULL)))
+    {
+        // Empty slabs go back to the pool, except the last one of its class which is kept to avoid thrashing
+        slabRemove(&slab->partial[sizeClass], page);
+        shinyFree(slab->handle, page);
+    }
+}
+
+void shinySlabDeinit(shinySlabInstance *const slab)
+{
+    if (slab != NULL)
+    {
+        for (size_t i = 0; i < SHINYALLOCATOR_SLAB_CLASSES; i++)
+        {
+            while (slab->partial[i] != NULL)
+            {
+                Slab *const page = slab->partial[i];
+                slabRemove(&slab->partial[i], page);
+                shinyFree(slab->handle, page);
+            }
+        }
+        while (slab->full != NULL)
+        {
+            Slab *const page = slab->full;
+            slabRemove(&slab->full, page);
+            shinyFree(slab->handle, page);
+        }
+        shinyFree(slab->handle, slab);
+    }
+}
+
+#if SHINYALLOCATOR_BLOCK_POOL
+/**
+ * @brief Pops the top of the free stack of a fixed-block pool.
+ * @details Hosts swap the tagged top with a C11 or __atomic compare-and-swap, Cortex-M0 has no exclusive accesses so
+ * the interrupts are masked for the few instructions instead, which keeps the pool usable from interrupt handlers.
+ *
+ * @param pool
+ * @return index of the block plus one, zero if the stack is empty
+ */
+SHINYALLOCATOR_PRIVATE size_t blockPoolPop(shinyBlockPoolInstance *const pool)
+{
+#if defined(SHINYALLOCATOR_FREERTOS)
+    const UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    const size_t top = pool->head;
+    if (top != 0U)
+    {
+        pool->head = pool->next[top - 1U];
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    return top;
+#elif defined(__ARM_ARCH_6M__)
+    uint32_t primask;
+    __asm__ __volatile__("mrs %0, primask\n\tcpsid i" : "=r"(primask)::"memory");
+    const size_t top = pool->head;
+    if (top != 0U)
+    {
+        pool->head = pool->next[top - 1U];
+    }
+    __asm__ __volatile__("msr primask, %0" ::"r"(primask) : "memory");
+    return top;
+#else
+    size_t head = BLOCKPOOL_LOAD(&pool->head, BLOCKPOOL_ACQUIRE);
+    for (;;)
+    {
+        const size_t top = head & BLOCKPOOL_INDEX_MASK;
+        if (top == 0U)
+        {
+            return 0U;
+        }
+        const size_t tagged = ((((head >> BLOCKPOOL_INDEX_BITS) + 1U) << BLOCKPOOL_INDEX_BITS)) |
+                              BLOCKPOOL_LOAD(&pool->next[top - 1U], BLOCKPOOL_RELAXED);
+        if (BLOCKPOOL_CAS(&pool->head, &head, tagged, BLOCKPOOL_ACQUIRE, BLOCKPOOL_ACQUIRE))
+        {
+            return top;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Pushes a block onto the free stack of a fixed-block pool, see blockPoolPop().
+ *
+ * @param pool
+ * @param top index of the block plus one
+ */
+SHINYALLOCATOR_PRIVATE void blockPoolPush(shinyBlockPoolInstance *const pool, const size_t top)
+{
+#if defined(SHINYALLOCATOR_FREERTOS)
+    const UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    pool->next[top - 1U] = pool->head;
+    pool->head = top;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+#elif defined(__ARM_ARCH_6M__)
+    uint32_t primask;
+    __asm__ __volatile__("mrs %0, primask\n\tcpsid i" : "=r"(primask)::"memory");
+    pool->next[top - 1U] = pool->head;
+    pool->head = top;
+    __asm__ __volatile__("msr primask, %0" ::"r"(primask) : "memory");
+#else
+    size_t head = BLOCKPOOL_LOAD(&pool->head, BLOCKPOOL_RELAXED);
+    size_t tagged;
+    do
+    {
+        BLOCKPOOL_STORE(&pool->next[top - 1U], head & BLOCKPOOL_INDEX_MASK, BLOCKPOOL_RELAXED);
+        tagged = (((head >> BLOCKPOOL_INDEX_BITS) + 1U) << BLOCKPOOL_INDEX_BITS) | top;
+    } while (!BLOCKPOOL_CAS(&pool->head, &head, tagged, BLOCKPOOL_RELEASE, BLOCKPOOL_RELAXED));
+#endif
+}
+
+shinyBlockPoolInstance *shinyBlockPoolInit(shinyAllocatorInstance *const handle, const size_t blockSize, const size_t count)
+{
+    shinyBlockPoolInstance *pool = NULL;
+    const size_t size = (blockSize + SLAB_OBJECT_QUANTUM - 1U) & ~(SLAB_OBJECT_QUANTUM - 1U);
+    const size_t linksSize = ((count * sizeof(BlockPoolLink)) + SLAB_OBJECT_QUANTUM - 1U) & ~(SLAB_OBJECT_QUANTUM - 1U);
+    if ((handle != NULL) && (blockSize > 0U) && (count > 0U) && (count < BLOCKPOOL_INDEX_MASK) &&
+        (size >= blockSize) && (count <= ((SIZE_MAX - BLOCKPOOL_HEADER_SIZE_PADDED - linksSize) / size)))
+    {
+        pool = (shinyBlockPoolInstance *)shinyAllocate(handle, BLOCKPOOL_HEADER_SIZE_PADDED + linksSize + (count * size));
+    }
+    if (pool != NULL)
+    {
+        pool->handle = handle;
+        pool->blockSize = size;
+        pool->count = count;
+        pool->next = (BlockPoolLink *)(void *)(((char *)pool) + BLOCKPOOL_HEADER_SIZE_PADDED);
+        pool->blocks = ((char *)pool) + BLOCKPOOL_HEADER_SIZE_PADDED + linksSize;
+        // The blocks are handed out in address order
+        for (size_t i = 0; i < count; i++)
+        {
+            pool->next[i] = (i + 2U <= count) ? (i + 2U) : 0U;
+        }
+        pool->head = (size_t)1U;
+    }
+    return pool;
+}
+
+void *shinyBlockPoolAllocate(shinyBlockPoolInstance *const pool)
+{
+    SHINYALLOCATOR_ASSERT(pool != NULL);
+    const size_t top = blockPoolPop(pool);
+    return (top == 0U) ? NULL : (pool->blocks + ((top - 1U) * pool->blockSize));
+}
+
+SHINY_STATUS shinyBlockPoolFree(shinyBlockPoolInstance *const pool, void *const pointer)
+{
+    SHINYALLOCATOR_ASSERT(pool != NULL);
+    if (pointer == NULL)
+    {
+        return SHINYALLOCATOR_OK;
+    }
+    const size_t offset = ((size_t)pointer) - ((size_t)pool->blocks);
+    if ((((size_t)pointer) < ((size_t)pool->blocks)) || ((offset % pool->blockSize) != 0U) ||
+        ((offset / pool->blockSize) >= pool->count))
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    blockPoolPush(pool, (offset / pool->blockSize) + 1U);
+    return SHINYALLOCATOR_OK;
+}
+
+void shinyBlockPoolDeinit(shinyBlockPoolInstance *const pool)
+{
+    if (pool != NULL)
+    {
+        shinyFree(pool->handle, pool);
+    }
+}
+#endif // SHINYALLOCATOR_BLOCK_POOL
+
+#if SHINYALLOCATOR_MAGAZINES || SHINYALLOCATOR_PERCPU
+/**
+ * @param sizeClass
+ * @return fragment size of the blocks of the cache size class
+ */
+SHINYALLOCATOR_PRIVATE size_t cacheClassSize(const size_t sizeClass)
+{
+    return ((size_t)FRAGMENT_SIZE_MIN) << sizeClass;
+}
+
+/**
+ * @param size fragment size
+ * @param classes number of size classes of the cache
+ * @return the cache size class holding fragments of exactly that size or classes
+ */
+SHINYALLOCATOR_PRIVATE size_t cacheClassOf(const size_t size, const size_t classes)
+{
+    if ((size < FRAGMENT_SIZE_MIN) || (size > cacheClassSize(classes - 1U)) || ((size & (size - 1U)) != 0U))
+    {
+        return classes;
+    }
+    return log2Floor(size / FRAGMENT_SIZE_MIN);
+}
+#endif
+
+#if SHINYALLOCATOR_MAGAZINES
+/**
+ * @brief Returns the cached blocks and the magazine itself to the pool, the lock has to be held.
+ *
+ * @param handle pointer to the allocater handler
+ * @param mag
+ */
+SHINYALLOCATOR_PRIVATE void magazineRelease(shinyAllocatorInstance *const handle, Magazine *const mag)
+{
+    if (mag != NULL)
+    {
+        for (size_t i = 0; i < mag->rounds; i++)
+        {
+            shinyFree(handle, mag->round[i]);
+        }
+        shinyFree(handle, mag);
+    }
+}
+
+/**
+ * @brief Returns the magazines of the calling thread to the pool of their owner, the owner lock has to be held.
+ */
+SHINYALLOCATOR_PRIVATE void magazineCacheRelease(MagazineCache *const cache)
+{
+    SHINYALLOCATOR_ASSERT(cache->owner != NULL);
+    for (size_t i = 0; i < SHINYALLOCATOR_MAGAZINE_CLASSES; i++)
+    {
+        magazineRelease(cache->owner->handle, cache->loaded[i]);
+        magazineRelease(cache->owner->handle, cache->previous[i]);
+        cache->loaded[i] = NULL;
+        cache->previous[i] = NULL;
+    }
+    cache->owner = NULL;
+}
+
+/**
+ * @brief Adds an initialized instance to the magazine registry under a new generation.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void magazineRegister(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    (void)pthread_mutex_lock(&magazineRegistryLock);
+    threadSafeHandle->magazineGeneration = ++magazineGenerations;
+    threadSafeHandle->magazineNext = magazineRegistry;
+    magazineRegistry = threadSafeHandle;
+    (void)pthread_mutex_unlock(&magazineRegistryLock);
+}
+
+/**
+ * @brief Removes an instance from the magazine registry before it is deinitialized.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void magazineUnregister(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    (void)pthread_mutex_lock(&magazineRegistryLock);
+    for (shinyAllocatorThreadSafeInstance **link = &magazineRegistry; *link != NULL; link = &(*link)->magazineNext)
+    {
+        if (*link == threadSafeHandle)
+        {
+            *link = threadSafeHandle->magazineNext;
+            break;
+        }
+    }
+    threadSafeHandle->magazineGeneration = 0U;
+    (void)pthread_mutex_unlock(&magazineRegistryLock);
+}
+
+/**
+ * @brief Returns the magazines of the calling thread to their owner if it is still the instance they were bound to,
+ * otherwise they went away with the pool of the deinitialized owner and are only forgotten.
+ *
+ * @param cache
+ * @return SHINYALLOCATOR_ERROR if the owner could not be locked
+ */
+SHINYALLOCATOR_PRIVATE SHINY_STATUS magazineCacheDetach(MagazineCache *const cache)
+{
+    SHINY_STATUS status = SHINYALLOCATOR_OK;
+    // The registry lock is held until the owner is unlocked, so it cannot be deinitialized in between
+    (void)pthread_mutex_lock(&magazineRegistryLock);
+    shinyAllocatorThreadSafeInstance *live = magazineRegistry;
+    while ((live != NULL) && ((live != cache->owner) || (live->magazineGeneration != cache->generation)))
+    {
+        live = live->magazineNext;
+    }
+    if (live == NULL)
+    {
+        memset(cache, 0, sizeof(*cache));
+    }
+    else if (threadSafeLock(live) == SHINYALLOCATOR_OK)
+    {
+        magazineCacheRelease(cache);
+        threadSafeUnlock(live);
+    }
+    else
+    {
+        status = SHINYALLOCATOR_ERROR;
+    }
+    (void)pthread_mutex_unlock(&magazineRegistryLock);
+    return status;
+}
+
+/**
+ * @brief Returns every magazine of the depot to the pool, the lock has to be held.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void magazineDepotRelease(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    for (size_t i = 0; i < SHINYALLOCATOR_MAGAZINE_CLASSES; i++)
+    {
+        while (threadSafeHandle->depotFull[i] != NULL)
+        {
+            Magazine *const mag = threadSafeHandle->depotFull[i];
+            threadSafeHandle->depotFull[i] = mag->next;
+            magazineRelease(threadSafeHandle->handle, mag);
+        }
+        while (threadSafeHandle->depotEmpty[i] != NULL)
+        {
+            Magazine *const mag = threadSafeHandle->depotEmpty[i];
+            threadSafeHandle->depotEmpty[i] = mag->next;
+            magazineRelease(threadSafeHandle->handle, mag);
+        }
+        threadSafeHandle->depotFullCount[i] = 0U;
+    }
+}
+
+/**
+ * @brief pthread key destructor flushing the magazines of an exiting thread
+ *
+ * @param value the MagazineCache of the exiting thread
+ */
+static void magazineThreadExit(void *value)
+{
+    MagazineCache *const cache = (MagazineCache *)value;
+    if (cache->owner != NULL)
+    {
+        (void)magazineCacheDetach(cache);
+    }
+}
+
+static void magazineKeyCreate(void)
+{
+    (void)pthread_key_create(&magazineKey, magazineThreadExit);
+}
+
+/**
+ * @brief Binds the magazines of the calling thread to the instance, the blocks cached for another instance are
+ * returned to it first.
+ *
+ * @param threadSafeHandle
+ * @return the magazines of the calling thread
+ */
+SHINYALLOCATOR_PRIVATE MagazineCache *magazineCacheFor(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    MagazineCache *const cache = &magazineCache;
+    if (SHINYALLOCATOR_LIKELY((cache->owner == threadSafeHandle) &&
+                              (cache->generation == threadSafeHandle->magazineGeneration)))
+    {
+        return cache;
+    }
+    if ((cache->owner != NULL) && (magazineCacheDetach(cache) != SHINYALLOCATOR_OK))
+    {
+        return NULL;
+    }
+    (void)pthread_once(&magazineKeyOnce, magazineKeyCreate);
+    if (pthread_setspecific(magazineKey, cache) != 0)
+    {
+        return NULL;
+    }
+    cache->owner = threadSafeHandle;
+    cache->generation = threadSafeHandle->magazineGeneration;
+    return cache;
+}
+
+/**
+ * @brief Serves a block of the size class from the magazines of the calling thread, refilling them from the depot
+ * or the pool when they run dry.
+ *
+ * @param threadSafeHandle
+ * @param sizeClass
+ * @return the block or NULL
+ */
+SHINYALLOCATOR_PRIVATE void *magazineAllocate(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t sizeClass)
+{
+    MagazineCache *const cache = magazineCacheFor(threadSafeHandle);
+    if (cache == NULL)
+    {
+        return NULL;
+    }
+    Magazine *mag = cache->loaded[sizeClass];
+    if ((mag == NULL) || (mag->rounds == 0U))
+    {
+        Magazine *const previous = cache->previous[sizeClass];
+        if ((previous != NULL) && (previous->rounds > 0U))
+        {
+            cache->previous[sizeClass] = mag;
+            cache->loaded[sizeClass] = previous;
+        }
+        else
+        {
+            if (threadSafeLock(threadSafeHandle) != SHINYALLOCATOR_OK)
+            {
+                return NULL;
+            }
+            Magazine *const full = threadSafeHandle->depotFull[sizeClass];
+            if (full == NULL)
+            {
+                // A miss allocates the whole class size, so the block can be cached once it is freed
+                void *const out = shinyAllocate(threadSafeHandle->handle, cacheClassSize(sizeClass) - FRAGMENT_HEADER_SIZE);
+                threadSafeUnlock(threadSafeHandle);
+                return out;
+            }
+            threadSafeHandle->depotFull[sizeClass] = full->next;
+            threadSafeHandle->depotFullCount[sizeClass]--;
+            if (previous != NULL)
+            {
+                previous->next = threadSafeHandle->depotEmpty[sizeClass];
+                threadSafeHandle->depotEmpty[sizeClass] = previous;
+            }
+            threadSafeUnlock(threadSafeHandle);
+            cache->previous[sizeClass] = mag;
+            cache->loaded[sizeClass] = full;
+        }
+        mag = cache->loaded[sizeClass];
+    }
+    SHINYALLOCATOR_ASSERT(mag->rounds > 0U);
+    mag->rounds--;
+    return mag->round[mag->rounds];
+}
+
+/**
+ * @brief Caches a freed block in the magazines of the calling thread, exchanging a full magazine for an empty one
+ * with the depot when they are full.
+ *
+ * @param threadSafeHandle
+ * @param sizeClass
+ * @param pointer
+ * @return SHINYALLOCATOR_OK if the block was cached or released
+ */
+SHINYALLOCATOR_PRIVATE SHINY_STATUS magazineFree(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t sizeClass,
+                                                void *const pointer)
+{
+    MagazineCache *const cache = magazineCacheFor(threadSafeHandle);
+    if (cache == NULL)
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    Magazine *mag = cache->loaded[sizeClass];
+    if ((mag == NULL) || (mag->rounds == SHINYALLOCATOR_MAGAZINE_SIZE))
+    {
+        Magazine *const previous = cache->previous[sizeClass];
+        if ((previous != NULL) && (previous->rounds < SHINYALLOCATOR_MAGAZINE_SIZE))
+        {
+            cache->previous[sizeClass] = mag;
+            cache->loaded[sizeClass] = previous;
+        }
+        else
+        {
+            if (threadSafeLock(threadSafeHandle) != SHINYALLOCATOR_OK)
+            {
+                return SHINYALLOCATOR_ERROR;
+            }
+            Magazine *empty = threadSafeHandle->depotEmpty[sizeClass];
+            if (empty != NULL)
+            {
+                threadSafeHandle->depotEmpty[sizeClass] = empty->next;
+            }
+            else
+            {
+                empty = (Magazine *)shinyAllocate(threadSafeHandle->handle, sizeof(Magazine));
+            }
+            if (empty == NULL)
+            {
+                shinyFree(threadSafeHandle->handle, pointer);
+                threadSafeUnlock(threadSafeHandle);
+                return SHINYALLOCATOR_OK;
+            }
+            empty->rounds = 0U;
+            if (previous != NULL)
+            {
+                if (threadSafeHandle->depotFullCount[sizeClass] < SHINYALLOCATOR_DEPOT_MAX)
+                {
+                    previous->next = threadSafeHandle->depotFull[sizeClass];
+                    threadSafeHandle->depotFull[sizeClass] = previous;
+                    threadSafeHandle->depotFullCount[sizeClass]++;
+                }
+                else
+                {
+                    magazineRelease(threadSafeHandle->handle, previous);
+                }
+            }
+            threadSafeUnlock(threadSafeHandle);
+            cache->previous[sizeClass] = mag;
+            cache->loaded[sizeClass] = empty;
+        }
+        mag = cache->loaded[sizeClass];
+    }
+    SHINYALLOCATOR_ASSERT(mag->rounds < SHINYALLOCATOR_MAGAZINE_SIZE);
+    mag->round[mag->rounds] = pointer;
+    mag->rounds++;
+    return SHINYALLOCATOR_OK;
+}
+#endif
+
+/**
+ * @brief Releases the pending free list in bulk, the lock has to be held.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void remoteFreeDrain(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+#if PENDING_FREE
+    if (SHINYALLOCATOR_LIKELY(__atomic_load_n(&threadSafeHandle->pendingFree, __ATOMIC_RELAXED) == NULL))
+    {
+        return;
+    }
+    void *list = __atomic_exchange_n(&threadSafeHandle->pendingFree, NULL, __ATOMIC_ACQUIRE);
+    void *batch[SHINYALLOCATOR_REMOTE_FREE_BATCH];
+    size_t count = 0U;
+    while (list != NULL)
+    {
+        batch[count] = list;
+        count++;
+        list = *(void **)list;
+        if ((count == SHINYALLOCATOR_REMOTE_FREE_BATCH) || (list == NULL))
+        {
+            // Sorting and merging the neighbours of the batch coalesces the list in bulk
+            shinyFreeBatch(threadSafeHandle->handle, batch, count);
+            threadSafeHandle->handle->diagnostics.remoteFreeCount += count;
+            count = 0U;
+        }
+    }
+#else
+    (void)threadSafeHandle;
+#endif
+}
+
+#if PENDING_FREE
+/**
+ * @brief Pushes a block onto the pending free list without taking the lock.
+ *
+ * @param threadSafeHandle
+ * @param pointer block to be released or NULL
+ */
+SHINYALLOCATOR_PRIVATE void remoteFreePush(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const pointer)
+{
+    if (pointer != NULL)
+    {
+        void *head = __atomic_load_n(&threadSafeHandle->pendingFree, __ATOMIC_RELAXED);
+        do
+        {
+            *(void **)pointer = head;
+        } while (!__atomic_compare_exchange_n(&threadSafeHandle->pendingFree, &head, pointer, true, __ATOMIC_RELEASE,
+                                              __ATOMIC_RELAXED));
+    }
+}
+#endif
+
+#ifdef SHINYALLOCATOR_FREERTOS
+/**
+ * @brief Returns the blocks released from interrupts to the pool and tops up the interrupt reserve, the lock has to
+ * be held.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void isrReserveService(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    // Word sized reads cannot tear, a stale value only delays the service to the next call
+    if (SHINYALLOCATOR_LIKELY((threadSafeHandle->isrPendingFree == NULL) &&
+                              (threadSafeHandle->isrReserveCount == SHINYALLOCATOR_ISR_RESERVE)))
+    {
+        return;
+    }
+    taskENTER_CRITICAL();
+    void *list = threadSafeHandle->isrPendingFree;
+    threadSafeHandle->isrPendingFree = NULL;
+    // Interrupts only take from the reserve, so at most this many blocks are missing
+    const size_t missing = SHINYALLOCATOR_ISR_RESERVE - threadSafeHandle->isrReserveCount;
+    taskEXIT_CRITICAL();
+    while (list != NULL)
+    {
+        void *const next = *(void **)list;
+        shinyFree(threadSafeHandle->handle, list);
+        list = next;
+    }
+    for (size_t i = 0; i < missing; i++)
+    {
+        void *const block = shinyAllocate(threadSafeHandle->handle, SHINYALLOCATOR_ISR_BLOCK_SIZE);
+        if (block == NULL)
+        {
+            break;
+        }
+        taskENTER_CRITICAL();
+        *(void **)block = threadSafeHandle->isrReserve;
+        threadSafeHandle->isrReserve = block;
+        threadSafeHandle->isrReserveCount++;
+        taskEXIT_CRITICAL();
+    }
+}
+
+/**
+ * @brief Returns the interrupt reserve and the blocks released from interrupts to the pool, the lock has to be held.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void isrReserveRelease(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    taskENTER_CRITICAL();
+    void *list[2] = {threadSafeHandle->isrReserve, threadSafeHandle->isrPendingFree};
+    threadSafeHandle->isrReserve = NULL;
+    threadSafeHandle->isrReserveCount = 0U;
+    threadSafeHandle->isrPendingFree = NULL;
+    taskEXIT_CRITICAL();
+    for (size_t i = 0; i < 2U; i++)
+    {
+        while (list[i] != NULL)
+        {
+            void *const next = *(void **)list[i];
+            shinyFree(threadSafeHandle->handle, list[i]);
+            list[i] = next;
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Performs the work deferred to the next holder of the lock, the lock has to be held.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void threadSafeService(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+#if SHINYALLOCATOR_MAINTENANCE
+    // The queue belongs to the maintenance thread while it runs, stragglers queued around its stop are released here
+    if (__atomic_load_n(&threadSafeHandle->maintenanceRunning, __ATOMIC_RELAXED) != 0U)
+    {
+        return;
+    }
+#endif
+    remoteFreeDrain(threadSafeHandle);
+#ifdef SHINYALLOCATOR_FREERTOS
+    isrReserveService(threadSafeHandle);
+#endif
+}
+
+/**
+ * @brief Releases every block queued for the maintenance thread, the lock has to be held.
+ *
+ * @param threadSafeHandle
+ * @return true if any block was released, so a failed allocation is worth retrying
+ */
+SHINYALLOCATOR_PRIVATE bool maintenanceReclaim(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+#if SHINYALLOCATOR_MAINTENANCE
+    const size_t released = threadSafeHandle->handle->diagnostics.remoteFreeCount;
+    void *backlog = threadSafeHandle->maintenanceBacklog;
+    threadSafeHandle->maintenanceBacklog = NULL;
+    while (backlog != NULL)
+    {
+        void *const next = *(void **)backlog;
+        shinyFree(threadSafeHandle->handle, backlog);
+        threadSafeHandle->handle->diagnostics.remoteFreeCount++;
+        backlog = next;
+    }
+    remoteFreeDrain(threadSafeHandle);
+    return threadSafeHandle->handle->diagnostics.remoteFreeCount != released;
+#else
+    (void)threadSafeHandle;
+    return false;
+#endif
+}
+
+#if SHINYALLOCATOR_MAINTENANCE
+/**
+ * @return monotonic time in nanoseconds
+ */
+SHINYALLOCATOR_PRIVATE uint64_t maintenanceClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000U) + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Returns the free pages of an idle pool to the OS, SHINYALLOCATOR_TRIM_STEP fragments per lock acquisition
+ * until the sweep is done or the budget is spent, the next call resumes an unfinished sweep.
+ *
+ * @param threadSafeHandle
+ * @param start monotonic time the run of the period started at
+ */
+SHINYALLOCATOR_PRIVATE void maintenanceTrim(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const uint64_t start)
+{
+#if SHINYALLOCATOR_PURGE
+    bool done = false;
+    do
+    {
+        if (threadSafeLock(threadSafeHandle) != SHINYALLOCATOR_OK)
+        {
+            return;
+        }
+        if (threadSafeHandle->maintenanceTrimBin == 0U)
+        {
+            // A new sweep also covers the fragments held back by the quick lists
+            (void)quickFlush(threadSafeHandle->handle);
+        }
+        (void)trimBins(threadSafeHandle->handle, &threadSafeHandle->maintenanceTrimBin, SHINYALLOCATOR_TRIM_STEP);
+        done = threadSafeHandle->maintenanceTrimBin >= NUM_BINS;
+        if (done)
+        {
+            threadSafeHandle->maintenanceTrimBin = 0U;
+        }
+        threadSafeUnlock(threadSafeHandle);
+    } while (!done && ((maintenanceClock() - start) < threadSafeHandle->maintenanceBudget));
+#else
+    (void)threadSafeHandle;
+    (void)start;
+#endif
+}
+
+/**
+ * @brief Releases queued blocks one batch per lock acquisition until the queue is empty or the budget is spent.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void maintenanceRun(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    const uint64_t start = maintenanceClock();
+    for (size_t round = 0U;; round++)
+    {
+        if (threadSafeLock(threadSafeHandle) != SHINYALLOCATOR_OK)
+        {
+            return;
+        }
+        if (threadSafeHandle->maintenanceBacklog == NULL)
+        {
+            threadSafeHandle->maintenanceBacklog = __atomic_exchange_n(&threadSafeHandle->pendingFree, NULL, __ATOMIC_ACQUIRE);
+        }
+        void *batch[SHINYALLOCATOR_REMOTE_FREE_BATCH];
+        size_t count = 0U;
+        while ((threadSafeHandle->maintenanceBacklog != NULL) && (count < SHINYALLOCATOR_REMOTE_FREE_BATCH))
+        {
+            batch[count] = threadSafeHandle->maintenanceBacklog;
+            threadSafeHandle->maintenanceBacklog = *(void **)batch[count];
+            count++;
+        }
+        if (count > 0U)
+        {
+            // Sorting and merging the neighbours of the batch coalesces the queue in bulk
+            shinyFreeBatch(threadSafeHandle->handle, batch, count);
+            threadSafeHandle->handle->diagnostics.remoteFreeCount += count;
+        }
+#if SHINYALLOCATOR_MAGAZINES
+        else if (round == 0U)
+        {
+            // Nothing was released for a whole period, the spare magazines go back to the pool
+            magazineDepotRelease(threadSafeHandle);
+        }
+#endif
+        threadSafeUnlock(threadSafeHandle);
+        if ((count == 0U) && (round == 0U))
+        {
+            maintenanceTrim(threadSafeHandle, start);
+        }
+        if ((count == 0U) || ((maintenanceClock() - start) >= threadSafeHandle->maintenanceBudget))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Body of the maintenance thread, sleeps for a period between two runs until it is stopped.
+ *
+ * @param argument the thread-safe instance
+ */
+static void *maintenanceMain(void *argument)
+{
+    shinyAllocatorThreadSafeInstance *const threadSafeHandle = (shinyAllocatorThreadSafeInstance *)argument;
+    pthread_mutex_lock(&threadSafeHandle->maintenanceMutex);
+    while (__atomic_load_n(&threadSafeHandle->maintenanceRunning, __ATOMIC_RELAXED) != 0U)
+    {
+        const uint64_t wakeUp = maintenanceClock() + threadSafeHandle->maintenancePeriod;
+        struct timespec deadline;
+        deadline.tv_sec = (time_t)(wakeUp / 1000000000U);
+        deadline.tv_nsec = (long)(wakeUp % 1000000000U);
+        (void)pthread_cond_timedwait(&threadSafeHandle->maintenanceWake, &threadSafeHandle->maintenanceMutex, &deadline);
+        if (__atomic_load_n(&threadSafeHandle->maintenanceRunning, __ATOMIC_RELAXED) == 0U)
+        {
+            break;
+        }
+        pthread_mutex_unlock(&threadSafeHandle->maintenanceMutex);
+        maintenanceRun(threadSafeHandle);
+        pthread_mutex_lock(&threadSafeHandle->maintenanceMutex);
+    }
+    pthread_mutex_unlock(&threadSafeHandle->maintenanceMutex);
+    return NULL;
+}
+#endif
+
+/**
+ * @return a hash of the identity of the calling thread, used to spread threads over shards and request slots
+ */
+SHINYALLOCATOR_PRIVATE size_t threadHint(void)
+{
+#ifdef SHINYALLOCATOR_FREERTOS
+    const size_t key = (size_t)xTaskGetCurrentTaskHandle();
+#else
+    static SHINYALLOCATOR_THREAD_LOCAL char anchor;
+    const size_t key = (size_t)&anchor;
+#endif
+    return (key >> 4U) ^ (key >> 12U);
+}
+
+#if SHINYALLOCATOR_FINE_LOCKING
+/**
+ * @brief Tries to take a lock byte of the fine-grained engine.
+ *
+ * @param lock
+ * @return true if the lock was taken
+ */
+SHINYALLOCATOR_PRIVATE bool fineTryLock(uint8_t *const lock)
+{
+    return (__atomic_load_n(lock, __ATOMIC_RELAXED) == 0U) && (__atomic_exchange_n(lock, (uint8_t)1U, __ATOMIC_ACQUIRE) == 0U);
+}
+
+/**
+ * @brief Spins on a lock byte of the fine-grained engine until it is taken.
+ *
+ * @param lock
+ */
+SHINYALLOCATOR_PRIVATE void fineLock(uint8_t *const lock)
+{
+    uint_fast32_t retry = 0U;
+    while (!fineTryLock(lock))
+    {
+        spinWait(&retry);
+    }
+}
+
+/**
+ * @param lock
+ */
+SHINYALLOCATOR_PRIVATE void fineUnlock(uint8_t *const lock)
+{
+    __atomic_store_n(lock, (uint8_t)0U, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Enters the fine-grained engine, waits while the holder of the mutex keeps the requests out.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void fineEnter(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    uint_fast32_t retry = 0U;
+    unsigned int users = __atomic_load_n(&threadSafeHandle->fineUsers, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        if ((users & FINE_EXCLUSIVE) == 0U)
+        {
+            if (__atomic_compare_exchange_n(&threadSafeHandle->fineUsers, &users, users + 1U, true, __ATOMIC_ACQUIRE,
+                                            __ATOMIC_RELAXED))
+            {
+                return;
+            }
+        }
+        else
+        {
+            spinWait(&retry);
+            users = __atomic_load_n(&threadSafeHandle->fineUsers, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void fineExit(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    __atomic_fetch_sub(&threadSafeHandle->fineUsers, 1U, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Raises a peak counter shared by the requests of the engine.
+ *
+ * @param peak
+ * @param value
+ */
+SHINYALLOCATOR_PRIVATE void fineRaise(size_t *const peak, const size_t value)
+{
+    size_t current = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while ((current < value) && !__atomic_compare_exchange_n(peak, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+/**
+ * @brief Ends a request counted in fineDetached once its fragments are back in the bins.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void fineReattach(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    __atomic_fetch_add(&threadSafeHandle->fineReturned, 1U, __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&threadSafeHandle->fineDetached, 1U, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Appends a locked free fragment to its bin.
+ *
+ * @param threadSafeHandle
+ * @param frag
+ */
+SHINYALLOCATOR_PRIVATE void fineAppend(shinyAllocatorThreadSafeInstance *const threadSafeHandle, Fragment *const frag)
+{
+    uint8_t *const lock = &threadSafeHandle->binLock[binIndex(fragmentSize(frag))];
+    fineLock(lock);
+    appendFragment(threadSafeHandle->handle, frag);
+    fineUnlock(lock);
+}
+
+/**
+ * @brief Removes a locked free fragment from its bin.
+ *
+ * @param threadSafeHandle
+ * @param frag
+ */
+SHINYALLOCATOR_PRIVATE void fineRemove(shinyAllocatorThreadSafeInstance *const threadSafeHandle, Fragment *const frag)
+{
+    uint8_t *const lock = &threadSafeHandle->binLock[binIndex(fragmentSize(frag))];
+    fineLock(lock);
+    removeFragment(threadSafeHandle->handle, frag);
+    fineUnlock(lock);
+}
+
+/**
+ * @brief Takes a fragment of at least the given size out of the bins, it is returned locked.
+ * @details A fragment locked by another request is skipped, the bins are scanned again when only such fragments or
+ * fragments on their way back to the bins could serve the request. A fragment which went back to a bin while it was
+ * scanned may have been missed as well, so the scan is also repeated when any request returned its fragments
+ * meanwhile.
+ *
+ * @param threadSafeHandle
+ * @param size the required fragment size (multiple of FRAGMENT_QUANTUM)
+ * @return the fragment or NULL if the pool has no fragment large enough
+ */
+SHINYALLOCATOR_PRIVATE Fragment *fineFind(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t size)
+{
+    shinyAllocatorInstance *const handle = threadSafeHandle->handle;
+    const uint_fast8_t optimalFragmentIndex = log2Ceil((size + FRAGMENT_SIZE_MIN - 1U) / FRAGMENT_SIZE_MIN);
+    SHINYALLOCATOR_ASSERT(optimalFragmentIndex < NUM_FRAGMENTS_MAX);
+    uint_fast32_t retry = 0U;
+    for (;;)
+    {
+        const unsigned int returned = __atomic_load_n(&threadSafeHandle->fineReturned, __ATOMIC_ACQUIRE);
+        bool contended = false;
+        size_t suitableFragments = __atomic_load_n(&handle->nonEmptyFragmentMask, __ATOMIC_RELAXED) & ~(pow2(optimalFragmentIndex) - 1U);
+        while (suitableFragments != 0U)
+        {
+            const size_t index = log2Floor(suitableFragments & ~(suitableFragments - 1U));
+            suitableFragments &= suitableFragments - 1U;
+            fineLock(&threadSafeHandle->binLock[index]);
+            for (Fragment *frag = fragmentDeref(handle, handle->fragments[index]); frag != NULL;
+                 frag = fragmentDeref(handle, frag->nextFree))
+            {
+                if (fineTryLock(&frag->header.locked))
+                {
+                    SHINYALLOCATOR_ASSERT(!fragmentIsUsed(frag));
+                    SHINYALLOCATOR_ASSERT(fragmentSize(frag) >= size);
+                    __atomic_fetch_add(&threadSafeHandle->fineDetached, 1U, __ATOMIC_RELAXED);
+                    removeFragment(handle, frag);
+                    fineUnlock(&threadSafeHandle->binLock[index]);
+                    return frag;
+                }
+                contended = true;
+            }
+            fineUnlock(&threadSafeHandle->binLock[index]);
+        }
+        if (!contended && (__atomic_load_n(&threadSafeHandle->fineDetached, __ATOMIC_ACQUIRE) == 0U) &&
+            (__atomic_load_n(&threadSafeHandle->fineReturned, __ATOMIC_ACQUIRE) == returned))
+        {
+            return NULL;
+        }
+        spinWait(&retry);
+    }
+}
+
+/**
+ * @brief Shrinks a locked fragment taken out of the bins and returns the tail to the bins, like fragmentSplit().
+ * @details The right neighbour and, when the tail absorbs it, its right neighbour are locked first. Waiting for
+ * them is safe as fragment locks are only waited for from left to right.
+ *
+ * @param threadSafeHandle
+ * @param frag
+ * @param size the new size of the fragment (multiple of FRAGMENT_QUANTUM)
+ */
+SHINYALLOCATOR_PRIVATE void fineSplit(shinyAllocatorThreadSafeInstance *const threadSafeHandle, Fragment *const frag, const size_t size)
+{
+    shinyAllocatorInstance *const handle = threadSafeHandle->handle;
+    const size_t leftover = fragmentSize(frag) - size;
+    if (SHINYALLOCATOR_LIKELY(leftover >= FRAGMENT_SIZE_MIN))
+    {
+        Fragment *const next = fragmentNext(handle, frag);
+        Fragment *nextNext = NULL;
+        bool absorb = false;
+        if (next != NULL)
+        {
+            fineLock(&next->header.locked);
+            absorb = !fragmentIsUsed(next);
+            nextNext = absorb ? fragmentNext(handle, next) : NULL;
+            if (nextNext != NULL)
+            {
+                fineLock(&nextNext->header.locked);
+            }
+        }
+        Fragment *const newFrag = (Fragment *)(void *)(((char *)frag) + size);
+        fragmentInit(newFrag, leftover);
+        newFrag->header.locked = 1U;
+        if (absorb)
+        {
+            fineRemove(threadSafeHandle, next);
+            fragmentSetSize(newFrag, leftover + fragmentSize(next));
+        }
+        fragmentSetSize(frag, size);
+        fragmentLink(handle, frag, newFrag);
+        fragmentLink(handle, newFrag, absorb ? nextNext : next);
+        fineAppend(threadSafeHandle, newFrag);
+        fineUnlock(&newFrag->header.locked);
+        if (nextNext != NULL)
+        {
+            fineUnlock(&nextNext->header.locked);
+        }
+        if ((next != NULL) && !absorb)
+        {
+            fineUnlock(&next->header.locked);
+        }
+    }
+}
+
+/**
+ * @brief Allocates a block without the mutex.
+ *
+ * @param threadSafeHandle
+ * @param amount
+ * @return the block or NULL
+ */
+SHINYALLOCATOR_PRIVATE void *fineAllocate(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount)
+{
+    shinyAllocatorInstance *const handle = threadSafeHandle->handle;
+    void *out = NULL;
+    fineEnter(threadSafeHandle);
+    if (SHINYALLOCATOR_LIKELY((amount > 0U) && (amount <= (handle->diagnostics.capacity - FRAGMENT_HEADER_SIZE))))
+    {
+        const size_t requiredSize = fragmentSizeFor(amount);
+        Fragment *const frag = fineFind(threadSafeHandle, requiredSize);
+        if (SHINYALLOCATOR_LIKELY(frag != NULL))
+        {
+            fineSplit(threadSafeHandle, frag, requiredSize);
+            fineReattach(threadSafeHandle);
+            fineRaise(&handle->diagnostics.peakAllocated,
+                      __atomic_add_fetch(&handle->diagnostics.allocated, fragmentSize(frag), __ATOMIC_RELAXED));
+            fragmentSetUsed(frag, true);
+            fineUnlock(&frag->header.locked);
+            out = ((char *)frag) + FRAGMENT_HEADER_SIZE;
+        }
+    }
+    fineRaise(&handle->diagnostics.peakRequestSize, amount);
+    if ((out == NULL) && (amount > 0U))
+    {
+        __atomic_fetch_add(&handle->diagnostics.outOfMemeoryCount, 1U, __ATOMIC_RELAXED);
+    }
+    fineExit(threadSafeHandle);
+    return out;
+}
+
+/**
+ * @brief Releases a block without the mutex, like fragmentRelease().
+ * @details The fragment and its right neighbours are waited for from left to right, while the left neighbour may be
+ * waiting for this fragment itself, so it is only tried and a busy one is not merged.
+ *
+ * @param threadSafeHandle
+ * @param pointer
+ */
+SHINYALLOCATOR_PRIVATE void fineFree(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const pointer)
+{
+    shinyAllocatorInstance *const handle = threadSafeHandle->handle;
+    Fragment *const frag = fragmentFromPointer(handle, pointer);
+    fineEnter(threadSafeHandle);
+    fineLock(&frag->header.locked);
+    size_t size = fragmentSize(frag);
+    __atomic_fetch_sub(&handle->diagnostics.allocated, size, __ATOMIC_RELAXED);
+
+    Fragment *prev = fragmentDeref(handle, frag->header.prev);
+    if ((prev != NULL) && !fineTryLock(&prev->header.locked))
+    {
+        prev = NULL;
+    }
+    Fragment *const next = fragmentNext(handle, frag);
+    Fragment *nextNext = NULL;
+    bool mergeNext = false;
+    if (next != NULL)
+    {
+        fineLock(&next->header.locked);
+        mergeNext = !fragmentIsUsed(next);
+        nextNext = mergeNext ? fragmentNext(handle, next) : NULL;
+        if (nextNext != NULL)
+        {
+            fineLock(&nextNext->header.locked);
+        }
+    }
+    const bool mergePrev = (prev != NULL) && !fragmentIsUsed(prev);
+
+    if (mergeNext || mergePrev)
+    {
+        __atomic_fetch_add(&threadSafeHandle->fineDetached, 1U, __ATOMIC_RELAXED);
+    }
+    Fragment *released = frag;
+    if (mergeNext)
+    {
+        fineRemove(threadSafeHandle, next);
+        size += fragmentSize(next);
+    }
+    if (mergePrev)
+    {
+        fineRemove(threadSafeHandle, prev);
+        size += fragmentSize(prev);
+        released = prev;
+    }
+    fragmentSetSize(released, size);
+    fragmentSetUsed(released, false);
+    fragmentLink(handle, released, mergeNext ? nextNext : next);
+    fineAppend(threadSafeHandle, released);
+    if (mergeNext || mergePrev)
+    {
+        fineReattach(threadSafeHandle);
+    }
+
+    // The headers merged into another fragment are payload now
+    if (nextNext != NULL)
+    {
+        fineUnlock(&nextNext->header.locked);
+    }
+    if ((next != NULL) && !mergeNext)
+    {
+        fineUnlock(&next->header.locked);
+    }
+    if (!mergePrev)
+    {
+        fineUnlock(&frag->header.locked);
+    }
+    if (prev != NULL)
+    {
+        fineUnlock(&prev->header.locked);
+    }
+    fineExit(threadSafeHandle);
+}
+
+/**
+ * @brief Merges the neighbouring free fragments whose merge was skipped by a busy lock, the lock has to be held.
+ *
+ * @param handle
+ */
+SHINYALLOCATOR_PRIVATE void fineCoalesce(shinyAllocatorInstance *const handle)
+{
+    // The bins reach the free fragments of every region, a merged fragment moves to a larger bin
+    for (size_t i = 0; i < NUM_BINS; i++)
+    {
+        Fragment *frag = fragmentDeref(handle, handle->fragments[i]);
+        while (frag != NULL)
+        {
+            Fragment *const next = fragmentNext(handle, frag);
+            if ((next != NULL) && !fragmentIsUsed(next))
+            {
+                removeFragment(handle, frag);
+                removeFragment(handle, next);
+                fragmentSetSize(frag, fragmentSize(frag) + fragmentSize(next));
+                fragmentLink(handle, frag, fragmentNext(handle, next));
+                appendFragment(handle, frag);
+                frag = fragmentDeref(handle, handle->fragments[i]);
+            }
+            else
+            {
+                frag = fragmentDeref(handle, frag->nextFree);
+            }
+        }
+    }
+}
+#endif
+
+#if SHINYALLOCATOR_EPOCH
+/**
+ * @brief Claims a free reader slot, starting at a slot derived from the calling thread.
+ *
+ * @param threadSafeHandle
+ * @return the slot in the EPOCH_BUSY state or NULL if every slot is claimed
+ */
+SHINYALLOCATOR_PRIVATE EpochSlot *epochClaim(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    const size_t start = threadHint();
+    for (size_t i = 0; i < SHINYALLOCATOR_EPOCH_SLOTS; i++)
+    {
+        EpochSlot *const slot = &threadSafeHandle->epochSlot[(start + i) % SHINYALLOCATOR_EPOCH_SLOTS];
+        unsigned int expected = EPOCH_FREE;
+        if ((__atomic_load_n(&slot->state, __ATOMIC_RELAXED) == EPOCH_FREE) &&
+            __atomic_compare_exchange_n(&slot->state, &expected, EPOCH_BUSY, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Advances the global epoch unless a reader still announces an older one.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void epochAdvance(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    unsigned int epoch = __atomic_load_n(&threadSafeHandle->epoch, __ATOMIC_SEQ_CST);
+    for (size_t i = 0; i < SHINYALLOCATOR_EPOCH_SLOTS; i++)
+    {
+        const unsigned int state = __atomic_load_n(&threadSafeHandle->epochSlot[i].state, __ATOMIC_SEQ_CST);
+        if (((state & EPOCH_READER) != 0U) && ((state >> EPOCH_SHIFT) != (epoch & (UINT_MAX >> EPOCH_SHIFT))))
+        {
+            return;
+        }
+    }
+    (void)__atomic_compare_exchange_n(&threadSafeHandle->epoch, &epoch, epoch + 1U, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Releases the limbo entries whose grace period has elapsed, the lock has to be held.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void epochCollectLimbo(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    const unsigned int epoch = __atomic_load_n(&threadSafeHandle->epoch, __ATOMIC_SEQ_CST);
+    EpochLimbo **link = &threadSafeHandle->epochLimbo;
+    while (*link != NULL)
+    {
+        EpochLimbo *const limbo = *link;
+        if ((epoch - limbo->epoch) >= 2U)
+        {
+            *link = limbo->next;
+            shinyFreeBatch(threadSafeHandle->handle, limbo->retired, limbo->count);
+            shinyFree(threadSafeHandle->handle, limbo);
+        }
+        else
+        {
+            link = &limbo->next;
+        }
+    }
+}
+
+/**
+ * @brief Releases the blocks of a claimed slot whose grace period has elapsed in one batch, the lock has to be held.
+ *
+ * @param threadSafeHandle
+ * @param slot
+ * @param spill moves the blocks still in their grace period to the limbo list, so the slot is empty afterwards
+ */
+SHINYALLOCATOR_PRIVATE void epochCollectSlot(shinyAllocatorThreadSafeInstance *const threadSafeHandle, EpochSlot *const slot,
+                                             const bool spill)
+{
+    const unsigned int epoch = __atomic_load_n(&threadSafeHandle->epoch, __ATOMIC_SEQ_CST);
+    void *expired[SHINYALLOCATOR_EPOCH_BATCH];
+    size_t count = 0U;
+    size_t kept = 0U;
+    for (size_t i = 0; i < slot->count; i++)
+    {
+        if ((epoch - slot->retireEpoch[i]) >= 2U)
+        {
+            expired[count] = slot->retired[i];
+            count++;
+        }
+        else
+        {
+            slot->retireEpoch[kept] = slot->retireEpoch[i];
+            slot->retired[kept] = slot->retired[i];
+            kept++;
+        }
+    }
+    shinyFreeBatch(threadSafeHandle->handle, expired, count);
+    slot->count = kept;
+    if (spill && (kept > 0U))
+    {
+        EpochLimbo *const limbo = (EpochLimbo *)shinyAllocate(threadSafeHandle->handle, sizeof(EpochLimbo));
+        if (limbo != NULL)
+        {
+            // The epochs of a slot never decrease, the last one is the latest
+            limbo->epoch = slot->retireEpoch[kept - 1U];
+            limbo->count = kept;
+            memcpy(limbo->retired, slot->retired, kept * sizeof(void *));
+            limbo->next = threadSafeHandle->epochLimbo;
+            threadSafeHandle->epochLimbo = limbo;
+            slot->count = 0U;
+        }
+    }
+}
+
+/**
+ * @brief Releases every retired block regardless of its grace period, the lock has to be held and no reader may be
+ * left.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void epochRelease(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    // Two epochs without readers end every grace period
+    __atomic_add_fetch(&threadSafeHandle->epoch, 2U, __ATOMIC_SEQ_CST);
+    epochCollectLimbo(threadSafeHandle);
+    for (size_t i = 0; i < SHINYALLOCATOR_EPOCH_SLOTS; i++)
+    {
+        epochCollectSlot(threadSafeHandle, &threadSafeHandle->epochSlot[i], false);
+    }
+}
+#endif
+
+#if SHINYALLOCATOR_COMBINING
+/**
+ * @brief Claims a free request slot, starting at a slot derived from the calling thread.
+ *
+ * @param threadSafeHandle
+ * @return the slot or NULL if every slot is busy
+ */
+SHINYALLOCATOR_PRIVATE CombiningSlot *combiningClaim(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    const size_t first = threadHint() % SHINYALLOCATOR_COMBINING_SLOTS;
+    for (size_t i = 0; i < SHINYALLOCATOR_COMBINING_SLOTS; i++)
+    {
+        CombiningSlot *const slot = &threadSafeHandle->combiningSlot[(first + i) % SHINYALLOCATOR_COMBINING_SLOTS];
+        unsigned int state = COMBINING_FREE;
+        if ((__atomic_load_n(&slot->state, __ATOMIC_RELAXED) == COMBINING_FREE) &&
+            __atomic_compare_exchange_n(&slot->state, &state, COMBINING_CLAIMED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Executes every published request, the lock has to be held.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void combiningServe(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    for (size_t i = 0; i < SHINYALLOCATOR_COMBINING_SLOTS; i++)
+    {
+        CombiningSlot *const slot = &threadSafeHandle->combiningSlot[i];
+        if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) == COMBINING_PENDING)
+        {
+            if (slot->operation == COMBINING_ALLOCATE)
+            {
+                slot->pointer = shinyAllocate(threadSafeHandle->handle, slot->amount);
+            }
+            else
+            {
+                shinyFree(threadSafeHandle->handle, slot->pointer);
+                slot->pointer = NULL;
+            }
+            __atomic_store_n(&slot->state, COMBINING_DONE, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/**
+ * @brief Publishes a request and waits until it is served, by another combiner or by the calling thread once it
+ * gets the lock.
+ *
+ * @param threadSafeHandle
+ * @param operation COMBINING_ALLOCATE or COMBINING_RELEASE
+ * @param amount requested allocation size
+ * @param pointer block to be released
+ * @return the allocated block
+ */
+SHINYALLOCATOR_PRIVATE void *combiningExecute(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const unsigned int operation,
+                                              const size_t amount, void *const pointer)
+{
+    CombiningSlot *const slot = combiningClaim(threadSafeHandle);
+    if (slot == NULL)
+    {
+        void *out = NULL;
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_OK)
+        {
+            threadSafeService(threadSafeHandle);
+            if (operation == COMBINING_ALLOCATE)
+            {
+                out = shinyAllocate(threadSafeHandle->handle, amount);
+            }
+            else
+            {
+                shinyFree(threadSafeHandle->handle, pointer);
+            }
+            threadSafeUnlock(threadSafeHandle);
+        }
+        return out;
+    }
+    slot->operation = operation;
+    slot->amount = amount;
+    slot->pointer = pointer;
+    __atomic_store_n(&slot->state, COMBINING_PENDING, __ATOMIC_RELEASE);
+    uint_fast32_t spin = 0U;
+    while (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) == COMBINING_PENDING)
+    {
+        if (threadSafeTryLock(threadSafeHandle) == SHINYALLOCATOR_OK)
+        {
+            // The own request is pending until served, so it is part of the batch
+            threadSafeService(threadSafeHandle);
+            combiningServe(threadSafeHandle);
+            threadSafeUnlock(threadSafeHandle);
+        }
+        else if (++spin < SHINYALLOCATOR_SPIN_COUNT)
+        {
+            SHINYALLOCATOR_CPU_RELAX();
+        }
+        else
+        {
+            SHINYALLOCATOR_BACKOFF();
+            spin = 0U;
+        }
+    }
+    void *const out = slot->pointer;
+    __atomic_store_n(&slot->state, COMBINING_FREE, __ATOMIC_RELEASE);
+    return out;
+}
+#endif
+
+#if SHINYALLOCATOR_PERCPU
+/**
+ * @return the rseq area glibc registered for the calling thread or NULL if restartable sequences are unavailable
+ */
+SHINYALLOCATOR_PRIVATE struct rseq *perCpuRseq(void)
+{
+#if defined(__x86_64__)
+    if (SHINYALLOCATOR_LIKELY(__rseq_size > 0U))
+    {
+        return (struct rseq *)((uint8_t *)__builtin_thread_pointer() + __rseq_offset);
+    }
+#endif
+    return NULL;
+}
+
+/**
+ * @brief Pushes a block onto a stack of the cache of the given CPU, the critical section commits with the store of
+ * the new count.
+ *
+ * @param abi rseq area of the calling thread
+ * @param cpu the CPU the cache belongs to
+ * @param count number of blocks on the stack
+ * @param slot the stack
+ * @param pointer the block
+ * @return SHINYALLOCATOR_ERROR if the stack is full or the thread was preempted or migrated
+ */
+SHINYALLOCATOR_PRIVATE SHINY_STATUS perCpuPush(struct rseq *const abi, const uint32_t cpu, size_t *const count,
+                                              void **const slot, void *const pointer)
+{
+#if defined(__x86_64__)
+    __asm__ __volatile__ goto(
+        ".pushsection __rseq_cs, \"aw\"\n\t"
+        ".balign 32\n\t"
+        "3:\n\t"
+        ".long 0x0, 0x0\n\t"
+        ".quad 1f, (2f - 1f), 4f\n\t"
+        ".popsection\n\t"
+        "leaq 3b(%%rip), %%rax\n\t"
+        "movq %%rax, %c[cs](%[abi])\n\t"
+        "1:\n\t"
+        "cmpl %[cpu], %c[cpuId](%[abi])\n\t"
+        "jnz %l[abort]\n\t"
+        "movq (%[count]), %%rcx\n\t"
+        "cmpq %[depth], %%rcx\n\t"
+        "jae %l[abort]\n\t"
+        "movq %[pointer], (%[slot], %%rcx, 8)\n\t"
+        "incq %%rcx\n\t"
+        "movq %%rcx, (%[count])\n\t"
+        "2:\n\t"
+        ".pushsection __rseq_failure, \"ax\"\n\t"
+        // The abort handler is preceded by the signature glibc registered
+        ".byte 0x0f, 0xb9, 0x3d\n\t"
+        ".long 0x53053053\n\t"
+        "4:\n\t"
+        "jmp %l[abort]\n\t"
+        ".popsection\n\t"
+        :
+        : [abi] "r"(abi), [cpu] "r"(cpu), [count] "r"(count), [slot] "r"(slot), [pointer] "r"(pointer),
+          [depth] "i"(SHINYALLOCATOR_PERCPU_DEPTH), [cs] "i"(offsetof(struct rseq, rseq_cs)),
+          [cpuId] "i"(offsetof(struct rseq, cpu_id))
+        : "memory", "cc", "rax", "rcx"
+        : abort);
+    return SHINYALLOCATOR_OK;
+abort:
+#else
+    (void)abi;
+    (void)cpu;
+    (void)count;
+    (void)slot;
+    (void)pointer;
+#endif
+    return SHINYALLOCATOR_ERROR;
+}
+
+/**
+ * @brief Pops a block from a stack of the cache of the given CPU, the critical section commits with the store of the
+ * new count.
+ *
+ * @param abi rseq area of the calling thread
+ * @param cpu the CPU the cache belongs to
+ * @param count number of blocks on the stack
+ * @param slot the stack
+ * @return the block or NULL if the stack is empty or the thread was preempted or migrated
+ */
+SHINYALLOCATOR_PRIVATE void *perCpuPop(struct rseq *const abi, const uint32_t cpu, size_t *const count, void **const slot)
+{
+    void *out = NULL;
+#if defined(__x86_64__)
+    __asm__ __volatile__ goto(
+        ".pushsection __rseq_cs, \"aw\"\n\t"
+        ".balign 32\n\t"
+        "3:\n\t"
+        ".long 0x0, 0x0\n\t"
+        ".quad 1f, (2f - 1f), 4f\n\t"
+        ".popsection\n\t"
+        "leaq 3b(%%rip), %%rax\n\t"
+        "movq %%rax, %c[cs](%[abi])\n\t"
+        "1:\n\t"
+        "cmpl %[cpu], %c[cpuId](%[abi])\n\t"
+        "jnz %l[abort]\n\t"
+        "movq (%[count]), %%rcx\n\t"
+        "testq %%rcx, %%rcx\n\t"
+        "jz %l[abort]\n\t"
+        "movq -8(%[slot], %%rcx, 8), %%rax\n\t"
+        "movq %%rax, (%[out])\n\t"
+        "decq %%rcx\n\t"
+        "movq %%rcx, (%[count])\n\t"
+        "2:\n\t"
+        ".pushsection __rseq_failure, \"ax\"\n\t"
+        ".byte 0x0f, 0xb9, 0x3d\n\t"
+        ".long 0x53053053\n\t"
+        "4:\n\t"
+        "jmp %l[abort]\n\t"
+        ".popsection\n\t"
+        :
+        : [abi] "r"(abi), [cpu] "r"(cpu), [count] "r"(count), [slot] "r"(slot), [out] "r"(&out),
+          [cs] "i"(offsetof(struct rseq, rseq_cs)), [cpuId] "i"(offsetof(struct rseq, cpu_id))
+        : "memory", "cc", "rax", "rcx"
+        : abort);
+    return out;
+abort:
+#else
+    (void)abi;
+    (void)cpu;
+    (void)count;
+    (void)slot;
+#endif
+    return NULL;
+}
+
+/**
+ * @param threadSafeHandle
+ * @param cpu
+ * @return the cache of the CPU or NULL if it has none
+ */
+SHINYALLOCATOR_PRIVATE PerCpuCache *perCpuCacheOf(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const uint32_t cpu)
+{
+    return (cpu < threadSafeHandle->perCpuCount) ? (PerCpuCache *)(threadSafeHandle->perCpu + (cpu * PERCPU_STRIDE)) : NULL;
+}
+
+/**
+ * @brief Takes a block of the size class from the cache of the current CPU without the lock.
+ *
+ * @param threadSafeHandle
+ * @param sizeClass
+ * @return the block or NULL on a miss
+ */
+SHINYALLOCATOR_PRIVATE void *perCpuAllocate(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t sizeClass)
+{
+    struct rseq *const abi = perCpuRseq();
+    if (abi != NULL)
+    {
+        const uint32_t cpu = __atomic_load_n(&abi->cpu_id, __ATOMIC_RELAXED);
+        PerCpuCache *const cache = perCpuCacheOf(threadSafeHandle, cpu);
+        if (cache != NULL)
+        {
+            return perCpuPop(abi, cpu, &cache->count[sizeClass], cache->slot[sizeClass]);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Caches a freed block of the size class in the cache of the current CPU without the lock.
+ *
+ * @param threadSafeHandle
+ * @param sizeClass
+ * @param pointer
+ * @return SHINYALLOCATOR_ERROR if the block has to be released through the locked path
+ */
+SHINYALLOCATOR_PRIVATE SHINY_STATUS perCpuFree(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t sizeClass,
+                                              void *const pointer)
+{
+    struct rseq *const abi = perCpuRseq();
+    if (abi != NULL)
+    {
+        const uint32_t cpu = __atomic_load_n(&abi->cpu_id, __ATOMIC_RELAXED);
+        PerCpuCache *const cache = perCpuCacheOf(threadSafeHandle, cpu);
+        if (cache != NULL)
+        {
+            return perCpuPush(abi, cpu, &cache->count[sizeClass], cache->slot[sizeClass], pointer);
+        }
+    }
+    return SHINYALLOCATOR_ERROR;
+}
+
+/**
+ * @brief Returns the blocks of every per-CPU cache to the pool, the lock has to be held.
+ * @details A cache can only be changed from its own CPU, so the calling thread visits every CPU of its affinity mask.
+ * Caches of CPUs outside of the mask are left alone.
+ *
+ * @param threadSafeHandle
+ */
+SHINYALLOCATOR_PRIVATE void perCpuDrain(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    struct rseq *const abi = perCpuRseq();
+    cpu_set_t affinity;
+    if ((abi == NULL) || (sched_getaffinity(0, sizeof(affinity), &affinity) != 0))
+    {
+        return;
+    }
+    for (uint32_t cpu = 0U; cpu < threadSafeHandle->perCpuCount; cpu++)
+    {
+        cpu_set_t target;
+        CPU_ZERO(&target);
+        CPU_SET(cpu, &target);
+        if (!CPU_ISSET(cpu, &affinity) || (sched_setaffinity(0, sizeof(target), &target) != 0))
+        {
+            continue;
+        }
+        PerCpuCache *const cache = perCpuCacheOf(threadSafeHandle, cpu);
+        for (size_t i = 0; i < SHINYALLOCATOR_PERCPU_CLASSES; i++)
+        {
+            // A pop only fails spuriously when the thread is preempted, so the retries are bounded
+            uint_fast32_t retry = 0U;
+            while ((__atomic_load_n(&cache->count[i], __ATOMIC_RELAXED) > 0U) && (retry < SHINYALLOCATOR_SPIN_COUNT))
+            {
+                void *const block = perCpuPop(abi, cpu, &cache->count[i], cache->slot[i]);
+                if (block != NULL)
+                {
+                    shinyFree(threadSafeHandle->handle, block);
+                }
+                else
+                {
+                    retry++;
+                }
+            }
+        }
+    }
+    (void)sched_setaffinity(0, sizeof(affinity), &affinity);
+}
+#endif
+
+shinyAllocatorDiagnostics shinyGetDiagnosticsThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    shinyAllocatorDiagnostics diagnostics = shinyGetDiagnostics(NULL);
+    if (threadSafeHandle != NULL)
+    {
+#if SHINYALLOCATOR_REMOTE_FREE
+        // The pending frees are only released when nobody holds the lock, a busy lock will release them anyway
+        if ((__atomic_load_n(&threadSafeHandle->pendingFree, __ATOMIC_RELAXED) != NULL) &&
+            (threadSafeTryLock(threadSafeHandle) == SHINYALLOCATOR_OK))
+        {
+            threadSafeService(threadSafeHandle);
+            threadSafeUnlock(threadSafeHandle);
+        }
+#endif
+#if SHINYALLOCATOR_FINE_LOCKING
+        // The engine updates the live counters atomically and the holder of the mutex only runs while it is empty
+        const size_t *const live = (const size_t *)&threadSafeHandle->handle->diagnostics;
+        size_t *const copy = (size_t *)&diagnostics;
+        fineEnter(threadSafeHandle);
+        for (size_t i = 0; i < DIAGNOSTICS_WORDS; i++)
+        {
+            copy[i] = __atomic_load_n(&live[i], __ATOMIC_RELAXED);
+        }
+        fineExit(threadSafeHandle);
+        // The peak is raised right after the counter it follows
+        if (diagnostics.peakAllocated < diagnostics.allocated)
+        {
+            diagnostics.peakAllocated = diagnostics.allocated;
+        }
+        return diagnostics;
+#elif DIAGNOSTICS_SEQLOCK
+        const size_t *const source = (const size_t *)&threadSafeHandle->diagnostics;
+        size_t *const target = (size_t *)&diagnostics;
+        uint_fast32_t retry = 0U;
+        for (;;)
+        {
+            const unsigned int sequence = __atomic_load_n(&threadSafeHandle->diagnosticsSequence, __ATOMIC_ACQUIRE);
+            if ((sequence & 1U) == 0U)
+            {
+                for (size_t i = 0; i < DIAGNOSTICS_WORDS; i++)
+                {
+                    target[i] = __atomic_load_n(&source[i], __ATOMIC_RELAXED);
+                }
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&threadSafeHandle->diagnosticsSequence, __ATOMIC_RELAXED) == sequence)
+                {
+                    break;
+                }
+            }
+            // A preempted writer has to be given the processor on single core targets
+            spinWait(&retry);
+        }
+#else
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_OK)
+        {
+            diagnostics = shinyGetDiagnostics(threadSafeHandle->handle);
+            threadSafeUnlock(threadSafeHandle);
+        }
+#endif
+    }
+    return diagnostics;
+}
+
+shinyAllocatorThreadSafeInstance *shinyInitThreadSafe(void *const base, const size_t size)
+{
+    shinyAllocatorThreadSafeInstance *threadSafeHandle = NULL;
+    SHINY_STATUS status = SHINYALLOCATOR_OK;
+    if (base != NULL)
+    {
+        threadSafeHandle = (shinyAllocatorThreadSafeInstance *)base;
+        if (status == SHINYALLOCATOR_OK)
+        {
+            status = mutex_init(&threadSafeHandle->mutex);
+        };
+        if (status == SHINYALLOCATOR_OK)
+        {
+            status = mutex_lock(&threadSafeHandle->mutex);
+            if (status == SHINYALLOCATOR_ERROR)
+            {
+                mutex_destroy(&threadSafeHandle->mutex);
+                threadSafeHandle = NULL;
+            }
+        }
+        if (status == SHINYALLOCATOR_OK)
+        {
+            const size_t offset = threadSafeHeaderSize();
+            void *allocatorBase = (uint_fast8_t *)base + offset;
+            threadSafeHandle->handle = (size > offset) ? shinyInit(allocatorBase, size - offset) : NULL;
+#if DIAGNOSTICS_SEQLOCK
+            threadSafeHandle->diagnosticsSequence = 0U;
+#endif
+#if SHINYALLOCATOR_EPOCH
+            threadSafeHandle->epoch = 0U;
+            threadSafeHandle->epochLimbo = NULL;
+            for (size_t i = 0; i < SHINYALLOCATOR_EPOCH_SLOTS; i++)
+            {
+                threadSafeHandle->epochSlot[i].state = EPOCH_FREE;
+                threadSafeHandle->epochSlot[i].count = 0U;
+            }
+#endif
+#if SHINYALLOCATOR_FINE_LOCKING
+            // Released by threadSafeUnlock() like every other holder of the mutex
+            threadSafeHandle->fineUsers = FINE_EXCLUSIVE;
+            threadSafeHandle->fineDetached = 0U;
+            threadSafeHandle->fineReturned = 0U;
+            memset(threadSafeHandle->binLock, 0, sizeof(threadSafeHandle->binLock));
+#endif
+#if SHINYALLOCATOR_MAGAZINES
+            for (size_t i = 0; i < SHINYALLOCATOR_MAGAZINE_CLASSES; i++)
+            {
+                threadSafeHandle->depotFull[i] = NULL;
+                threadSafeHandle->depotEmpty[i] = NULL;
+                threadSafeHandle->depotFullCount[i] = 0U;
+            }
+#endif
+#if PENDING_FREE
+            threadSafeHandle->pendingFree = NULL;
+#endif
+#if SHINYALLOCATOR_MAINTENANCE
+            threadSafeHandle->maintenanceRunning = 0U;
+            threadSafeHandle->maintenanceBacklog = NULL;
+#endif
+#if SHINYALLOCATOR_COMBINING
+            for (size_t i = 0; i < SHINYALLOCATOR_COMBINING_SLOTS; i++)
+            {
+                threadSafeHandle->combiningSlot[i].state = COMBINING_FREE;
+            }
+#endif
+#if SHINYALLOCATOR_PERCPU
+            const size_t instanceSize = (sizeof(shinyAllocatorThreadSafeInstance) + SHINYALLOCATOR_CACHE_LINE - 1U) &
+                                        ~((size_t)SHINYALLOCATOR_CACHE_LINE - 1U);
+            threadSafeHandle->perCpuCount = perCpuCount();
+            threadSafeHandle->perCpu = (uint8_t *)base + instanceSize;
+            if (size > offset)
+            {
+                memset(threadSafeHandle->perCpu, 0, threadSafeHandle->perCpuCount * PERCPU_STRIDE);
+            }
+#endif
+#ifdef SHINYALLOCATOR_FREERTOS
+            threadSafeHandle->isrReserve = NULL;
+            threadSafeHandle->isrReserveCount = 0U;
+            threadSafeHandle->isrPendingFree = NULL;
+            if (threadSafeHandle->handle != NULL)
+            {
+                isrReserveService(threadSafeHandle);
+            }
+#endif
+            if (threadSafeHandle->handle == NULL)
+            {
+                mutex_unlock(&threadSafeHandle->mutex);
+                mutex_destroy(&threadSafeHandle->mutex);
+                threadSafeHandle = NULL;
+            }
+        }
+        if (threadSafeHandle != NULL)
+        {
+            threadSafeUnlock(threadSafeHandle);
+#if SHINYALLOCATOR_MAGAZINES
+            magazineRegister(threadSafeHandle);
+#endif
+        }
+    }
+    return threadSafeHandle;
+}
+SHINY_STATUS shinyAddRegionThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const base, const size_t size)
+{
+    SHINY_STATUS status = SHINYALLOCATOR_ERROR;
+    if ((threadSafeHandle != NULL) && (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_OK))
+    {
+        status = shinyAddRegion(threadSafeHandle->handle, base, size);
+        threadSafeUnlock(threadSafeHandle);
+    }
+    return status;
+}
+
+#if SHINYALLOCATOR_PURGE
+size_t shinyTrimThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    size_t released = 0U;
+    if ((threadSafeHandle != NULL) && (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_OK))
+    {
+        threadSafeService(threadSafeHandle);
+        (void)maintenanceReclaim(threadSafeHandle);
+        released = shinyTrim(threadSafeHandle->handle);
+        threadSafeUnlock(threadSafeHandle);
+    }
+    return released;
+}
+#endif
+
+void *shinyAllocateThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount)
+{
+    void *pointer = NULL;
+    if (threadSafeHandle != NULL)
+    {
+#if SHINYALLOCATOR_MAGAZINES
+        if ((amount > 0U) && (amount <= (cacheClassSize(SHINYALLOCATOR_MAGAZINE_CLASSES - 1U) - FRAGMENT_HEADER_SIZE)))
+        {
+            pointer = magazineAllocate(threadSafeHandle,
+                                       cacheClassOf(roundUpToPowerOfTwo(fragmentSizeFor(amount)), SHINYALLOCATOR_MAGAZINE_CLASSES));
+            if (pointer != NULL)
+            {
+                return pointer;
+            }
+        }
+#endif
+        size_t request = amount;
+#if SHINYALLOCATOR_PERCPU
+        if ((amount > 0U) && (amount <= (cacheClassSize(SHINYALLOCATOR_PERCPU_CLASSES - 1U) - FRAGMENT_HEADER_SIZE)))
+        {
+            const size_t sizeClass = cacheClassOf(roundUpToPowerOfTwo(fragmentSizeFor(amount)), SHINYALLOCATOR_PERCPU_CLASSES);
+            pointer = perCpuAllocate(threadSafeHandle, sizeClass);
+            if (pointer != NULL)
+            {
+                return pointer;
+            }
+            // A miss allocates the whole class size, so the block can be cached once it is freed
+            request = cacheClassSize(sizeClass) - FRAGMENT_HEADER_SIZE;
+        }
+#endif
+#if SHINYALLOCATOR_COMBINING
+        return combiningExecute(threadSafeHandle, COMBINING_ALLOCATE, request, NULL);
+#endif
+#if SHINYALLOCATOR_FINE_LOCKING
+        return fineAllocate(threadSafeHandle, request);
+#endif
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_ERROR)
+        {
+            return pointer;
+        };
+        threadSafeService(threadSafeHandle);
+        pointer = shinyAllocate(threadSafeHandle->handle, request);
+        if ((pointer == NULL) && (request > 0U) && maintenanceReclaim(threadSafeHandle))
+        {
+            pointer = shinyAllocate(threadSafeHandle->handle, request);
+        }
+        threadSafeUnlock(threadSafeHandle);
+    }
+    return pointer;
+}
+
+void *shinyAllocateAlignedThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount,
+                                      const size_t alignment, const size_t boundary)
+{
+    void *pointer = NULL;
+    if (threadSafeHandle != NULL)
+    {
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_ERROR)
+        {
+            return pointer;
+        };
+        threadSafeService(threadSafeHandle);
+        pointer = shinyAllocateAligned(threadSafeHandle->handle, amount, alignment, boundary);
+        if ((pointer == NULL) && (amount > 0U) && maintenanceReclaim(threadSafeHandle))
+        {
+            pointer = shinyAllocateAligned(threadSafeHandle->handle, amount, alignment, boundary);
+        }
+        threadSafeUnlock(threadSafeHandle);
+    }
+    return pointer;
+}
+
+SHINY_STATUS shinyFreeThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const pointer)
+{
+    SHINY_STATUS status= SHINYALLOCATOR_ERROR;
+    if (threadSafeHandle != NULL)
+    {
+#if SHINYALLOCATOR_MAGAZINES
+        if ((pointer != NULL) && !largeOwned(threadSafeHandle->handle, pointer))
+        {
+            // The size of a used fragment is only changed by its owner, the neighbours only touch its link fields
+            const size_t sizeClass = cacheClassOf(fragmentSize(fragmentFromPointer(threadSafeHandle->handle, pointer)),
+                                                  SHINYALLOCATOR_MAGAZINE_CLASSES);
+            if ((sizeClass < SHINYALLOCATOR_MAGAZINE_CLASSES) &&
+                (magazineFree(threadSafeHandle, sizeClass, pointer) == SHINYALLOCATOR_OK))
+            {
+                return SHINYALLOCATOR_OK;
+            }
+        }
+#endif
+#if SHINYALLOCATOR_PERCPU
+        if ((pointer != NULL) && !largeOwned(threadSafeHandle->handle, pointer))
+        {
+            // The size of a used fragment is only changed by its owner, the neighbours only touch its link fields
+            const size_t sizeClass = cacheClassOf(fragmentSize(fragmentFromPointer(threadSafeHandle->handle, pointer)),
+                                                  SHINYALLOCATOR_PERCPU_CLASSES);
+            if ((sizeClass < SHINYALLOCATOR_PERCPU_CLASSES) && (perCpuFree(threadSafeHandle, sizeClass, pointer) == SHINYALLOCATOR_OK))
+            {
+                return SHINYALLOCATOR_OK;
+            }
+        }
+#endif
+#if SHINYALLOCATOR_REMOTE_FREE
+        remoteFreePush(threadSafeHandle, pointer);
+        return SHINYALLOCATOR_OK;
+#endif
+#if SHINYALLOCATOR_MAINTENANCE
+        if (__atomic_load_n(&threadSafeHandle->maintenanceRunning, __ATOMIC_RELAXED) != 0U)
+        {
+            remoteFreePush(threadSafeHandle, pointer);
+            return SHINYALLOCATOR_OK;
+        }
+#endif
+#if SHINYALLOCATOR_COMBINING
+        if (pointer != NULL)
+        {
+            (void)combiningExecute(threadSafeHandle, COMBINING_RELEASE, 0U, pointer);
+        }
+        return SHINYALLOCATOR_OK;
+#endif
+#if SHINYALLOCATOR_FINE_LOCKING
+        if (pointer != NULL)
+        {
+            fineFree(threadSafeHandle, pointer);
+        }
+        return SHINYALLOCATOR_OK;
+#endif
+        status = threadSafeLock(threadSafeHandle);
+        shinyFree(threadSafeHandle->handle, pointer);
+        threadSafeUnlock(threadSafeHandle);
+    }
+    return status;
+}
+
+void *shinyReallocateThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const pointer, const size_t amount)
+{
+    void *out = NULL;
+    if (threadSafeHandle != NULL)
+    {
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_ERROR)
+        {
+            return out;
+        };
+        threadSafeService(threadSafeHandle);
+        out = shinyReallocate(threadSafeHandle->handle, pointer, amount);
+        if ((out == NULL) && (amount > 0U) && maintenanceReclaim(threadSafeHandle))
+        {
+            out = shinyReallocate(threadSafeHandle->handle, pointer, amount);
+        }
+        threadSafeUnlock(threadSafeHandle);
+    }
+    return out;
+}
+
+SHINY_STATUS shinyAllocateBatchThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount,
+                                          const size_t count, void **const out)
+{
+    SHINY_STATUS status = SHINYALLOCATOR_ERROR;
+    if (threadSafeHandle != NULL)
+    {
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_ERROR)
+        {
+            return status;
+        };
+        threadSafeService(threadSafeHandle);
+        status = shinyAllocateBatch(threadSafeHandle->handle, amount, count, out);
+        if ((status == SHINYALLOCATOR_ERROR) && maintenanceReclaim(threadSafeHandle))
+        {
+            status = shinyAllocateBatch(threadSafeHandle->handle, amount, count, out);
+        }
+        threadSafeUnlock(threadSafeHandle);
+    }
+    return status;
+}
+
+SHINY_STATUS shinyFreeBatchThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void **const pointers,
+                                      const size_t count)
+{
+    SHINY_STATUS status = SHINYALLOCATOR_ERROR;
+    if (threadSafeHandle != NULL)
+    {
+        status = threadSafeLock(threadSafeHandle);
+        threadSafeService(threadSafeHandle);
+        shinyFreeBatch(threadSafeHandle->handle, pointers, count);
+        threadSafeUnlock(threadSafeHandle);
+    }
+    return status;
+}
+
+SHINY_STATUS shinyFlushThreadCacheThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    SHINY_STATUS status = SHINYALLOCATOR_ERROR;
+    if (threadSafeHandle != NULL)
+    {
+        status = threadSafeLock(threadSafeHandle);
+        if (status == SHINYALLOCATOR_OK)
+        {
+            threadSafeService(threadSafeHandle);
+            (void)maintenanceReclaim(threadSafeHandle);
+#if SHINYALLOCATOR_MAGAZINES
+            if ((magazineCache.owner == threadSafeHandle) &&
+                (magazineCache.generation == threadSafeHandle->magazineGeneration))
+            {
+                magazineCacheRelease(&magazineCache);
+            }
+            magazineDepotRelease(threadSafeHandle);
+#endif
+#if SHINYALLOCATOR_PERCPU
+            perCpuDrain(threadSafeHandle);
+#endif
+#if SHINYALLOCATOR_FINE_LOCKING
+            fineCoalesce(threadSafeHandle->handle);
+#endif
+            (void)quickFlush(threadSafeHandle->handle);
+            threadSafeUnlock(threadSafeHandle);
+        }
+    }
+    return status;
+}
+
+SHINY_STATUS shinyDeinitThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    SHINY_STATUS status= SHINYALLOCATOR_ERROR;
+    if (threadSafeHandle != NULL)
+    {
+#if SHINYALLOCATOR_MAINTENANCE
+        (void)shinyStopMaintenanceThreadSafe(threadSafeHandle);
+#endif
+        shinyFlushThreadCacheThreadSafe(threadSafeHandle);
+#if SHINYALLOCATOR_MAGAZINES
+        // The magazines other threads still hold went with the pool, their exit no longer reaches this instance
+        magazineUnregister(threadSafeHandle);
+#endif
+#if SHINYALLOCATOR_EPOCH
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_OK)
+        {
+            epochRelease(threadSafeHandle);
+            threadSafeUnlock(threadSafeHandle);
+        }
+#endif
+#ifdef SHINYALLOCATOR_FREERTOS
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_OK)
+        {
+            isrReserveRelease(threadSafeHandle);
+            threadSafeUnlock(threadSafeHandle);
+        }
+#endif
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_OK)
+        {
+            (void)shinyDeinit(threadSafeHandle->handle);
+            threadSafeUnlock(threadSafeHandle);
+        }
+#endif
+        status = mutex_destroy(&threadSafeHandle->mutex);
+    }
+    return status;
 }
 
-/**
- * @brief links the given fragments previous and next fragments in  a LeftToRight manner.
- *
- * @param left
- * @param right
- */
-SHINYALLOCATOR_PRIVATE void fragmentLink(Fragment *left, Fragment *right)
+#if SHINYALLOCATOR_MAINTENANCE
+SHINY_STATUS shinyStartMaintenanceThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle,
+                                             const uint32_t periodMicroseconds, const uint32_t budgetMicroseconds)
 {
-    if (SHINYALLOCATOR_LIKELY(left != NULL))
+    if ((threadSafeHandle == NULL) || (periodMicroseconds == 0U) || (budgetMicroseconds == 0U) ||
+        (__atomic_load_n(&threadSafeHandle->maintenanceRunning, __ATOMIC_RELAXED) != 0U))
     {
-        left->header.next = right;
+        return SHINYALLOCATOR_ERROR;
     }
-    if (SHINYALLOCATOR_LIKELY(right != NULL))
+    pthread_condattr_t attributes;
+    if (pthread_condattr_init(&attributes) != 0)
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    // Wall clock jumps must not stretch or skip a period
+    bool ready = (pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC) == 0) &&
+                 (pthread_cond_init(&threadSafeHandle->maintenanceWake, &attributes) == 0);
+    pthread_condattr_destroy(&attributes);
+    if (ready && (pthread_mutex_init(&threadSafeHandle->maintenanceMutex, NULL) != 0))
+    {
+        pthread_cond_destroy(&threadSafeHandle->maintenanceWake);
+        ready = false;
+    }
+    if (!ready)
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    threadSafeHandle->maintenancePeriod = (uint64_t)periodMicroseconds * 1000U;
+    threadSafeHandle->maintenanceBudget = (uint64_t)budgetMicroseconds * 1000U;
+#if SHINYALLOCATOR_PURGE
+    threadSafeHandle->maintenanceTrimBin = 0U;
+#endif
+    __atomic_store_n(&threadSafeHandle->maintenanceRunning, 1U, __ATOMIC_RELAXED);
+    if (pthread_create(&threadSafeHandle->maintenanceThread, NULL, maintenanceMain, threadSafeHandle) != 0)
     {
-        right->header.prev = left;
+        __atomic_store_n(&threadSafeHandle->maintenanceRunning, 0U, __ATOMIC_RELAXED);
+        pthread_mutex_destroy(&threadSafeHandle->maintenanceMutex);
+        pthread_cond_destroy(&threadSafeHandle->maintenanceWake);
+        return SHINYALLOCATOR_ERROR;
     }
+    return SHINYALLOCATOR_OK;
 }
 
-/***
- * @brief Appends a fragment to the allocator pool.
- *
- * @param handle pointer to the allocater handler
- * @param fragment pointer to the appending fragment
- */
-SHINYALLOCATOR_PRIVATE void appendFragment(shinyAllocatorInstance *const handle, Fragment *const fragment)
+SHINY_STATUS shinyStopMaintenanceThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
 {
-    SHINYALLOCATOR_ASSERT(handle != NULL);
-    SHINYALLOCATOR_ASSERT(fragment != NULL);
-    SHINYALLOCATOR_ASSERT(fragment->header.size >= FRAGMENT_SIZE_MIN);
-    SHINYALLOCATOR_ASSERT((fragment->header.size % FRAGMENT_SIZE_MIN) == 0U);
-    const uint_fast8_t index = log2Floor(fragment->header.size / FRAGMENT_SIZE_MIN);
-    SHINYALLOCATOR_ASSERT(index < NUM_FRAGMENTS_MAX);
-    fragment->nextFree = handle->fragments[index];
-    fragment->prevFree = NULL;
-    if (SHINYALLOCATOR_LIKELY(handle->fragments[index] != NULL))
+    if ((threadSafeHandle == NULL) || (__atomic_load_n(&threadSafeHandle->maintenanceRunning, __ATOMIC_RELAXED) == 0U))
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    pthread_mutex_lock(&threadSafeHandle->maintenanceMutex);
+    __atomic_store_n(&threadSafeHandle->maintenanceRunning, 0U, __ATOMIC_RELAXED);
+    pthread_cond_signal(&threadSafeHandle->maintenanceWake);
+    pthread_mutex_unlock(&threadSafeHandle->maintenanceMutex);
+    pthread_join(threadSafeHandle->maintenanceThread, NULL);
+    pthread_mutex_destroy(&threadSafeHandle->maintenanceMutex);
+    pthread_cond_destroy(&threadSafeHandle->maintenanceWake);
+    SHINY_STATUS status = threadSafeLock(threadSafeHandle);
+    if (status == SHINYALLOCATOR_OK)
     {
-        handle->fragments[index]->prevFree = fragment;
+        (void)maintenanceReclaim(threadSafeHandle);
+        threadSafeUnlock(threadSafeHandle);
     }
-    handle->fragments[index] = fragment;
-    handle->nonEmptyFragmentMask |= pow2(index);
+    return status;
 }
+#endif
 
-/***
- * @brief Removes a fragment from the allocator pool.
- *
- * @param handle pointer to the allocater handler
- * @param fragment pointer to the appending fragment
- */
-SHINYALLOCATOR_PRIVATE void removeFragment(shinyAllocatorInstance *const handle, const Fragment *const fragment)
+#if SHINYALLOCATOR_EPOCH
+SHINY_STATUS shinyEpochEnterThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, size_t *const guard)
 {
-    SHINYALLOCATOR_ASSERT(handle != NULL);
-    SHINYALLOCATOR_ASSERT(fragment != NULL);
-    SHINYALLOCATOR_ASSERT(fragment->header.size >= FRAGMENT_SIZE_MIN);
-    SHINYALLOCATOR_ASSERT((fragment->header.size % FRAGMENT_SIZE_MIN) == 0U);
-    const uint_fast8_t index = log2Floor(fragment->header.size / FRAGMENT_SIZE_MIN);
-    SHINYALLOCATOR_ASSERT(index < NUM_FRAGMENTS_MAX);
-
-    if (SHINYALLOCATOR_LIKELY(fragment->nextFree != NULL))
+    if ((threadSafeHandle == NULL) || (guard == NULL))
     {
-        fragment->nextFree->prevFree = fragment->prevFree;
+        return SHINYALLOCATOR_ERROR;
     }
-    if (SHINYALLOCATOR_LIKELY(fragment->prevFree != NULL))
+    EpochSlot *slot = NULL;
+    uint_fast32_t retry = 0U;
+    while ((slot = epochClaim(threadSafeHandle)) == NULL)
     {
-        fragment->prevFree->nextFree = fragment->nextFree;
+        spinWait(&retry);
     }
-
-    if (SHINYALLOCATOR_LIKELY(handle->fragments[index] == fragment))
+    // The announcement has to be visible before the reader loads any shared pointer
+    unsigned int epoch = __atomic_load_n(&threadSafeHandle->epoch, __ATOMIC_SEQ_CST);
+    for (;;)
     {
-        SHINYALLOCATOR_ASSERT(fragment->prevFree == NULL);
-        handle->fragments[index] = fragment->nextFree;
-        if (SHINYALLOCATOR_LIKELY(handle->fragments[index] == NULL))
+        __atomic_store_n(&slot->state, (epoch << EPOCH_SHIFT) | EPOCH_READER, __ATOMIC_SEQ_CST);
+        const unsigned int current = __atomic_load_n(&threadSafeHandle->epoch, __ATOMIC_SEQ_CST);
+        if (current == epoch)
         {
-            handle->nonEmptyFragmentMask &= ~pow2(index);
+            break;
         }
+        epoch = current;
     }
+    *guard = (size_t)(slot - threadSafeHandle->epochSlot);
+    return SHINYALLOCATOR_OK;
 }
 
-/*********************************
- * Public interface implementation
- **********************************/
-
-size_t sizeof_shinyAllocatorInstance(void)
-{
-    return sizeof(shinyAllocatorInstance);
-};
-size_t sizeof_shinyAllocatorThreadSafeInstance(void)
-{
-    return sizeof(shinyAllocatorThreadSafeInstance);
-};
-
-shinyAllocatorDiagnostics shinyGetDiagnostics(shinyAllocatorInstance *handle)
+SHINY_STATUS shinyEpochExitThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t guard)
 {
-    shinyAllocatorDiagnostics diagnostics = {
-        .capacity = 0U,
-        .allocated = 0U,
-        .peakAllocated = 0U,
-        .peakRequestSize = 0U,
-        .outOfMemeoryCount = 0U};
-    if (handle)
+    if ((threadSafeHandle == NULL) || (guard >= SHINYALLOCATOR_EPOCH_SLOTS))
     {
-        diagnostics = handle->diagnostics;
+        return SHINYALLOCATOR_ERROR;
     }
-    return diagnostics;
+    __atomic_store_n(&threadSafeHandle->epochSlot[guard].state, EPOCH_FREE, __ATOMIC_RELEASE);
+    return SHINYALLOCATOR_OK;
 }
 
-shinyAllocatorInstance *shinyInit(void *const base, const size_t size)
+SHINY_STATUS shinyRetireThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t guard, void *const pointer)
 {
-    shinyAllocatorInstance *out = NULL;
-    if ((base != NULL) && ((((size_t)base) % SHINYALLOCATOR_ALIGNMENT) == 0U) &&
-        (size >= (INSTANCE_SIZE_PADDED + FRAGMENT_SIZE_MIN)))
+    if ((threadSafeHandle == NULL) || (guard >= SHINYALLOCATOR_EPOCH_SLOTS))
     {
-        SHINYALLOCATOR_ASSERT(((size_t)base) % sizeof(shinyAllocatorInstance *) == 0U);
-        out = (shinyAllocatorInstance *)base;
-        out->nonEmptyFragmentMask = 0U;
-        for (size_t i = 0; i < NUM_FRAGMENTS_MAX; i++)
+        return SHINYALLOCATOR_ERROR;
+    }
+    if (pointer == NULL)
+    {
+        return SHINYALLOCATOR_OK;
+    }
+    EpochSlot *const slot = &threadSafeHandle->epochSlot[guard];
+    if (slot->count == SHINYALLOCATOR_EPOCH_BATCH)
+    {
+        epochAdvance(threadSafeHandle);
+        if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_ERROR)
         {
-            out->fragments[i] = NULL;
+            return SHINYALLOCATOR_ERROR;
         }
-
-        size_t capacity = size - INSTANCE_SIZE_PADDED;
-        if (capacity > FRAGMENT_SIZE_MAX)
+        threadSafeService(threadSafeHandle);
+        epochCollectLimbo(threadSafeHandle);
+        epochCollectSlot(threadSafeHandle, slot, true);
+        threadSafeUnlock(threadSafeHandle);
+        if (slot->count == SHINYALLOCATOR_EPOCH_BATCH)
         {
-            capacity = FRAGMENT_SIZE_MAX;
+            return SHINYALLOCATOR_ERROR;
         }
-        while ((capacity % FRAGMENT_SIZE_MIN) != 0)
+    }
+    slot->retireEpoch[slot->count] = __atomic_load_n(&threadSafeHandle->epoch, __ATOMIC_SEQ_CST);
+    slot->retired[slot->count] = pointer;
+    slot->count++;
+    return SHINYALLOCATOR_OK;
+}
+
+SHINY_STATUS shinyReclaimThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+{
+    if (threadSafeHandle == NULL)
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    epochAdvance(threadSafeHandle);
+    if (threadSafeLock(threadSafeHandle) == SHINYALLOCATOR_ERROR)
+    {
+        return SHINYALLOCATOR_ERROR;
+    }
+    threadSafeService(threadSafeHandle);
+    epochCollectLimbo(threadSafeHandle);
+    for (size_t i = 0; i < SHINYALLOCATOR_EPOCH_SLOTS; i++)
+    {
+        // Slots of active readers are collected by their holders once they fill up
+        EpochSlot *const slot = &threadSafeHandle->epochSlot[i];
+        unsigned int expected = EPOCH_FREE;
+        if (__atomic_compare_exchange_n(&slot->state, &expected, EPOCH_BUSY, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
         {
-            SHINYALLOCATOR_ASSERT(capacity > 0U);
-            capacity--;
+            epochCollectSlot(threadSafeHandle, slot, false);
+            __atomic_store_n(&slot->state, EPOCH_FREE, __ATOMIC_RELEASE);
         }
-        SHINYALLOCATOR_ASSERT((capacity % FRAGMENT_SIZE_MIN) == 0);
-        SHINYALLOCATOR_ASSERT((capacity >= FRAGMENT_SIZE_MIN) && (capacity <= FRAGMENT_SIZE_MAX));
-
-        Fragment *const frag = (Fragment *)(void *)(((char *)base) + INSTANCE_SIZE_PADDED);
-        SHINYALLOCATOR_ASSERT((((size_t)frag) % SHINYALLOCATOR_ALIGNMENT) == 0U);
-        frag->header.next = NULL;
-        frag->header.prev = NULL;
-        frag->header.size = capacity;
-        frag->header.used = false;
-        frag->nextFree = NULL;
-        frag->prevFree = NULL;
-        appendFragment(out, frag);
-        SHINYALLOCATOR_ASSERT(out->nonEmptyFragmentMask != 0U);
-
-        out->diagnostics.capacity = capacity;
-        out->diagnostics.allocated = 0U;
-        out->diagnostics.peakAllocated = 0U;
-        out->diagnostics.peakRequestSize = 0U;
-        out->diagnostics.outOfMemeoryCount = 0U;
     }
-
-    return out;
+    threadSafeUnlock(threadSafeHandle);
+    return SHINYALLOCATOR_OK;
 }
-void *shinyAllocate(shinyAllocatorInstance *const handle, const size_t amount)
+#endif // SHINYALLOCATOR_EPOCH
+
+#ifdef SHINYALLOCATOR_FREERTOS
+void *shinyAllocateFromISR(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount)
 {
-    SHINYALLOCATOR_ASSERT(handle != NULL);
-    SHINYALLOCATOR_ASSERT(handle->diagnostics.capacity <= FRAGMENT_SIZE_MAX);
-    void *out = NULL;
-    if (SHINYALLOCATOR_LIKELY((amount > 0U) && (amount <= (handle->diagnostics.capacity - SHINYALLOCATOR_ALIGNMENT))))
+    void *pointer = NULL;
+    if ((threadSafeHandle != NULL) && (amount > 0U) && (amount <= SHINYALLOCATOR_ISR_BLOCK_SIZE))
     {
-        const size_t fragmentSize = roundUpToPowerOfTwo(amount + SHINYALLOCATOR_ALIGNMENT);
-        SHINYALLOCATOR_ASSERT(fragmentSize <= FRAGMENT_SIZE_MAX);
-        SHINYALLOCATOR_ASSERT(fragmentSize >= FRAGMENT_SIZE_MIN);
-        SHINYALLOCATOR_ASSERT(fragmentSize >= amount + SHINYALLOCATOR_ALIGNMENT);
-        SHINYALLOCATOR_ASSERT((fragmentSize & (fragmentSize - 1U)) == 0U);
-
-        const uint_fast8_t optimalFragmentIndex = log2Ceil(fragmentSize / FRAGMENT_SIZE_MIN);
-        SHINYALLOCATOR_ASSERT(optimalFragmentIndex < NUM_FRAGMENTS_MAX);
-        const size_t candidateFragmentMask = ~(pow2(optimalFragmentIndex) - 1U);
-
-        const size_t suitableFragments = handle->nonEmptyFragmentMask & candidateFragmentMask;
-        const size_t smallestFragmentMask = suitableFragments & ~(suitableFragments - 1U);
-
-        if (SHINYALLOCATOR_LIKELY(smallestFragmentMask != 0))
+        const UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+        pointer = threadSafeHandle->isrReserve;
+        if (pointer != NULL)
         {
-            SHINYALLOCATOR_ASSERT((smallestFragmentMask & (smallestFragmentMask - 1U)) == 0U);
-            const uint_fast8_t fragmentIndex = log2Floor(smallestFragmentMask);
-            SHINYALLOCATOR_ASSERT(fragmentIndex >= optimalFragmentIndex);
-            SHINYALLOCATOR_ASSERT(fragmentIndex < NUM_FRAGMENTS_MAX);
-
-            Fragment *const frag = handle->fragments[fragmentIndex];
-            SHINYALLOCATOR_ASSERT(frag != NULL);
-            SHINYALLOCATOR_ASSERT(frag->header.size >= fragmentSize);
-            SHINYALLOCATOR_ASSERT((frag->header.size % FRAGMENT_SIZE_MIN) == 0U);
-            SHINYALLOCATOR_ASSERT(!frag->header.used);
-            removeFragment(handle, frag);
-
-            const size_t leftover = frag->header.size - fragmentSize;
-            frag->header.size = fragmentSize;
-            SHINYALLOCATOR_ASSERT(leftover < handle->diagnostics.capacity);
-            SHINYALLOCATOR_ASSERT(leftover % FRAGMENT_SIZE_MIN == 0U);
-            if (SHINYALLOCATOR_LIKELY(leftover >= FRAGMENT_SIZE_MIN))
-            {
-                Fragment *const newFrag = (Fragment *)(void *)(((char *)frag) + fragmentSize);
-                SHINYALLOCATOR_ASSERT(((size_t)newFrag) % SHINYALLOCATOR_ALIGNMENT == 0U);
-                newFrag->header.size = leftover;
-                newFrag->header.used = false;
-                fragmentLink(newFrag, frag->header.next);
-                fragmentLink(frag, newFrag);
-                appendFragment(handle, newFrag);
-            }
-
-            SHINYALLOCATOR_ASSERT((handle->diagnostics.allocated % FRAGMENT_SIZE_MIN) == 0U);
-            handle->diagnostics.allocated += fragmentSize;
-            SHINYALLOCATOR_ASSERT(handle->diagnostics.allocated <= handle->diagnostics.capacity);
-            if (SHINYALLOCATOR_LIKELY(handle->diagnostics.peakAllocated < handle->diagnostics.allocated))
-            {
-                handle->diagnostics.peakAllocated = handle->diagnostics.allocated;
-            }
-
-            SHINYALLOCATOR_ASSERT(frag->header.size >= amount + SHINYALLOCATOR_ALIGNMENT);
-            frag->header.used = true;
-
-            out = ((char *)frag) + SHINYALLOCATOR_ALIGNMENT;
+            threadSafeHandle->isrReserve = *(void **)pointer;
+            threadSafeHandle->isrReserveCount--;
         }
+        taskEXIT_CRITICAL_FROM_ISR(mask);
     }
+    return pointer;
+}
 
-    if (SHINYALLOCATOR_LIKELY(handle->diagnostics.peakRequestSize < amount))
+SHINY_STATUS shinyFreeFromISR(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const pointer)
+{
+    if (threadSafeHandle == NULL)
     {
-        handle->diagnostics.peakRequestSize = amount;
+        return SHINYALLOCATOR_ERROR;
     }
-    if (SHINYALLOCATOR_LIKELY((out == NULL) && (amount > 0U)))
+    if (pointer != NULL)
     {
-        handle->diagnostics.outOfMemeoryCount++;
+        const UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+        *(void **)pointer = threadSafeHandle->isrPendingFree;
+        threadSafeHandle->isrPendingFree = pointer;
+        taskEXIT_CRITICAL_FROM_ISR(mask);
     }
+    return SHINYALLOCATOR_OK;
+}
+#endif // SHINYALLOCATOR_FREERTOS
 
+/**
+ * @brief Allocates from a single shard, the lock is only tried unless blocking is requested.
+ *
+ * @param shard
+ * @param amount
+ * @param blocking
+ * @return the memory block or NULL if the shard is busy or full
+ */
+SHINYALLOCATOR_PRIVATE void *shardAllocate(shinyAllocatorThreadSafeInstance *const shard, const size_t amount, const bool blocking)
+{
+    void *out = NULL;
+    if ((blocking ? threadSafeLock(shard) : threadSafeTryLock(shard)) == SHINYALLOCATOR_OK)
+    {
+        threadSafeService(shard);
+        out = shinyAllocate(shard->handle, amount);
+        threadSafeUnlock(shard);
+    }
     return out;
 }
 
-void shinyFree(shinyAllocatorInstance *const handle, void *const pointer)
+shinyAllocatorShardedInstance *shinyInitSharded(void *const base, const size_t size, const size_t shards)
 {
-
-    SHINYALLOCATOR_ASSERT(handle != NULL);
-    SHINYALLOCATOR_ASSERT(handle->diagnostics.capacity <= FRAGMENT_SIZE_MAX);
-    if (SHINYALLOCATOR_LIKELY(pointer != NULL))
+    const size_t headerSize = (sizeof(shinyAllocatorShardedInstance) + SHINYALLOCATOR_ALIGNMENT - 1U) & ~(SHINYALLOCATOR_ALIGNMENT - 1U);
+    if ((base == NULL) || (((size_t)base) % SHINYALLOCATOR_ALIGNMENT != 0U) || (shards == 0U) ||
+        (shards > SHINYALLOCATOR_SHARDS_MAX) || (size <= headerSize))
     {
-        Fragment *const frag = (Fragment *)(void *)(((char *)pointer) - SHINYALLOCATOR_ALIGNMENT);
-
-        SHINYALLOCATOR_ASSERT(((size_t)frag) % sizeof(Fragment *) == 0U);
-        SHINYALLOCATOR_ASSERT(((size_t)frag) >= (((size_t)handle) + INSTANCE_SIZE_PADDED));
-        SHINYALLOCATOR_ASSERT(((size_t)frag) <=
-                              (((size_t)handle) + INSTANCE_SIZE_PADDED + handle->diagnostics.capacity - FRAGMENT_SIZE_MIN));
-        SHINYALLOCATOR_ASSERT(frag->header.used);
-        SHINYALLOCATOR_ASSERT(((size_t)frag->header.next) % sizeof(Fragment *) == 0U);
-        SHINYALLOCATOR_ASSERT(((size_t)frag->header.prev) % sizeof(Fragment *) == 0U);
-        SHINYALLOCATOR_ASSERT(frag->header.size >= FRAGMENT_SIZE_MIN);
-        SHINYALLOCATOR_ASSERT(frag->header.size <= handle->diagnostics.capacity);
-        SHINYALLOCATOR_ASSERT((frag->header.size % FRAGMENT_SIZE_MIN) == 0U);
-
-        frag->header.used = false;
-
-        SHINYALLOCATOR_ASSERT(handle->diagnostics.allocated >= frag->header.size);
-        handle->diagnostics.allocated -= frag->header.size;
-
-        Fragment *const prev = frag->header.prev;
-        Fragment *const next = frag->header.next;
-        const bool join_left = (prev != NULL) && (!prev->header.used);
-        const bool join_right = (next != NULL) && (!next->header.used);
-
-        if (join_left && join_right)
-        {
-            removeFragment(handle, prev);
-            removeFragment(handle, next);
-            prev->header.size += frag->header.size + next->header.size;
-            frag->header.size = 0;
-            next->header.size = 0;
-            SHINYALLOCATOR_ASSERT((prev->header.size % FRAGMENT_SIZE_MIN) == 0U);
-            fragmentLink(prev, next->header.next);
-            removeFragment(handle, prev);
-        }
-        else if (join_left)
-        {
-            removeFragment(handle, prev);
-            prev->header.size += frag->header.size;
-            frag->header.size = 0;
-            SHINYALLOCATOR_ASSERT((prev->header.size % FRAGMENT_SIZE_MIN) == 0U);
-            fragmentLink(prev, next);
-            removeFragment(handle, prev);
-        }
-        else if (join_right)
-        {
-            removeFragment(handle, next);
-            frag->header.size += next->header.size;
-            next->header.size = 0;
-            SHINYALLOCATOR_ASSERT((frag->header.size % FRAGMENT_SIZE_MIN) == 0U);
-            fragmentLink(frag, next->header.next);
-            removeFragment(handle, frag);
-        }
-        else
+        return NULL;
+    }
+    shinyAllocatorShardedInstance *const shardedHandle = (shinyAllocatorShardedInstance *)base;
+    shardedHandle->shardCount = shards;
+    shardedHandle->shardSize = ((size - headerSize) / shards) & ~(SHINYALLOCATOR_ALIGNMENT - 1U);
+    for (size_t i = 0; i < shards; i++)
+    {
+        void *const shardBase = ((char *)base) + headerSize + (i * shardedHandle->shardSize);
+        shardedHandle->shard[i] = shinyInitThreadSafe(shardBase, shardedHandle->shardSize);
+        if (shardedHandle->shard[i] == NULL)
         {
-            removeFragment(handle, frag);
+            while (i > 0U)
+            {
+                i--;
+                shinyDeinitThreadSafe(shardedHandle->shard[i]);
+            }
+            return NULL;
         }
     }
+    return shardedHandle;
 }
 
-shinyAllocatorDiagnostics shinyGetDiagnosticsThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+void *shinyAllocateSharded(shinyAllocatorShardedInstance *const shardedHandle, const size_t amount)
 {
-    shinyAllocatorDiagnostics diagnostics;
-
-    mutex_lock(&threadSafeHandle->mutex);
-    diagnostics = shinyGetDiagnostics(threadSafeHandle->handle);
-    mutex_unlock(&threadSafeHandle->mutex);
-
-    return diagnostics;
+    void *out = NULL;
+    if (shardedHandle != NULL)
+    {
+        const size_t first = threadHint() % shardedHandle->shardCount;
+        // A busy shard is skipped rather than waited for, the locks are only taken when every shard is busy or full
+        for (size_t pass = 0; (pass < 2U) && (out == NULL); pass++)
+        {
+            for (size_t i = 0; (i < shardedHandle->shardCount) && (out == NULL); i++)
+            {
+                out = shardAllocate(shardedHandle->shard[(first + i) % shardedHandle->shardCount], amount, pass > 0U);
+            }
+        }
+    }
+    return out;
 }
 
-shinyAllocatorThreadSafeInstance *shinyInitThreadSafe(void *const base, const size_t size)
+SHINY_STATUS shinyFreeSharded(shinyAllocatorShardedInstance *const shardedHandle, void *const pointer)
 {
-    shinyAllocatorThreadSafeInstance *threadSafeHandle = NULL;
-    SHINY_STATUS status = SHINYALLOCATOR_OK;
-    if (base != NULL)
+    SHINY_STATUS status = SHINYALLOCATOR_ERROR;
+    if (shardedHandle != NULL)
     {
-        threadSafeHandle = (shinyAllocatorThreadSafeInstance *)base;
-        if (status == SHINYALLOCATOR_OK)
-        {
-            status = mutex_init(&threadSafeHandle->mutex);
-        };
-        if (status == SHINYALLOCATOR_OK)
+        if (pointer == NULL)
         {
-            status = mutex_lock(&threadSafeHandle->mutex);
-            if (status == SHINYALLOCATOR_ERROR)
-            {
-                mutex_destroy(&threadSafeHandle->mutex);
-                threadSafeHandle = NULL;
-            }
+            return SHINYALLOCATOR_OK;
         }
-        if (status == SHINYALLOCATOR_OK)
+        size_t index = (((size_t)pointer) - ((size_t)shardedHandle->shard[0])) / shardedHandle->shardSize;
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        // Direct mappings lie outside of the shards, their shard is found through the mapping tables
+        if ((((size_t)pointer) < ((size_t)shardedHandle->shard[0])) || (index >= shardedHandle->shardCount))
         {
-            void *allocatorBase = (uint_fast8_t *)base + sizeof(shinyAllocatorThreadSafeInstance) + SHINYALLOCATOR_ALIGNMENT - (sizeof(shinyAllocatorThreadSafeInstance) % SHINYALLOCATOR_ALIGNMENT);
-            threadSafeHandle->handle = shinyInit(allocatorBase, size - sizeof(shinyAllocatorThreadSafeInstance));
-            if (threadSafeHandle->handle == NULL)
+            index = 0U;
+            while ((index < shardedHandle->shardCount) && !largeOwned(shardedHandle->shard[index]->handle, pointer))
             {
-                mutex_unlock(&threadSafeHandle->mutex);
-                mutex_destroy(&threadSafeHandle->mutex);
-                threadSafeHandle = NULL;
+                index++;
             }
+            SHINYALLOCATOR_ASSERT(index < shardedHandle->shardCount);
         }
-        if (threadSafeHandle != NULL)
+        else
+#endif
         {
-            mutex_unlock(&threadSafeHandle->mutex);
+            SHINYALLOCATOR_ASSERT(((size_t)pointer) > ((size_t)shardedHandle->shard[0]));
+            SHINYALLOCATOR_ASSERT(index < shardedHandle->shardCount);
         }
-    }
-    return threadSafeHandle;
-}
-void *shinyAllocateThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, const size_t amount)
-{
-    void *pointer = NULL;
-    if (threadSafeHandle != NULL)
-    {
-        if (mutex_lock(&threadSafeHandle->mutex) == SHINYALLOCATOR_ERROR)
+        shinyAllocatorThreadSafeInstance *const shard = shardedHandle->shard[index];
+#if SHINYALLOCATOR_REMOTE_FREE
+        remoteFreePush(shard, pointer);
+        status = SHINYALLOCATOR_OK;
+#else
+        status = threadSafeLock(shard);
+        if (status == SHINYALLOCATOR_OK)
         {
-            return pointer;
-        };
-        pointer = shinyAllocate(threadSafeHandle->handle, amount);
-        mutex_unlock(&threadSafeHandle->mutex);
+            shinyFree(shard->handle, pointer);
+            threadSafeUnlock(shard);
+        }
+#endif
     }
-    return pointer;
+    return status;
 }
 
-SHINY_STATUS shinyFreeThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle, void *const pointer)
+shinyAllocatorDiagnostics shinyGetDiagnosticsSharded(shinyAllocatorShardedInstance *const shardedHandle)
 {
-    SHINY_STATUS status= SHINYALLOCATOR_ERROR;
-    if (threadSafeHandle != NULL)
+    shinyAllocatorDiagnostics diagnostics = shinyGetDiagnostics(NULL);
+    if (shardedHandle != NULL)
     {
-        status = mutex_lock(&threadSafeHandle->mutex);
-        shinyFree(threadSafeHandle->handle, pointer);
-        mutex_unlock(&threadSafeHandle->mutex);
+        for (size_t i = 0; i < shardedHandle->shardCount; i++)
+        {
+            const shinyAllocatorDiagnostics shard = shinyGetDiagnosticsThreadSafe(shardedHandle->shard[i]);
+            diagnostics.capacity += shard.capacity;
+            diagnostics.allocated += shard.allocated;
+            diagnostics.peakAllocated += shard.peakAllocated;
+            diagnostics.peakRequestSize = (shard.peakRequestSize > diagnostics.peakRequestSize) ? shard.peakRequestSize : diagnostics.peakRequestSize;
+            diagnostics.outOfMemeoryCount += shard.outOfMemeoryCount;
+            diagnostics.reallocInPlaceCount += shard.reallocInPlaceCount;
+            diagnostics.reallocMovedCount += shard.reallocMovedCount;
+#if PENDING_FREE
+            diagnostics.remoteFreeCount += shard.remoteFreeCount;
+#endif
+#if SHINYALLOCATOR_QUICK_LISTS
+            diagnostics.splitSavedCount += shard.splitSavedCount;
+            diagnostics.mergeSavedCount += shard.mergeSavedCount;
+#endif
+#if SHINYALLOCATOR_PURGE
+            diagnostics.purged += shard.purged;
+#endif
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+            diagnostics.mapped += shard.mapped;
+#endif
+        }
     }
-    return status;
+    return diagnostics;
 }
 
-SHINY_STATUS shinyDeinitThreadSafe(shinyAllocatorThreadSafeInstance *const threadSafeHandle)
+SHINY_STATUS shinyDeinitSharded(shinyAllocatorShardedInstance *const shardedHandle)
 {
-    SHINY_STATUS status= SHINYALLOCATOR_ERROR;
-    if (threadSafeHandle != NULL)
+    SHINY_STATUS status = SHINYALLOCATOR_ERROR;
+    if (shardedHandle != NULL)
     {
-        status = mutex_destroy(&threadSafeHandle->mutex);
+        status = SHINYALLOCATOR_OK;
+        for (size_t i = 0; i < shardedHandle->shardCount; i++)
+        {
+            if (shinyDeinitThreadSafe(shardedHandle->shard[i]) != SHINYALLOCATOR_OK)
+            {
+                status = SHINYALLOCATOR_ERROR;
+            }
+        }
     }
     return status;
 }
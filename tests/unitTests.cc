@@ -1,5 +1,21 @@
 #include <gtest/gtest.h>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
 #include "shinyAllocator.h"
+#if SHINYALLOCATOR_PURGE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if SHINYALLOCATOR_PERCPU
+#include <cstdlib>
+#include <sched.h>
+#include <string>
+#include <sys/rseq.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 namespace
 {
@@ -7,6 +23,82 @@ namespace
     const size_t KiB = 1024U;
     const size_t MiB = KiB * KiB;
 
+    /**
+     * @brief fragment footprint of a request under the configured bin policy
+     */
+    size_t footprint(const size_t amount)
+    {
+#if SHINYALLOCATOR_COMPACT_HEADER
+        const size_t quantum = SHINYALLOCATOR_ALIGNMENT;
+        const size_t link = (SHINYALLOCATOR_OFFSET_BITS != 0) ? (SHINYALLOCATOR_OFFSET_BITS / 8U) : sizeof(void *);
+        const size_t fragmentSizeMin = (SHINYALLOCATOR_OVERHEAD * 2U + link * 2U + quantum - 1U) & ~(quantum - 1U);
+#else
+        const size_t quantum = SHINYALLOCATOR_ALIGNMENT * 2U;
+        const size_t fragmentSizeMin = quantum;
+#endif
+#if SHINYALLOCATOR_TLSF
+        const size_t size = (amount + SHINYALLOCATOR_OVERHEAD + quantum - 1U) & ~(quantum - 1U);
+#else
+        size_t size = 1U;
+        while (size < amount + SHINYALLOCATOR_OVERHEAD)
+        {
+            size <<= 1U;
+        }
+#endif
+        return (size < fragmentSizeMin) ? fragmentSizeMin : size;
+    }
+
+    /**
+     * @brief space taken by the allocator instance in front of the pool
+     */
+    size_t instanceFootprint(void)
+    {
+        return (sizeof_shinyAllocatorInstance() + SHINYALLOCATOR_ALIGNMENT - 1U) & ~(SHINYALLOCATOR_ALIGNMENT - 1U);
+    }
+
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+    /**
+     * @brief smallest request served by a direct mapping
+     */
+    size_t largeThreshold(void)
+    {
+#ifdef SHINYALLOCATOR_LARGE_THRESHOLD
+        return SHINYALLOCATOR_LARGE_THRESHOLD;
+#else
+        return KiB * 256;
+#endif
+    }
+
+    /**
+     * @brief number of direct mappings an instance tracks
+     */
+    size_t largeSlots(void)
+    {
+#ifdef SHINYALLOCATOR_LARGE_SLOTS
+        return SHINYALLOCATOR_LARGE_SLOTS;
+#else
+        return 16U;
+#endif
+    }
+#endif
+
+    /**
+     * @brief fragment footprint of a request served by the thread-safe API, magazines round it up to a power of two
+     */
+    size_t threadSafeFootprint(const size_t amount)
+    {
+#if SHINYALLOCATOR_MAGAZINES || SHINYALLOCATOR_PERCPU
+        size_t size = footprint(1U);
+        while (size < footprint(amount))
+        {
+            size <<= 1U;
+        }
+        return size;
+#else
+        return footprint(amount);
+#endif
+    }
+
     /**
      * @brief shinyInit() API test
      */
@@ -35,19 +127,91 @@ namespace
         EXPECT_EQ(shinyGetDiagnostics(pool).peakRequestSize, 0U);
         EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
         pool = shinyInit(arena, 1e3);
+#if SHINYALLOCATOR_TLSF && (SHINYALLOCATOR_OFFSET_BITS != 16)
+        // The second-level bins alone do not fit in such a small arena
+        EXPECT_EQ(pool, (shinyAllocatorInstance *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).capacity, 0U);
+#elif SHINYALLOCATOR_QUICK_LISTS && SHINYALLOCATOR_RESERVE && SHINYALLOCATOR_LARGE_MAPPINGS && !SHINYALLOCATOR_COMPACT_HEADER && \
+    !SHINYALLOCATOR_OFFSET_BITS
+        // The quick list heads, the reservation bounds and the mapping table together leave no room for a fragment
+        EXPECT_EQ(pool, (shinyAllocatorInstance *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).capacity, 0U);
+#elif SHINYALLOCATOR_QUICK_LISTS || SHINYALLOCATOR_RESERVE || SHINYALLOCATOR_HUGE_PAGES || SHINYALLOCATOR_LARGE_MAPPINGS
+        // The quick list heads, the reservation bounds, the mapping size or the mapping table take their share of the
+        // small arena
+        EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
+        EXPECT_GT(shinyGetDiagnostics(pool).capacity, 0U);
+        EXPECT_LE(shinyGetDiagnostics(pool).capacity, 1000U - instanceFootprint());
+#elif SHINYALLOCATOR_COMPACT_HEADER || SHINYALLOCATOR_OFFSET_BITS
+        // The smaller metadata leaves more room for the first fragment
+        EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
+        EXPECT_GE(shinyGetDiagnostics(pool).capacity, 384U);
+#else
         EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
         EXPECT_EQ(shinyGetDiagnostics(pool).capacity, 384U);
+#endif
         EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
         EXPECT_EQ(shinyGetDiagnostics(pool).peakAllocated, 0U);
         EXPECT_EQ(shinyGetDiagnostics(pool).peakRequestSize, 0U);
         EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
     }
 
+    /**
+     * @brief shinyInit() capacity under the configured link width
+     */
+    TEST(shinyInitTest, offsetAddressableCapacityVerification)
+    {
+        const size_t KiB64 = KiB * 64;
+        const size_t arenaSize = KiB64 * 2U;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+
+        auto pool = shinyInit(arena, arenaSize);
+        EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
+        const size_t capacity = shinyGetDiagnostics(pool).capacity;
+#if SHINYALLOCATOR_OFFSET_BITS == 16
+        // The rest of the arena is out of reach of 16-bit offsets, the table of the direct mappings holds full pointers
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        const size_t table = largeSlots() * (sizeof(void *) + sizeof(size_t));
+#else
+        const size_t table = 0U;
+#endif
+#if SHINYALLOCATOR_TLSF
+        EXPECT_LT(sizeof_shinyAllocatorInstance() - table, 400U);
+#else
+        EXPECT_LT(sizeof_shinyAllocatorInstance() - table, 200U);
+#endif
+        EXPECT_LT(capacity, KiB64);
+        EXPECT_GT(capacity, KiB64 - sizeof_shinyAllocatorInstance() - SHINYALLOCATOR_ALIGNMENT * 4U);
+#else
+        EXPECT_GT(capacity, arenaSize - sizeof_shinyAllocatorInstance() - SHINYALLOCATOR_ALIGNMENT * 4U);
+#endif
+
+        // Every block the pool hands out has to be reachable, down to the last one before the end of the arena
+        std::vector<char *> blocks;
+        for (char *block = (char *)shinyAllocate(pool, KiB); block != NULL; block = (char *)shinyAllocate(pool, KiB))
+        {
+            EXPECT_LE((size_t)(block + KiB), ((size_t)arena) + arenaSize);
+            memset(block, 0x5A, KiB);
+            blocks.push_back(block);
+        }
+        EXPECT_GE(blocks.size(), capacity / footprint(KiB) - 1U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, blocks.size() * footprint(KiB));
+        for (auto block : blocks)
+        {
+            shinyFree(pool, block);
+        }
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        free(arena);
+    }
+
     /**
      * @brief shinyAllocate() API test
      */
     TEST(shinyAllocateTest, allocationBoundaryVerification)
     {
+#if SHINYALLOCATOR_OFFSET_BITS == 16
+        GTEST_SKIP() << "the pool does not fit in 16-bit offsets";
+#endif
         const size_t MiB256 = MiB * 256;
         const size_t arenaSize = MiB + MiB256;
         void *arena = (char *)aligned_alloc(64, arenaSize);
@@ -56,17 +220,41 @@ namespace
 
         EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
 
-        EXPECT_GT(shinyGetDiagnostics(pool).capacity, arenaSize - 1024U);
+        EXPECT_GT(shinyGetDiagnostics(pool).capacity, arenaSize - sizeof_shinyAllocatorInstance() - SHINYALLOCATOR_ALIGNMENT * 4U);
         EXPECT_LT(shinyGetDiagnostics(pool).capacity, arenaSize);
         EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0);
 
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        // Requests past the pool get mappings of their own instead of failing and take nothing from the pool
+        void *const beyond = shinyAllocate(pool, arenaSize);
+        EXPECT_NE(beyond, (void *)NULL);
+        EXPECT_GE(shinyGetDiagnostics(pool).mapped, arenaSize);
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
+        shinyFree(pool, beyond);
+        EXPECT_EQ(shinyGetDiagnostics(pool).mapped, 0U);
+
+        EXPECT_EQ(shinyAllocate(pool, 0U), (shinyAllocatorInstance *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).peakAllocated, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).peakRequestSize, arenaSize);
+
+        void *const block = shinyAllocate(pool, MiB256 - SHINYALLOCATOR_OVERHEAD);
+        EXPECT_NE(block, (void *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
+        EXPECT_GE(shinyGetDiagnostics(pool).mapped, MiB256 - SHINYALLOCATOR_OVERHEAD);
+        EXPECT_EQ(shinyGetDiagnostics(pool).peakAllocated, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        shinyFree(pool, block);
+        EXPECT_EQ(shinyGetDiagnostics(pool).mapped, 0U);
+#else
         EXPECT_EQ(shinyAllocate(pool, arenaSize), (shinyAllocatorInstance *)NULL);
         EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 1U);
 
-        EXPECT_EQ(shinyAllocate(pool, arenaSize - SHINYALLOCATOR_ALIGNMENT), (shinyAllocatorInstance *)NULL);
+        EXPECT_EQ(shinyAllocate(pool, arenaSize - SHINYALLOCATOR_OVERHEAD), (shinyAllocatorInstance *)NULL);
         EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 2U);
 
-        EXPECT_EQ(shinyAllocate(pool, shinyGetDiagnostics(pool).capacity - SHINYALLOCATOR_ALIGNMENT + 1U), (shinyAllocatorInstance *)NULL);
+        EXPECT_EQ(shinyAllocate(pool, shinyGetDiagnostics(pool).capacity - SHINYALLOCATOR_OVERHEAD + 1U), (shinyAllocatorInstance *)NULL);
         EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 3U);
 
         EXPECT_EQ(shinyAllocate(pool, arenaSize * 1e4), (shinyAllocatorInstance *)NULL);
@@ -78,21 +266,110 @@ namespace
         EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
         EXPECT_EQ(shinyGetDiagnostics(pool).peakRequestSize, arenaSize * 1e4);
 
-        EXPECT_NE(shinyAllocate(pool, MiB256 - SHINYALLOCATOR_ALIGNMENT), (shinyAllocatorInstance *)NULL);
+        EXPECT_NE(shinyAllocate(pool, MiB256 - SHINYALLOCATOR_OVERHEAD), (shinyAllocatorInstance *)NULL);
         EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 4U);
         EXPECT_EQ(shinyGetDiagnostics(pool).peakAllocated, MiB256);
         EXPECT_EQ(shinyGetDiagnostics(pool).allocated, MiB256);
         EXPECT_EQ(shinyGetDiagnostics(pool).peakRequestSize, arenaSize * 1e4);
+#endif
+
+        free(arena);
+    }
+    /**
+     * @brief shinyAllocate() footprint under the configured bin policy
+     */
+    TEST(shinyAllocateTest, binPolicyFootprintVerification)
+    {
+        const size_t KiB64 = KiB * 64;
+        const size_t arenaSize = KiB64 + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+
+        auto pool = shinyInit(arena, arenaSize);
+        EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
+
+        size_t allocated = 0U;
+        const size_t amounts[] = {1U, 24U, 100U, 1000U, 4U * KiB, 5U * KiB + 3U, 12U * KiB};
+        for (const size_t amount : amounts)
+        {
+            EXPECT_NE(shinyAllocate(pool, amount), (void *)NULL);
+            allocated += footprint(amount);
+            EXPECT_EQ(shinyGetDiagnostics(pool).allocated, allocated);
+        }
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
+        free(arena);
+    }
+
+    /**
+     * @brief randomized allocate/reallocate/free workload, checks payload integrity and full recovery of the pool
+     */
+    TEST(shinyAllocateTest, randomWorkloadVerification)
+    {
+#if SHINYALLOCATOR_OFFSET_BITS == 16
+        GTEST_SKIP() << "the pool does not fit in 16-bit offsets";
+#endif
+        const size_t arenaSize = MiB + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInit(arena, arenaSize);
+        EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
+        const size_t capacity = shinyGetDiagnostics(pool).capacity;
 
+        const size_t slots = 256U;
+        unsigned char *pointers[slots] = {};
+        size_t sizes[slots] = {};
+        unsigned int seed = 2754U;
+        for (size_t step = 0; step < 20000U; step++)
+        {
+            seed = seed * 1103515245U + 12345U;
+            const size_t i = (seed >> 8U) % slots;
+            const size_t amount = 1U + ((seed >> 4U) % ((seed & 1U) ? 64U : 8U * KiB));
+            if (pointers[i] != NULL)
+            {
+                for (size_t k = 0; k < sizes[i]; k++)
+                {
+                    ASSERT_EQ(pointers[i][k], (unsigned char)(i + k));
+                }
+            }
+            if ((pointers[i] != NULL) && ((seed & 6U) == 0U))
+            {
+                auto resized = (unsigned char *)shinyReallocate(pool, pointers[i], amount);
+                if (resized != NULL)
+                {
+                    pointers[i] = resized;
+                    sizes[i] = (amount < sizes[i]) ? amount : sizes[i];
+                }
+            }
+            else if (pointers[i] != NULL)
+            {
+                shinyFree(pool, pointers[i]);
+                pointers[i] = NULL;
+                sizes[i] = 0U;
+            }
+            else
+            {
+                pointers[i] = (unsigned char *)shinyAllocate(pool, amount);
+                sizes[i] = (pointers[i] != NULL) ? amount : 0U;
+            }
+            for (size_t k = 0; k < sizes[i]; k++)
+            {
+                pointers[i][k] = (unsigned char)(i + k);
+            }
+        }
+        for (size_t i = 0; i < slots; i++)
+        {
+            shinyFree(pool, pointers[i]);
+        }
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        EXPECT_NE(shinyAllocate(pool, capacity - SHINYALLOCATOR_OVERHEAD), (void *)NULL);
         free(arena);
     }
+
     /**
      * @brief shinyFree() API test
      */
     TEST(shinyFreeTest, deAllocationLeftRightVerification)
     {
         const size_t KiB4 = KiB * 4;
-        const size_t arenaSize = KiB4 + sizeof_shinyAllocatorInstance() + SHINYALLOCATOR_ALIGNMENT + 1U;
+        const size_t arenaSize = KiB4 + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT + 1U;
         void *arena = (char *)aligned_alloc(128, arenaSize);
 
         auto pool = shinyInit(arena, arenaSize);
@@ -102,17 +379,810 @@ namespace
         EXPECT_EQ(shinyGetDiagnostics(pool).peakAllocated, 0U);
         EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
         EXPECT_EQ(shinyGetDiagnostics(pool).peakRequestSize, 0U);
-        auto ptr = shinyAllocate(pool, KiB4 - SHINYALLOCATOR_ALIGNMENT);
+        auto ptr = shinyAllocate(pool, KiB4 - SHINYALLOCATOR_OVERHEAD);
         EXPECT_NE(ptr, (shinyAllocatorInstance *)NULL);
         EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
         EXPECT_EQ(shinyGetDiagnostics(pool).peakAllocated, KiB4);
-        EXPECT_EQ(shinyGetDiagnostics(pool).peakRequestSize, KiB4 - SHINYALLOCATOR_ALIGNMENT);
+        EXPECT_EQ(shinyGetDiagnostics(pool).peakRequestSize, KiB4 - SHINYALLOCATOR_OVERHEAD);
 
         EXPECT_EQ(shinyGetDiagnostics(pool).allocated, KiB4);
         shinyFree(pool, ptr);
         EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0);
     }
 
+    /**
+     * @brief shinyReallocate() API test
+     */
+    TEST(shinyReallocateTest, inPlaceAndMovedVerification)
+    {
+        const size_t KiB4 = KiB * 4;
+        const size_t arenaSize = KiB4 + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+
+        auto pool = shinyInit(arena, arenaSize);
+        EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).capacity, KiB4);
+
+        auto ptr = (char *)shinyReallocate(pool, NULL, 200U);
+        EXPECT_NE(ptr, (char *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, footprint(200U));
+        memset(ptr, 0xA5, 200U);
+
+        auto grown = (char *)shinyReallocate(pool, ptr, KiB - SHINYALLOCATOR_OVERHEAD);
+        EXPECT_EQ(grown, ptr);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, footprint(KiB - SHINYALLOCATOR_OVERHEAD));
+        EXPECT_EQ(shinyGetDiagnostics(pool).reallocInPlaceCount, 1U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).reallocMovedCount, 0U);
+
+        auto shrunk = (char *)shinyReallocate(pool, grown, 10U);
+        EXPECT_EQ(shrunk, ptr);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, footprint(10U));
+        EXPECT_EQ(shinyGetDiagnostics(pool).reallocInPlaceCount, 2U);
+
+        auto blocker = shinyAllocate(pool, 10U);
+        EXPECT_EQ(blocker, ptr + footprint(10U));
+        auto moved = (char *)shinyReallocate(pool, shrunk, 200U);
+        EXPECT_NE(moved, (char *)NULL);
+        EXPECT_NE(moved, ptr);
+        EXPECT_EQ(shinyGetDiagnostics(pool).reallocMovedCount, 1U);
+        for (size_t i = 0; i < 10U; i++)
+        {
+            EXPECT_EQ((unsigned char)moved[i], 0xA5);
+        }
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, footprint(10U) + footprint(200U));
+
+        EXPECT_EQ(shinyReallocate(pool, moved, KiB4), (void *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, footprint(10U) + footprint(200U));
+
+        EXPECT_EQ(shinyReallocate(pool, moved, 0U), (void *)NULL);
+        shinyFree(pool, blocker);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        EXPECT_NE(shinyAllocate(pool, KiB4 - SHINYALLOCATOR_OVERHEAD), (void *)NULL);
+        free(arena);
+    }
+
+    /**
+     * @brief shinyAllocateAligned() API test
+     */
+    TEST(shinyAllocateAlignedTest, alignmentAndBoundaryVerification)
+    {
+#if SHINYALLOCATOR_OFFSET_BITS == 16
+        GTEST_SKIP() << "the pool does not fit in 16-bit offsets";
+#endif
+        const size_t KiB64 = KiB * 64;
+        const size_t arenaSize = KiB64 + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+
+        auto pool = shinyInit(arena, arenaSize);
+        EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
+        const size_t capacity = shinyGetDiagnostics(pool).capacity;
+
+        EXPECT_EQ(shinyAllocateAligned(pool, 16U, 3U, 0U), (void *)NULL);
+        EXPECT_EQ(shinyAllocateAligned(pool, 200U, 0U, 128U), (void *)NULL);
+
+        auto small = shinyAllocate(pool, 16U);
+        EXPECT_NE(small, (void *)NULL);
+        EXPECT_EQ(((size_t)small) % SHINYALLOCATOR_ALIGNMENT, 0U);
+
+        auto page = shinyAllocateAligned(pool, 4U * KiB, 4U * KiB, 0U);
+        EXPECT_NE(page, (void *)NULL);
+        EXPECT_EQ(((size_t)page) % (4U * KiB), 0U);
+
+        auto line = shinyAllocateAligned(pool, 100U, 256U, 0U);
+        EXPECT_NE(line, (void *)NULL);
+        EXPECT_EQ(((size_t)line) % 256U, 0U);
+
+        auto dma = (char *)shinyAllocateAligned(pool, 700U, 0U, 1024U);
+        EXPECT_NE(dma, (char *)NULL);
+        EXPECT_EQ(((size_t)dma) / 1024U, ((size_t)(dma + 699U)) / 1024U);
+
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
+        shinyFree(pool, small);
+        shinyFree(pool, page);
+        shinyFree(pool, line);
+        shinyFree(pool, dma);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        EXPECT_NE(shinyAllocate(pool, capacity - SHINYALLOCATOR_OVERHEAD), (void *)NULL);
+        free(arena);
+    }
+
+    /**
+     * @brief shinyAllocateBatch() and shinyFreeBatch() API test
+     */
+    TEST(shinyBatchTest, allOrNothingVerification)
+    {
+        const size_t KiB4 = KiB * 4;
+        const size_t arenaSize = KiB4 + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+
+        auto pool = shinyInit(arena, arenaSize);
+        EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
+
+        void *blocks[64];
+        EXPECT_EQ(shinyAllocateBatch(pool, 256U - SHINYALLOCATOR_OVERHEAD, 17U, blocks), SHINYALLOCATOR_ERROR);
+        EXPECT_EQ(blocks[0], (void *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).peakAllocated, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 1U);
+
+        EXPECT_EQ(shinyAllocateBatch(pool, 256U - SHINYALLOCATOR_OVERHEAD, 16U, blocks), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, KiB4);
+        for (size_t i = 0; i < 8U; i++)
+        {
+            void *tmp = blocks[i];
+            blocks[i] = blocks[15U - i];
+            blocks[15U - i] = tmp;
+        }
+        blocks[3] = NULL;
+        void *kept = blocks[7];
+        blocks[7] = NULL;
+        shinyFreeBatch(pool, blocks, 16U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 512U);
+        EXPECT_EQ((size_t)blocks[0], 0U);
+
+        blocks[0] = kept;
+        for (size_t i = 1U; i < 16U; i++)
+        {
+            blocks[i] = NULL;
+        }
+        shinyFreeBatch(pool, blocks, 16U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 256U);
+        EXPECT_EQ(shinyAllocateBatch(pool, KiB - SHINYALLOCATOR_OVERHEAD, 3U, blocks), SHINYALLOCATOR_OK);
+
+        // A shuffled batch of the smallest blocks is sorted back and coalesces the whole pool
+        pool = shinyInit(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorInstance *)NULL);
+        const size_t amount = SHINYALLOCATOR_ALIGNMENT;
+        size_t count = KiB4 / footprint(amount);
+        count = (count < 64U) ? count : 64U;
+        ASSERT_EQ(shinyAllocateBatch(pool, amount, count, blocks), SHINYALLOCATOR_OK);
+        size_t state = 1U;
+        for (size_t i = count - 1U; i > 0U; i--)
+        {
+            state = state * 6364136223846793005U + 1442695040888963407U;
+            const size_t j = (state >> 33U) % (i + 1U);
+            void *tmp = blocks[i];
+            blocks[i] = blocks[j];
+            blocks[j] = tmp;
+        }
+        shinyFreeBatch(pool, blocks, count);
+        for (size_t i = 1U; i < count; i++)
+        {
+            EXPECT_LT((size_t)blocks[i - 1U], (size_t)blocks[i]);
+        }
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        EXPECT_NE(shinyAllocate(pool, shinyGetDiagnostics(pool).capacity - SHINYALLOCATOR_OVERHEAD), (void *)NULL);
+        free(arena);
+    }
+
+    /**
+     * @brief shinyAddRegion() API test, regions separated by gaps feed the same bins but are never coalesced
+     */
+    TEST(shinyRegionTest, disjointRegionsVerification)
+    {
+        const size_t KiB8 = KiB * 8;
+        const size_t arenaSize = KiB * 32;
+        char *arena = (char *)aligned_alloc(128, arenaSize);
+        // The pool and two regions with gaps in between, all of them within reach of 16-bit offsets
+        auto pool = shinyInit(arena, instanceFootprint() + KiB);
+        ASSERT_NE(pool, (shinyAllocatorInstance *)NULL);
+        const size_t primary = shinyGetDiagnostics(pool).capacity;
+        char *const regionA = arena + KiB8;
+        char *const regionB = arena + KiB8 * 2U + KiB;
+        EXPECT_EQ(shinyAddRegion(pool, NULL, KiB8), SHINYALLOCATOR_ERROR);
+        EXPECT_EQ(shinyAddRegion(pool, regionA, 8U), SHINYALLOCATOR_ERROR);
+        EXPECT_EQ(shinyGetDiagnostics(pool).capacity, primary);
+        ASSERT_EQ(shinyAddRegion(pool, regionA, KiB8), SHINYALLOCATOR_OK);
+        ASSERT_EQ(shinyAddRegion(pool, regionB + 3U, KiB8 - 3U), SHINYALLOCATOR_OK);
+        const size_t capacity = shinyGetDiagnostics(pool).capacity;
+        EXPECT_GT(capacity, primary + KiB8);
+        EXPECT_LE(capacity, primary + 2U * KiB8);
+
+        // Larger than the pool but within a region
+        char *large = (char *)shinyAllocate(pool, 2U * KiB);
+        ASSERT_NE(large, (char *)NULL);
+        EXPECT_TRUE(((large >= regionA) && (large < regionA + KiB8)) || ((large >= regionB) && (large < regionB + KiB8)));
+        EXPECT_EQ(((size_t)large) % SHINYALLOCATOR_ALIGNMENT, 0U);
+        shinyFree(pool, large);
+        // Nothing spans a gap, however much space is left in total
+        EXPECT_EQ(shinyAllocate(pool, KiB8), (void *)NULL);
+
+        const size_t amount = 40U;
+        std::vector<char *> blocks;
+        for (char *block = (char *)shinyAllocate(pool, amount); block != NULL; block = (char *)shinyAllocate(pool, amount))
+        {
+            const bool inPool = (block > arena) && (block + amount <= arena + instanceFootprint() + KiB);
+            const bool inA = (block >= regionA) && (block + amount <= regionA + KiB8);
+            const bool inB = (block >= regionB + 3U) && (block + amount <= regionB + KiB8);
+            ASSERT_TRUE(inPool || inA || inB);
+            memset(block, (int)blocks.size(), amount);
+            blocks.push_back(block);
+        }
+        EXPECT_GT(blocks.size(), (2U * KiB8) / footprint(amount) - 2U);
+        for (size_t i = 0; i < blocks.size(); i++)
+        {
+            EXPECT_EQ(blocks[i][amount - 1U], (char)i);
+            shinyFree(pool, blocks[i]);
+        }
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        // Each region coalesced back into one fragment that holds half of it
+        char *const halfA = (char *)shinyAllocate(pool, KiB8 / 2U - SHINYALLOCATOR_OVERHEAD);
+        char *const halfB = (char *)shinyAllocate(pool, KiB8 / 2U - SHINYALLOCATOR_OVERHEAD);
+        ASSERT_NE(halfA, (char *)NULL);
+        ASSERT_NE(halfB, (char *)NULL);
+        EXPECT_NE((halfA < regionB), (halfB < regionB));
+        free(arena);
+    }
+
+#if SHINYALLOCATOR_RESERVE
+    /**
+     * @brief shinyInitReserved() API test, the pool commits its reservation on demand and grows its top in place
+     */
+    TEST(shinyReserveTest, commitOnDemandVerification)
+    {
+#if SHINYALLOCATOR_OFFSET_BITS == 16
+        GTEST_SKIP() << "the reservation does not fit in 16-bit offsets";
+#endif
+        const size_t KiB256 = KiB * 256;
+        auto pool = shinyInitReserved(MiB * 64, KiB * 64);
+        ASSERT_NE(pool, (shinyAllocatorInstance *)NULL);
+        const size_t initial = shinyGetDiagnostics(pool).capacity;
+        EXPECT_LT(initial, KiB * 64);
+        // Nothing beyond the reservation is ever committed
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        void *const beyond = shinyAllocate(pool, MiB * 128);
+        EXPECT_NE(beyond, (void *)NULL);
+        EXPECT_GE(shinyGetDiagnostics(pool).mapped, MiB * 128);
+        shinyFree(pool, beyond);
+        EXPECT_EQ(shinyGetDiagnostics(pool).mapped, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
+#else
+        EXPECT_EQ(shinyAllocate(pool, MiB * 128), (void *)NULL);
+#endif
+        EXPECT_EQ(shinyGetDiagnostics(pool).capacity, initial);
+
+        char *const block = (char *)shinyAllocate(pool, KiB256);
+        ASSERT_NE(block, (char *)NULL);
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        // The block is mapped on its own and commits nothing of the reservation
+        EXPECT_EQ(shinyGetDiagnostics(pool).capacity, initial);
+        EXPECT_GE(shinyGetDiagnostics(pool).mapped, KiB256);
+#else
+        EXPECT_GT(shinyGetDiagnostics(pool).capacity, initial + KiB256);
+        EXPECT_LT(shinyGetDiagnostics(pool).capacity, MiB * 2);
+#endif
+        memset(block, 0x5A, KiB256);
+        char *const grown = (char *)shinyReallocate(pool, block, MiB * 2);
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        // The mapping is resized by the kernel, which may move it
+        EXPECT_EQ(shinyGetDiagnostics(pool).reallocInPlaceCount + shinyGetDiagnostics(pool).reallocMovedCount, 1U);
+        EXPECT_GE(shinyGetDiagnostics(pool).mapped, MiB * 2);
+        EXPECT_EQ(shinyGetDiagnostics(pool).capacity, initial);
+        const size_t committed = 0U;
+#else
+        // The top block is extended over the next granules without moving it
+        EXPECT_EQ(grown, block);
+        EXPECT_EQ(shinyGetDiagnostics(pool).reallocInPlaceCount, 1U);
+        const size_t committed = MiB * 2;
+#endif
+        ASSERT_NE(grown, (char *)NULL);
+        EXPECT_EQ(grown[KiB256 - 1U], 0x5A);
+        memset(grown, 0x3C, MiB * 2);
+
+        const size_t amount = 3000U;
+        std::vector<char *> blocks;
+        for (size_t i = 0; i < 1000U; i++)
+        {
+            char *const small = (char *)shinyAllocate(pool, amount);
+            ASSERT_NE(small, (char *)NULL);
+            memset(small, (int)i, amount);
+            blocks.push_back(small);
+        }
+        const size_t capacity = shinyGetDiagnostics(pool).capacity;
+        EXPECT_GE(capacity, committed + 1000U * footprint(amount));
+        EXPECT_LT(capacity, MiB * 16);
+        for (size_t i = 0; i < blocks.size(); i++)
+        {
+            EXPECT_EQ(blocks[i][amount - 1U], (char)i);
+            shinyFree(pool, blocks[i]);
+        }
+        shinyFree(pool, grown);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        EXPECT_EQ(shinyGetDiagnostics(pool).mapped, 0U);
+#endif
+        // Committed pages stay in the pool
+        EXPECT_NE(shinyAllocate(pool, MiB * 2), (void *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).capacity, capacity);
+        EXPECT_EQ(shinyDeinitReserved(pool), SHINYALLOCATOR_OK);
+
+        const size_t arenaSize = KiB * 4 + instanceFootprint();
+        void *arena = aligned_alloc(128, arenaSize);
+        EXPECT_EQ(shinyDeinitReserved(shinyInit(arena, arenaSize)), SHINYALLOCATOR_ERROR);
+        free(arena);
+    }
+#endif
+
+#if SHINYALLOCATOR_HUGE_PAGES
+    /**
+     * @brief shinyInitHuge() API test, blocks of at least a huge page start on a huge page boundary
+     */
+    TEST(shinyHugePageTest, hugePageAlignmentVerification)
+    {
+#if SHINYALLOCATOR_OFFSET_BITS == 16
+        GTEST_SKIP() << "a huge page does not fit in 16-bit offsets";
+#endif
+#ifdef SHINYALLOCATOR_HUGE_PAGE_SIZE
+        const size_t huge = SHINYALLOCATOR_HUGE_PAGE_SIZE;
+#else
+        const size_t huge = MiB * 2;
+#endif
+        auto pool = shinyInitHuge(huge * 8 - 1U);
+        ASSERT_NE(pool, (shinyAllocatorInstance *)NULL);
+        EXPECT_EQ(((size_t)pool) % huge, 0U);
+        EXPECT_GT(shinyGetDiagnostics(pool).capacity, huge * 7);
+
+        char *const small = (char *)shinyAllocate(pool, 100U);
+        ASSERT_NE(small, (char *)NULL);
+        char *const large = (char *)shinyAllocate(pool, huge + huge / 2U);
+        ASSERT_NE(large, (char *)NULL);
+        memset(large, 0x5A, huge + huge / 2U);
+        char *const exact = (char *)shinyAllocate(pool, huge);
+        ASSERT_NE(exact, (char *)NULL);
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        // Blocks past the threshold are mapped on their own, on a page boundary, and take nothing from the pool
+        EXPECT_EQ(((size_t)large) % 4096U, 0U);
+        EXPECT_EQ(((size_t)exact) % 4096U, 0U);
+        EXPECT_GE(shinyGetDiagnostics(pool).mapped, huge * 2 + huge / 2U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, footprint(100U));
+#else
+        EXPECT_EQ(((size_t)large) % huge, 0U);
+        EXPECT_EQ(((size_t)exact) % huge, 0U);
+        // The space skipped in front of the aligned blocks is returned to the bins
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, footprint(100U) + footprint(huge + huge / 2U) + footprint(huge));
+#endif
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
+        char *const gap = (char *)shinyAllocate(pool, KiB * 64);
+        ASSERT_NE(gap, (char *)NULL);
+        EXPECT_EQ(large[huge + huge / 2U - 1U], 0x5A);
+
+        shinyFree(pool, gap);
+        shinyFree(pool, exact);
+        shinyFree(pool, large);
+        shinyFree(pool, small);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        EXPECT_EQ(shinyDeinitHuge(pool), SHINYALLOCATOR_OK);
+
+        const size_t arenaSize = KiB * 4 + instanceFootprint();
+        void *arena = aligned_alloc(128, arenaSize);
+        EXPECT_EQ(shinyDeinitHuge(shinyInit(arena, arenaSize)), SHINYALLOCATOR_ERROR);
+        free(arena);
+    }
+#endif
+
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+    /**
+     * @brief Large block API test, blocks past the threshold get mappings of their own which are resized in place
+     */
+    TEST(shinyLargeMappingTest, mapUnmapRemapVerification)
+    {
+        const size_t threshold = largeThreshold();
+        const size_t arenaSize = KiB * 32 + instanceFootprint();
+        char *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInit(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorInstance *)NULL);
+
+        // The block does not fit into the pool at all
+        char *const large = (char *)shinyAllocate(pool, threshold);
+        ASSERT_NE(large, (char *)NULL);
+        EXPECT_EQ(((size_t)large) % 4096U, 0U);
+        EXPECT_GE(shinyGetDiagnostics(pool).mapped, threshold);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        memset(large, 0x5A, threshold);
+        char *const small = (char *)shinyAllocate(pool, 100U);
+        ASSERT_NE(small, (char *)NULL);
+        EXPECT_TRUE((small > arena) && (small < arena + arenaSize));
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, footprint(100U));
+
+        char *const grown = (char *)shinyReallocate(pool, large, MiB * 8);
+        ASSERT_NE(grown, (char *)NULL);
+        EXPECT_EQ(grown[threshold - 1U], 0x5A);
+        EXPECT_GE(shinyGetDiagnostics(pool).mapped, MiB * 8);
+        EXPECT_EQ(shinyGetDiagnostics(pool).reallocInPlaceCount + shinyGetDiagnostics(pool).reallocMovedCount, 1U);
+        memset(grown + threshold, 0x3C, MiB * 8 - threshold);
+        // Shrinking below the threshold moves the block into the pool
+        char *const shrunk = (char *)shinyReallocate(pool, grown, 1000U);
+        ASSERT_NE(shrunk, (char *)NULL);
+        EXPECT_TRUE((shrunk > arena) && (shrunk < arena + arenaSize));
+        EXPECT_EQ(shrunk[999], 0x5A);
+        EXPECT_EQ(shinyGetDiagnostics(pool).mapped, 0U);
+        // Growing past it moves the block out again
+        char *const again = (char *)shinyReallocate(pool, shrunk, threshold * 2U);
+        ASSERT_NE(again, (char *)NULL);
+        EXPECT_EQ(again[999], 0x5A);
+        EXPECT_GE(shinyGetDiagnostics(pool).mapped, threshold * 2U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, footprint(100U));
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
+        // The mapping still outstanding is released by the deinitialization, the pool stays usable
+        EXPECT_EQ(shinyDeinit(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnostics(pool).mapped, 0U);
+        EXPECT_EQ(shinyDeinit(NULL), SHINYALLOCATOR_ERROR);
+
+        // Once the table is full large requests fall back to the bins, where they do not fit
+        std::vector<void *> blocks;
+        for (size_t i = 0; i < largeSlots(); i++)
+        {
+            blocks.push_back(shinyAllocate(pool, threshold));
+            ASSERT_NE(blocks.back(), (void *)NULL);
+        }
+        EXPECT_EQ(shinyAllocate(pool, threshold), (void *)NULL);
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 1U);
+        blocks.push_back(small);
+        shinyFreeBatch(pool, blocks.data(), blocks.size());
+        EXPECT_EQ(shinyGetDiagnostics(pool).mapped, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+
+        // A large block placed in the bins while the table was full shrinks in place instead of being mapped
+        const size_t bigArenaSize = threshold * 8U + instanceFootprint();
+        char *bigArena = (char *)aligned_alloc(128, bigArenaSize);
+        auto bigPool = shinyInit(bigArena, bigArenaSize);
+        ASSERT_NE(bigPool, (shinyAllocatorInstance *)NULL);
+        blocks.clear();
+        for (size_t i = 0; i < largeSlots(); i++)
+        {
+            blocks.push_back(shinyAllocate(bigPool, threshold));
+            ASSERT_NE(blocks.back(), (void *)NULL);
+        }
+        char *const placed = (char *)shinyAllocate(bigPool, threshold * 2U);
+        ASSERT_NE(placed, (char *)NULL);
+        EXPECT_TRUE((placed > bigArena) && (placed < bigArena + bigArenaSize));
+        shinyFree(bigPool, blocks.back());
+        blocks.pop_back();
+        const size_t mapped = shinyGetDiagnostics(bigPool).mapped;
+        EXPECT_EQ(shinyReallocate(bigPool, placed, threshold + KiB), placed);
+        EXPECT_EQ(shinyGetDiagnostics(bigPool).mapped, mapped);
+        EXPECT_EQ(shinyGetDiagnostics(bigPool).allocated, footprint(threshold + KiB));
+        EXPECT_EQ(shinyGetDiagnostics(bigPool).reallocInPlaceCount, 1U);
+        EXPECT_EQ(shinyGetDiagnostics(bigPool).reallocMovedCount, 0U);
+        blocks.push_back(placed);
+        shinyFreeBatch(bigPool, blocks.data(), blocks.size());
+        EXPECT_EQ(shinyGetDiagnostics(bigPool).mapped, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(bigPool).allocated, 0U);
+        free(bigArena);
+
+        // The thread caches leave mapped blocks alone
+        auto threadSafePool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(threadSafePool, (shinyAllocatorThreadSafeInstance *)NULL);
+        void *const shared = shinyAllocateThreadSafe(threadSafePool, threshold);
+        ASSERT_NE(shared, (void *)NULL);
+        EXPECT_EQ(shinyFreeThreadSafe(threadSafePool, shared), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(threadSafePool).mapped, 0U);
+        ASSERT_NE(shinyAllocateThreadSafe(threadSafePool, threshold), (void *)NULL);
+        EXPECT_GE(shinyGetDiagnosticsThreadSafe(threadSafePool).mapped, threshold);
+        // The deinitialization unmaps the block left behind
+        EXPECT_EQ(shinyDeinitThreadSafe(threadSafePool), SHINYALLOCATOR_OK);
+        // Mapped blocks lie outside of every shard
+        auto sharded = shinyInitSharded(arena, arenaSize, 2U);
+        ASSERT_NE(sharded, (shinyAllocatorShardedInstance *)NULL);
+        void *const distant = shinyAllocateSharded(sharded, threshold);
+        ASSERT_NE(distant, (void *)NULL);
+        EXPECT_EQ(shinyFreeSharded(sharded, distant), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyDeinitSharded(sharded), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+#endif
+
+#if SHINYALLOCATOR_PURGE
+    /**
+     * @param begin first byte of the range
+     * @param end end of the range
+     * @return number of resident pages which lie completely within the range
+     */
+    size_t residentPages(const char *const begin, const char *const end)
+    {
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        const size_t lo = ((size_t)begin + page - 1U) & ~(page - 1U);
+        const size_t hi = (size_t)end & ~(page - 1U);
+        size_t resident = 0U;
+        if (lo < hi)
+        {
+            std::vector<unsigned char> vector((hi - lo) / page);
+            if (mincore((void *)lo, hi - lo, vector.data()) == 0)
+            {
+                for (const unsigned char pageStatus : vector)
+                {
+                    resident += pageStatus & 1U;
+                }
+            }
+        }
+        return resident;
+    }
+
+    /**
+     * @brief shinyTrim() API test, the pages of large free fragments are returned to the OS exactly once
+     */
+    TEST(shinyPurgeTest, residentAndPurgedVerification)
+    {
+#if SHINYALLOCATOR_OFFSET_BITS == 16
+        GTEST_SKIP() << "the pool does not fit in 16-bit offsets";
+#endif
+#if defined(SHINYALLOCATOR_PURGE_THRESHOLD) && (SHINYALLOCATOR_PURGE_THRESHOLD == 0)
+        GTEST_SKIP() << "releases are only purged by shinyTrim()";
+#endif
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        GTEST_SKIP() << "the large blocks of the test are mapped instead of placed in the pool";
+#endif
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        const size_t arenaSize = MiB * 4;
+        char *arena = (char *)aligned_alloc(page, arenaSize);
+        auto pool = shinyInit(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorInstance *)NULL);
+        const size_t capacity = shinyGetDiagnostics(pool).capacity;
+        EXPECT_EQ(shinyGetDiagnostics(pool).purged, 0U);
+
+        char *const large = (char *)shinyAllocate(pool, MiB);
+        char *const guard = (char *)shinyAllocate(pool, 64U);
+        ASSERT_NE(guard, (char *)NULL);
+        memset(large, 0x5A, MiB);
+        EXPECT_GE(residentPages(large, large + MiB), MiB / page - 1U);
+        // The released fragment is large enough to be purged right away
+        shinyFree(pool, large);
+        const size_t purged = shinyGetDiagnostics(pool).purged;
+        EXPECT_GE(purged, MiB - 2U * page);
+        EXPECT_LE(residentPages(large, large + MiB), 2U);
+
+        // The rest of the pool is purged on demand, and only once
+        const size_t trimmed = shinyTrim(pool);
+        EXPECT_GT(trimmed, 0U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).purged, purged + trimmed);
+        EXPECT_EQ(shinyTrim(pool), 0U);
+        const size_t resident = capacity - shinyGetDiagnostics(pool).allocated - shinyGetDiagnostics(pool).purged;
+        EXPECT_LT(resident, 8U * page);
+
+        // Purged pages are faulted in again once allocated
+        char *const again = (char *)shinyAllocate(pool, MiB);
+        ASSERT_NE(again, (char *)NULL);
+        EXPECT_LE(shinyGetDiagnostics(pool).purged, purged + trimmed - MiB);
+        memset(again, 0x3C, MiB);
+        EXPECT_EQ(again[MiB - 1U], 0x3C);
+        EXPECT_GE(residentPages(again, again + MiB), MiB / page - 1U);
+        shinyFree(pool, again);
+        shinyFree(pool, guard);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        EXPECT_EQ(shinyTrim(pool), 0U);
+        EXPECT_GE(shinyGetDiagnostics(pool).purged, capacity - 2U * page);
+        free(arena);
+    }
+#endif
+
+#if SHINYALLOCATOR_QUICK_LISTS
+    /**
+     * @brief Released blocks of the quick sizes are reused without merging and splitting and coalesced on demand
+     */
+    TEST(shinyQuickListTest, deferredCoalescingVerification)
+    {
+#if SHINYALLOCATOR_OFFSET_BITS == 16
+        GTEST_SKIP() << "the pool does not fit in 16-bit offsets";
+#endif
+        const size_t arenaSize = MiB + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInit(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorInstance *)NULL);
+        const size_t amount = 24U;
+
+        void *left = shinyAllocate(pool, amount);
+        void *middle = shinyAllocate(pool, amount);
+        void *right = shinyAllocate(pool, amount);
+        ASSERT_NE(right, (void *)NULL);
+        shinyFree(pool, middle);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 2U * footprint(amount));
+        EXPECT_EQ(shinyGetDiagnostics(pool).mergeSavedCount, 0U);
+        // The same block comes back without touching the bins
+        EXPECT_EQ(shinyAllocate(pool, amount), middle);
+        EXPECT_EQ(shinyGetDiagnostics(pool).splitSavedCount, 1U);
+        shinyFree(pool, right);
+        EXPECT_EQ(shinyGetDiagnostics(pool).mergeSavedCount, 1U);
+
+        // An alloc-free loop of one size neither merges nor splits
+        for (size_t i = 0; i < 1000U; i++)
+        {
+            void *block = shinyAllocate(pool, amount);
+            ASSERT_NE(block, (void *)NULL);
+            memset(block, (int)i, amount);
+            shinyFree(pool, block);
+        }
+        EXPECT_EQ(shinyGetDiagnostics(pool).splitSavedCount, 1001U);
+        shinyFree(pool, middle);
+        shinyFree(pool, left);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+
+        // The whole pool is only available once the quick lists are coalesced
+        void *whole = shinyAllocate(pool, shinyGetDiagnostics(pool).capacity / 2U + 1U);
+        ASSERT_NE(whole, (void *)NULL);
+        shinyFree(pool, whole);
+
+        // Exceeding the limit coalesces the lists in bulk
+        const size_t count = 200U;
+        static void *blocks[count];
+        for (size_t i = 0; i < count; i++)
+        {
+            blocks[i] = shinyAllocate(pool, amount << (i % 3U));
+            ASSERT_NE(blocks[i], (void *)NULL);
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            shinyFree(pool, blocks[i]);
+        }
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        EXPECT_GT(shinyGetDiagnostics(pool).mergeSavedCount, 1U);
+        EXPECT_EQ(shinyGetDiagnostics(pool).outOfMemeoryCount, 0U);
+        whole = shinyAllocate(pool, shinyGetDiagnostics(pool).capacity / 2U + 1U);
+        EXPECT_NE(whole, (void *)NULL);
+        free(arena);
+    }
+#endif
+
+    /**
+     * @brief shinySlabAllocate() and shinySlabFree() API test
+     */
+    TEST(shinySlabTest, smallObjectDensityVerification)
+    {
+        const size_t KiB64 = KiB * 64;
+        const size_t arenaSize = KiB64 + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInit(arena, arenaSize);
+        EXPECT_NE(pool, (shinyAllocatorInstance *)NULL);
+
+        auto slab = shinySlabInit(pool);
+        EXPECT_NE(slab, (shinySlabInstance *)NULL);
+        const size_t baseline = shinyGetDiagnostics(pool).allocated;
+        EXPECT_EQ(shinySlabAllocate(slab, 0U), (void *)NULL);
+        EXPECT_EQ(shinySlabAllocate(slab, KiB), (void *)NULL);
+
+        const size_t count = 1000U;
+        static size_t *objects[count];
+        size_t general = 0U;
+        for (size_t i = 0; i < count; i++)
+        {
+            const size_t amount = (i % 3U) ? 2U * sizeof(size_t) : sizeof(size_t);
+            general += footprint(amount);
+            objects[i] = (size_t *)shinySlabAllocate(slab, amount);
+            ASSERT_NE(objects[i], (size_t *)NULL);
+            EXPECT_EQ(((size_t)objects[i]) % sizeof(void *), 0U);
+            objects[i][0] = i;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            EXPECT_EQ(objects[i][0], i);
+        }
+        EXPECT_LT(shinyGetDiagnostics(pool).allocated - baseline, general);
+        if (footprint(sizeof(size_t)) >= sizeof(size_t) * 4U)
+        {
+            // With heavy per-block metadata the slabs are more than twice as dense
+            EXPECT_LT(shinyGetDiagnostics(pool).allocated - baseline, general / 2U);
+        }
+
+        for (size_t i = 0; i < count; i += 2U)
+        {
+            shinySlabFree(slab, objects[i]);
+        }
+        for (size_t i = 0; i < count; i += 2U)
+        {
+            objects[i] = (size_t *)shinySlabAllocate(slab, (i % 3U) ? 2U * sizeof(size_t) : sizeof(size_t));
+            ASSERT_NE(objects[i], (size_t *)NULL);
+            objects[i][0] = i;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            EXPECT_EQ(objects[i][0], i);
+            shinySlabFree(slab, objects[i]);
+        }
+        EXPECT_LE(shinyGetDiagnostics(pool).allocated - baseline, 2U * KiB);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            EXPECT_NE(shinySlabAllocate(slab, sizeof(size_t)), (void *)NULL);
+        }
+        shinySlabDeinit(slab);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        free(arena);
+    }
+
+#if SHINYALLOCATOR_BLOCK_POOL
+    /**
+     * @brief shinyBlockPoolAllocate() and shinyBlockPoolFree() API test, alone and under contention
+     */
+    TEST(shinyBlockPoolTest, lockFreeStackVerification)
+    {
+        const size_t arenaSize = KiB * 64 + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInit(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorInstance *)NULL);
+        EXPECT_EQ(shinyBlockPoolInit(pool, 0U, 8U), (shinyBlockPoolInstance *)NULL);
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        // Storage past the threshold is mapped instead
+        auto mapped = shinyBlockPoolInit(pool, 24U, KiB * KiB);
+        EXPECT_NE(mapped, (shinyBlockPoolInstance *)NULL);
+        shinyBlockPoolDeinit(mapped);
+        EXPECT_EQ(shinyGetDiagnostics(pool).mapped, 0U);
+#else
+        EXPECT_EQ(shinyBlockPoolInit(pool, 24U, KiB * KiB), (shinyBlockPoolInstance *)NULL);
+#endif
+
+        const size_t count = 256U;
+        auto blocks = shinyBlockPoolInit(pool, 20U, count);
+        ASSERT_NE(blocks, (shinyBlockPoolInstance *)NULL);
+        std::vector<size_t *> taken(count, (size_t *)NULL);
+        for (size_t i = 0; i < count; i++)
+        {
+            taken[i] = (size_t *)shinyBlockPoolAllocate(blocks);
+            ASSERT_NE(taken[i], (size_t *)NULL);
+            EXPECT_EQ(((size_t)taken[i]) % sizeof(void *), 0U);
+            memset(taken[i], 0xA5, 20U);
+            taken[i][0] = i;
+        }
+        EXPECT_EQ(shinyBlockPoolAllocate(blocks), (void *)NULL);
+        for (size_t i = 0; i < count; i++)
+        {
+            EXPECT_EQ(taken[i][0], i);
+        }
+        EXPECT_EQ(shinyBlockPoolFree(blocks, ((char *)taken[1]) + 1U), SHINYALLOCATOR_ERROR);
+        EXPECT_EQ(shinyBlockPoolFree(blocks, arena), SHINYALLOCATOR_ERROR);
+        EXPECT_EQ(shinyBlockPoolFree(blocks, NULL), SHINYALLOCATOR_OK);
+        for (size_t i = 0; i < count; i++)
+        {
+            EXPECT_EQ(shinyBlockPoolFree(blocks, taken[i]), SHINYALLOCATOR_OK);
+        }
+
+        const size_t threads = 4U;
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([blocks, t]()
+                                 {
+                const size_t ring = 16U;
+                std::vector<size_t *> held(ring, (size_t *)NULL);
+                for (size_t i = 0; i < 20000U; i++)
+                {
+                    const size_t r = (i * 7U) % ring;
+                    if (held[r] != NULL)
+                    {
+                        // A block handed to two threads at once would be overwritten here
+                        ASSERT_EQ(held[r][0], (t << 16U) | r);
+                        ASSERT_EQ(held[r][1], ~((t << 16U) | r));
+                        ASSERT_EQ(shinyBlockPoolFree(blocks, held[r]), SHINYALLOCATOR_OK);
+                    }
+                    held[r] = (size_t *)shinyBlockPoolAllocate(blocks);
+                    ASSERT_NE(held[r], (size_t *)NULL);
+                    held[r][0] = (t << 16U) | r;
+                    held[r][1] = ~((t << 16U) | r);
+                }
+                for (auto block : held)
+                {
+                    EXPECT_EQ(shinyBlockPoolFree(blocks, block), SHINYALLOCATOR_OK);
+                } });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        // Every block made it back exactly once
+        for (size_t i = 0; i < count; i++)
+        {
+            taken[i] = (size_t *)shinyBlockPoolAllocate(blocks);
+            ASSERT_NE(taken[i], (size_t *)NULL);
+            for (size_t j = 0; j < i; j++)
+            {
+                ASSERT_NE(taken[i], taken[j]);
+            }
+        }
+        EXPECT_EQ(shinyBlockPoolAllocate(blocks), (void *)NULL);
+        shinyBlockPoolDeinit(blocks);
+        EXPECT_EQ(shinyGetDiagnostics(pool).allocated, 0U);
+        free(arena);
+    }
+#endif
+
     /**
      * @brief shinyXSafeThread() API test
      */
@@ -129,19 +1199,822 @@ namespace
         EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakAllocated, 0U);
         EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
         EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakRequestSize, 0U);
-        auto ptr = shinyAllocateThreadSafe(pool, KiB256);
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        // A request of the whole arena would be mapped, one just short of the threshold does not fit either
+        const size_t tooLarge = largeThreshold() - 1U;
+#else
+        const size_t tooLarge = KiB256;
+#endif
+        auto ptr = shinyAllocateThreadSafe(pool, tooLarge);
         EXPECT_EQ(ptr, (shinyAllocatorThreadSafeInstance *)NULL);
         EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).outOfMemeoryCount, 1U);
         EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakAllocated, 0);
-        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakRequestSize, KiB256);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakRequestSize, tooLarge);
 
         ptr = shinyAllocateThreadSafe(pool, 256);
         EXPECT_NE(ptr, (shinyAllocatorThreadSafeInstance *)NULL);
         EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).outOfMemeoryCount, 1U);
-        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakAllocated, 512);
-        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakRequestSize, KiB256);
-        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 512);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakAllocated, threadSafeFootprint(256));
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakRequestSize, tooLarge);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, threadSafeFootprint(256));
         shinyFreeThreadSafe(pool, ptr);
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
         EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+
+    /**
+     * @brief shinyAllocateThreadSafe() and shinyFreeThreadSafe() under concurrent churn
+     */
+    TEST(shinyThreadCacheTest, concurrentChurnVerification)
+    {
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+
+        const size_t threads = 4U;
+        const size_t steps = 20000U;
+        std::vector<std::thread> workers;
+        std::vector<size_t> corrupted(threads, 0U);
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([pool, t, steps, &corrupted]()
+                                 {
+                const size_t slots = 32U;
+                unsigned char *live[slots] = {};
+                size_t sizes[slots] = {};
+                uint32_t state = 0x9E3779B9U * (uint32_t)(t + 1U);
+                for (size_t step = 0; step < steps; step++)
+                {
+                    state = state * 1664525U + 1013904223U;
+                    const size_t slot = (state >> 8U) % slots;
+                    if (live[slot] != NULL)
+                    {
+                        for (size_t i = 0; i < sizes[slot]; i++)
+                        {
+                            corrupted[t] += (live[slot][i] != (unsigned char)(slot + t)) ? 1U : 0U;
+                        }
+                        shinyFreeThreadSafe(pool, live[slot]);
+                        live[slot] = NULL;
+                    }
+                    else
+                    {
+                        sizes[slot] = 1U + ((state >> 16U) % 600U);
+                        live[slot] = (unsigned char *)shinyAllocateThreadSafe(pool, sizes[slot]);
+                        if (live[slot] != NULL)
+                        {
+                            memset(live[slot], (int)(slot + t), sizes[slot]);
+                        }
+                    }
+                }
+                for (size_t slot = 0; slot < slots; slot++)
+                {
+                    shinyFreeThreadSafe(pool, live[slot]);
+                } });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        for (size_t t = 0; t < threads; t++)
+        {
+            EXPECT_EQ(corrupted[t], 0U);
+        }
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).outOfMemeoryCount, 0U);
+
+        // The exited threads flushed their magazines, the depot is drained explicitly
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+
+#if SHINYALLOCATOR_MAGAZINES
+    /**
+     * @brief Magazines a running thread still holds for a deinitialized instance are neither served from nor returned
+     * to the instance reinitialized at the same address
+     */
+    TEST(shinyThreadCacheTest, reinitializedOwnerVerification)
+    {
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+
+        std::atomic<int> phase(0);
+        void *fresh = NULL;
+        std::thread worker([pool, &phase, &fresh]()
+                           {
+            void *blocks[8];
+            for (auto &block : blocks)
+            {
+                block = shinyAllocateThreadSafe(pool, 48U);
+            }
+            for (auto block : blocks)
+            {
+                shinyFreeThreadSafe(pool, block);
+            }
+            phase = 1;
+            while (phase != 2)
+            {
+                std::this_thread::yield();
+            }
+            fresh = shinyAllocateThreadSafe(pool, 48U); });
+        while (phase != 1)
+        {
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyInitThreadSafe(arena, arenaSize), pool);
+        void *held = shinyAllocateThreadSafe(pool, 48U);
+        phase = 2;
+        worker.join();
+
+        // Both blocks come from the new pool and the exited thread returned nothing of the old one
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_NE(fresh, (void *)NULL);
+        EXPECT_NE(fresh, held);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, threadSafeFootprint(48U) * 2U);
+        EXPECT_EQ(shinyFreeThreadSafe(pool, fresh), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyFreeThreadSafe(pool, held), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+#endif
+
+    /**
+     * @brief shinyFreeThreadSafe() of blocks allocated by another thread
+     */
+    TEST(shinyThreadCacheTest, remoteFreeVerification)
+    {
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+
+        // The producer allocates every message and the consumer releases them
+        const size_t count = 200U;
+        std::vector<void *> messages(count, (void *)NULL);
+        for (size_t i = 0; i < count; i++)
+        {
+            messages[i] = shinyAllocateThreadSafe(pool, 100U);
+            ASSERT_NE(messages[i], (void *)NULL);
+        }
+        std::thread consumer([pool, &messages]()
+                             {
+            for (auto message : messages)
+            {
+                EXPECT_EQ(shinyFreeThreadSafe(pool, message), SHINYALLOCATOR_OK);
+            }
+            EXPECT_EQ(shinyFreeThreadSafe(pool, NULL), SHINYALLOCATOR_OK); });
+        consumer.join();
+
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+#if SHINYALLOCATOR_REMOTE_FREE && !SHINYALLOCATOR_MAGAZINES && !SHINYALLOCATOR_PERCPU
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).remoteFreeCount, count);
+#elif SHINYALLOCATOR_MAINTENANCE && !SHINYALLOCATOR_REMOTE_FREE
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).remoteFreeCount, 0U);
+#endif
+        EXPECT_NE(shinyAllocateThreadSafe(pool, shinyGetDiagnosticsThreadSafe(pool).capacity / 2U), (void *)NULL);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+
+    /**
+     * @brief More threads than combining slots keep their blocks intact while sharing a thread-safe instance
+     */
+    TEST(shinyThreadCacheTest, heavyContentionVerification)
+    {
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < 24U; t++)
+        {
+            workers.emplace_back([pool, t]()
+                                 {
+                // Every thread keeps a ring of live blocks, so the footprint fits 16-bit offset pools
+                const size_t ring = 8U;
+                std::vector<unsigned char *> blocks(ring, (unsigned char *)NULL);
+                std::vector<size_t> amounts(ring, 0U);
+                for (size_t i = 0; i < 400U; i++)
+                {
+                    const size_t r = i % ring;
+                    for (size_t b = 0; b < amounts[r]; b++)
+                    {
+                        ASSERT_EQ(blocks[r][b], (unsigned char)t);
+                    }
+                    EXPECT_EQ(shinyFreeThreadSafe(pool, blocks[r]), SHINYALLOCATOR_OK);
+                    amounts[r] = 1U + ((i * 7U) % 100U);
+                    blocks[r] = (unsigned char *)shinyAllocateThreadSafe(pool, amounts[r]);
+                    ASSERT_NE(blocks[r], (unsigned char *)NULL);
+                    memset(blocks[r], (int)t, amounts[r]);
+                }
+                for (auto block : blocks)
+                {
+                    EXPECT_EQ(shinyFreeThreadSafe(pool, block), SHINYALLOCATOR_OK);
+                } });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+
+    /**
+     * @brief Allocates, fills, checks and frees a single block in a tight loop, so every call fights for the lock
+     */
+    template <typename Allocate, typename Release>
+    void lockChurn(const unsigned char tag, const size_t amount, Allocate allocate, Release release)
+    {
+        for (size_t i = 0; i < 2000U; i++)
+        {
+            unsigned char *block = (unsigned char *)allocate(amount);
+            ASSERT_NE(block, (unsigned char *)NULL);
+            memset(block, tag, amount);
+            std::this_thread::yield();
+            for (size_t b = 0; b < amount; b++)
+            {
+                ASSERT_EQ(block[b], tag);
+            }
+            EXPECT_EQ(release(block), SHINYALLOCATOR_OK);
+        }
+    }
+
+    /**
+     * @brief The lock and trylock paths of the configured SHINYALLOCATOR_LOCK backend under contention, make test-locks
+     * runs it once per hosted backend
+     */
+    TEST(shinyLockTest, contendedLockAndTryLockVerification)
+    {
+        const size_t threads = 8U;
+        const size_t amount = 48U;
+
+        // Thread-safe calls block on the lock
+        const size_t arenaSize = KiB * 32 + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([pool, t, amount]()
+                                 { lockChurn((unsigned char)t, amount,
+                                             [pool](const size_t n)
+                                             { return shinyAllocateThreadSafe(pool, n); },
+                                             [pool](void *block)
+                                             { return shinyFreeThreadSafe(pool, block); }); });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).outOfMemeoryCount, 0U);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+
+        // Sharded calls try the lock of a shard and move on to the next one while it is held
+        const size_t shards = 2U;
+        const size_t shardedSize = KiB * 16 * shards + sizeof_shinyAllocatorShardedInstance() +
+                                   (sizeof_shinyAllocatorThreadSafeInstance() + instanceFootprint() + SHINYALLOCATOR_ALIGNMENT * 2U) * shards;
+        arena = (char *)aligned_alloc(128, shardedSize);
+        auto sharded = shinyInitSharded(arena, shardedSize, shards);
+        ASSERT_NE(sharded, (shinyAllocatorShardedInstance *)NULL);
+        workers.clear();
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([sharded, t, amount]()
+                                 { lockChurn((unsigned char)t, amount,
+                                             [sharded](const size_t n)
+                                             { return shinyAllocateSharded(sharded, n); },
+                                             [sharded](void *block)
+                                             { return shinyFreeSharded(sharded, block); }); });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        EXPECT_EQ(shinyGetDiagnosticsSharded(sharded).allocated, 0U);
+        EXPECT_EQ(shinyGetDiagnosticsSharded(sharded).outOfMemeoryCount, 0U);
+        EXPECT_EQ(shinyDeinitSharded(sharded), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+
+#if SHINYALLOCATOR_PERCPU
+    /**
+     * @brief Allocate/free/allocate cycles of a thread pinned to one CPU are served by the cache of that CPU
+     */
+    TEST(shinyPerCpuTest, cacheHitVerification)
+    {
+#if !defined(__x86_64__)
+        GTEST_SKIP() << "the per-CPU caches are x86_64 only";
+#endif
+        if (__rseq_size == 0U)
+        {
+            GTEST_SKIP() << "glibc did not register restartable sequences";
+        }
+        cpu_set_t affinity;
+        ASSERT_EQ(sched_getaffinity(0, sizeof(affinity), &affinity), 0);
+        int cpu = 0;
+        while (!CPU_ISSET(cpu, &affinity))
+        {
+            cpu++;
+        }
+        cpu_set_t pinned;
+        CPU_ZERO(&pinned);
+        CPU_SET(cpu, &pinned);
+        ASSERT_EQ(sched_setaffinity(0, sizeof(pinned), &pinned), 0);
+
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+        const size_t amount = 100U;
+        const size_t cycles = 100U;
+        size_t hits = 0U;
+        for (size_t i = 0; i < cycles; i++)
+        {
+            void *block = shinyAllocateThreadSafe(pool, amount);
+            ASSERT_NE(block, (void *)NULL);
+            // A cached block keeps counting as allocated, the locked path would release it to the pool
+            EXPECT_EQ(shinyFreeThreadSafe(pool, block), SHINYALLOCATOR_OK);
+            const bool cached = shinyGetDiagnosticsThreadSafe(pool).allocated == threadSafeFootprint(amount);
+            void *again = shinyAllocateThreadSafe(pool, amount);
+            hits += (cached && (again == block)) ? 1U : 0U;
+            EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, threadSafeFootprint(amount));
+            EXPECT_EQ(shinyFreeThreadSafe(pool, again), SHINYALLOCATOR_OK);
+        }
+        // Only a preemption inside the few instructions of a critical section falls back to the lock
+        EXPECT_GE(hits, cycles - 5U);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).peakAllocated, threadSafeFootprint(amount));
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+        ASSERT_EQ(sched_setaffinity(0, sizeof(affinity), &affinity), 0);
+    }
+
+    /**
+     * @brief Without restartable sequences every call takes the locked path, the test runs itself again with
+     * GLIBC_TUNABLES=glibc.pthread.rseq=0 if glibc registered them for this process
+     */
+    TEST(shinyPerCpuTest, lockedFallbackVerification)
+    {
+        const char *const tunables = getenv("GLIBC_TUNABLES");
+        if (__rseq_size > 0U)
+        {
+            ASSERT_TRUE((tunables == NULL) || (strstr(tunables, "glibc.pthread.rseq=0") == NULL))
+                << "glibc ignored glibc.pthread.rseq=0";
+            char self[4096];
+            const ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1U);
+            ASSERT_GT(length, 0);
+            self[length] = '\0';
+            const std::string command = std::string("GLIBC_TUNABLES=glibc.pthread.rseq=0 '") + self +
+                                        "' --gtest_filter=shinyPerCpuTest.lockedFallbackVerification";
+            const int status = std::system(command.c_str());
+            ASSERT_TRUE(WIFEXITED(status));
+            EXPECT_EQ(WEXITSTATUS(status), 0);
+            return;
+        }
+
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+        const size_t amount = 100U;
+        for (size_t i = 0; i < 100U; i++)
+        {
+            void *block = shinyAllocateThreadSafe(pool, amount);
+            ASSERT_NE(block, (void *)NULL);
+            // Misses still allocate the whole class size, the release goes straight back to the pool
+            EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, threadSafeFootprint(amount));
+            EXPECT_EQ(shinyFreeThreadSafe(pool, block), SHINYALLOCATOR_OK);
+            EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        }
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < 4U; t++)
+        {
+            workers.emplace_back([pool, t, amount]()
+                                 { lockChurn((unsigned char)t, amount,
+                                             [pool](const size_t n)
+                                             { return shinyAllocateThreadSafe(pool, n); },
+                                             [pool](void *block)
+                                             { return shinyFreeThreadSafe(pool, block); }); });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+#endif
+
+    /**
+     * @brief shinyGetDiagnosticsThreadSafe() snapshots are consistent while other threads allocate
+     */
+    TEST(shinyDiagnosticsTest, lockFreeSnapshotVerification)
+    {
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+        const size_t capacity = shinyGetDiagnosticsThreadSafe(pool).capacity;
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(NULL).capacity, 0U);
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < 2U; t++)
+        {
+            workers.emplace_back([pool]()
+                                 {
+                std::vector<void *> blocks;
+                for (size_t i = 0; i < 2000U; i++)
+                {
+                    blocks.push_back(shinyAllocateThreadSafe(pool, 1U + (i % 500U)));
+                    if ((i % 3U) == 2U)
+                    {
+                        shinyFreeThreadSafe(pool, blocks[i / 2U]);
+                        blocks[i / 2U] = NULL;
+                    }
+                }
+                for (auto block : blocks)
+                {
+                    shinyFreeThreadSafe(pool, block);
+                } });
+        }
+        // Fields of a snapshot always come from the same publication
+        for (size_t i = 0; i < 20000U; i++)
+        {
+            const shinyAllocatorDiagnostics snapshot = shinyGetDiagnosticsThreadSafe(pool);
+            EXPECT_EQ(snapshot.capacity, capacity);
+            EXPECT_LE(snapshot.allocated, snapshot.peakAllocated);
+            EXPECT_LE(snapshot.peakAllocated, capacity);
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+
+    /**
+     * @brief Threads of disjoint size classes mixed with calls running alone under the lock keep their blocks intact
+     */
+    TEST(shinyThreadSafeTest, perBinStressVerification)
+    {
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+
+        const size_t threads = 8U;
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([pool, t]()
+                                 {
+                const size_t ring = 8U;
+                // Every thread sticks to its own bin, the last one reallocates through the locked path
+                const size_t amount = 8U << (t % 5U);
+                std::vector<unsigned char *> blocks(ring, (unsigned char *)NULL);
+                std::vector<size_t> amounts(ring, 0U);
+                for (size_t i = 0; i < 3000U; i++)
+                {
+                    const size_t r = (i * 5U) % ring;
+                    for (size_t b = 0; b < amounts[r]; b++)
+                    {
+                        ASSERT_EQ(blocks[r][b], (unsigned char)(t + r));
+                    }
+                    if ((t == threads - 1U) && (blocks[r] != NULL))
+                    {
+                        amounts[r] = amount + (i % amount);
+                        blocks[r] = (unsigned char *)shinyReallocateThreadSafe(pool, blocks[r], amounts[r]);
+                    }
+                    else
+                    {
+                        EXPECT_EQ(shinyFreeThreadSafe(pool, blocks[r]), SHINYALLOCATOR_OK);
+                        amounts[r] = amount - (i % 4U);
+                        blocks[r] = (unsigned char *)shinyAllocateThreadSafe(pool, amounts[r]);
+                    }
+                    ASSERT_NE(blocks[r], (unsigned char *)NULL);
+                    memset(blocks[r], (int)(t + r), amounts[r]);
+                }
+                for (auto block : blocks)
+                {
+                    EXPECT_EQ(shinyFreeThreadSafe(pool, block), SHINYALLOCATOR_OK);
+                } });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).outOfMemeoryCount, 0U);
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        // Every merge skipped under contention has been made up for
+        EXPECT_NE(shinyAllocateThreadSafe(pool, shinyGetDiagnosticsThreadSafe(pool).capacity / 2U), (void *)NULL);
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+
+#if SHINYALLOCATOR_MAINTENANCE
+    /**
+     * @brief Blocks queued by shinyFreeThreadSafe() are released by the maintenance thread, or by an allocation
+     * which needs them
+     */
+    TEST(shinyMaintenanceTest, deferredReleaseVerification)
+    {
+#if SHINYALLOCATOR_OFFSET_BITS == 16
+        GTEST_SKIP() << "the pool does not fit in 16-bit offsets";
+#endif
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+        EXPECT_EQ(shinyStopMaintenanceThreadSafe(pool), SHINYALLOCATOR_ERROR);
+        EXPECT_EQ(shinyStartMaintenanceThreadSafe(pool, 0U, 100U), SHINYALLOCATOR_ERROR);
+
+        // A period far beyond the test keeps the thread asleep, the queue is only released on demand
+        ASSERT_EQ(shinyStartMaintenanceThreadSafe(pool, 60000000U, 100U), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyStartMaintenanceThreadSafe(pool, 1000U, 100U), SHINYALLOCATOR_ERROR);
+        size_t half = shinyGetDiagnosticsThreadSafe(pool).capacity / 2U;
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+        // Blocks past the threshold would have mappings of their own
+        half = (half < largeThreshold()) ? half : (largeThreshold() - 1U);
+#endif
+        void *block = shinyAllocateThreadSafe(pool, half);
+        ASSERT_NE(block, (void *)NULL);
+        EXPECT_EQ(shinyFreeThreadSafe(pool, block), SHINYALLOCATOR_OK);
+        EXPECT_NE(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        block = shinyAllocateThreadSafe(pool, half);
+        ASSERT_NE(block, (void *)NULL);
+        EXPECT_EQ(shinyFreeThreadSafe(pool, block), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyStopMaintenanceThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+
+        ASSERT_EQ(shinyStartMaintenanceThreadSafe(pool, 200U, 50U), SHINYALLOCATOR_OK);
+        const size_t threads = 4U;
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([pool, t]()
+                                 {
+                const size_t ring = 32U;
+                std::vector<unsigned char *> blocks(ring, (unsigned char *)NULL);
+                std::vector<size_t> amounts(ring, 0U);
+                for (size_t i = 0; i < 5000U; i++)
+                {
+                    const size_t r = (i * 7U) % ring;
+                    for (size_t b = 0; b < amounts[r]; b++)
+                    {
+                        ASSERT_EQ(blocks[r][b], (unsigned char)(t + r));
+                    }
+                    EXPECT_EQ(shinyFreeThreadSafe(pool, blocks[r]), SHINYALLOCATOR_OK);
+                    // Above the size classes of the thread caches, so every block goes through the queue
+                    amounts[r] = 2U * KiB + ((i * 37U + t) % 700U);
+                    blocks[r] = (unsigned char *)shinyAllocateThreadSafe(pool, amounts[r]);
+                    ASSERT_NE(blocks[r], (unsigned char *)NULL);
+                    memset(blocks[r], (int)(t + r), amounts[r]);
+                }
+                for (auto block : blocks)
+                {
+                    EXPECT_EQ(shinyFreeThreadSafe(pool, block), SHINYALLOCATOR_OK);
+                } });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        // The thread catches up on its own within a few periods
+        for (size_t i = 0; (i < 1000U) && (shinyGetDiagnosticsThreadSafe(pool).allocated != 0U); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, 0U);
+        EXPECT_NE(shinyGetDiagnosticsThreadSafe(pool).remoteFreeCount, 0U);
+#if SHINYALLOCATOR_PURGE
+        // Idle periods return the free pages to the OS a few fragments at a time
+        for (size_t i = 0; (i < 1000U) && (shinyGetDiagnosticsThreadSafe(pool).purged == 0U); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_NE(shinyGetDiagnosticsThreadSafe(pool).purged, 0U);
+#endif
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+#endif
+
+#if SHINYALLOCATOR_EPOCH
+    /**
+     * @brief Retired blocks outlive the critical sections that might hold them and are released in bulk afterwards
+     */
+    TEST(shinyEpochTest, deferredReclamationVerification)
+    {
+        const size_t arenaSize = MiB + sizeof_shinyAllocatorThreadSafeInstance() + SHINYALLOCATOR_ALIGNMENT;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitThreadSafe(arena, arenaSize);
+        ASSERT_NE(pool, (shinyAllocatorThreadSafeInstance *)NULL);
+        const size_t baseline = shinyGetDiagnosticsThreadSafe(pool).allocated;
+
+        size_t reader = 0U;
+        size_t writer = 0U;
+        ASSERT_EQ(shinyEpochEnterThreadSafe(pool, &reader), SHINYALLOCATOR_OK);
+        ASSERT_EQ(shinyEpochEnterThreadSafe(pool, &writer), SHINYALLOCATOR_OK);
+        EXPECT_NE(reader, writer);
+        void *node = shinyAllocateThreadSafe(pool, 100U);
+        ASSERT_NE(node, (void *)NULL);
+        EXPECT_EQ(shinyRetireThreadSafe(pool, writer, node), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyRetireThreadSafe(pool, writer, NULL), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyEpochExitThreadSafe(pool, writer), SHINYALLOCATOR_OK);
+
+        // The open critical section keeps the retired block alive
+        for (size_t i = 0; i < 4U; i++)
+        {
+            EXPECT_EQ(shinyReclaimThreadSafe(pool), SHINYALLOCATOR_OK);
+        }
+        EXPECT_GT(shinyGetDiagnosticsThreadSafe(pool).allocated, baseline);
+        EXPECT_EQ(shinyEpochExitThreadSafe(pool, reader), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyReclaimThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyReclaimThreadSafe(pool), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsThreadSafe(pool).allocated, baseline);
+        EXPECT_EQ(shinyEpochExitThreadSafe(pool, 1000U), SHINYALLOCATOR_ERROR);
+        EXPECT_EQ(shinyRetireThreadSafe(NULL, 0U, NULL), SHINYALLOCATOR_ERROR);
+
+        // Readers check the node they reach while a writer replaces and retires it
+        struct Node
+        {
+            size_t check[8];
+        };
+        Node *shared = (Node *)shinyAllocateThreadSafe(pool, sizeof(Node));
+        ASSERT_NE(shared, (Node *)NULL);
+        for (auto &word : shared->check)
+        {
+            word = 0U;
+        }
+        std::vector<std::thread> workers;
+        std::vector<size_t> corrupted(3U, 0U);
+        for (size_t t = 0; t < 3U; t++)
+        {
+            workers.emplace_back([pool, t, &shared, &corrupted]()
+                                 {
+                for (size_t i = 0; i < 20000U; i++)
+                {
+                    size_t guard = 0U;
+                    ASSERT_EQ(shinyEpochEnterThreadSafe(pool, &guard), SHINYALLOCATOR_OK);
+                    const Node *const current = __atomic_load_n(&shared, __ATOMIC_ACQUIRE);
+                    const size_t first = __atomic_load_n(&current->check[0], __ATOMIC_RELAXED);
+                    for (auto &word : current->check)
+                    {
+                        corrupted[t] += (__atomic_load_n(&word, __ATOMIC_RELAXED) != first) ? 1U : 0U;
+                    }
+                    EXPECT_EQ(shinyEpochExitThreadSafe(pool, guard), SHINYALLOCATOR_OK);
+                } });
+        }
+        for (size_t i = 1; i <= 5000U; i++)
+        {
+            size_t guard = 0U;
+            Node *const next = (Node *)shinyAllocateThreadSafe(pool, sizeof(Node));
+            ASSERT_NE(next, (Node *)NULL);
+            for (auto &word : next->check)
+            {
+                __atomic_store_n(&word, i, __ATOMIC_RELAXED);
+            }
+            ASSERT_EQ(shinyEpochEnterThreadSafe(pool, &guard), SHINYALLOCATOR_OK);
+            Node *const old = __atomic_exchange_n(&shared, next, __ATOMIC_ACQ_REL);
+            EXPECT_EQ(shinyRetireThreadSafe(pool, guard, old), SHINYALLOCATOR_OK);
+            EXPECT_EQ(shinyEpochExitThreadSafe(pool, guard), SHINYALLOCATOR_OK);
+            if ((i % 64U) == 0U)
+            {
+                EXPECT_EQ(shinyReclaimThreadSafe(pool), SHINYALLOCATOR_OK);
+            }
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        for (auto count : corrupted)
+        {
+            EXPECT_EQ(count, 0U);
+        }
+        shinyFreeThreadSafe(pool, shared);
+        EXPECT_EQ(shinyFlushThreadCacheThreadSafe(pool), SHINYALLOCATOR_OK);
+        // Blocks still in their grace period are released by the deinitialization
+        EXPECT_EQ(shinyDeinitThreadSafe(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+#endif
+
+    /**
+     * @brief shinyAllocateSharded() and shinyFreeSharded() API test
+     */
+    TEST(shinyShardedTest, routingAndSpilloverVerification)
+    {
+        const size_t KiB32 = KiB * 32;
+        const size_t shards = 4U;
+        // Every shard holds its thread-safe header, the instance, the alignment of the first fragment and a tail which is
+        // large enough to stay a free fragment of its own
+        const size_t shardSize = sizeof_shinyAllocatorThreadSafeInstance() + instanceFootprint() + KiB32 + footprint(1U) +
+                                 SHINYALLOCATOR_ALIGNMENT * 2U;
+        const size_t headerSize = (sizeof_shinyAllocatorShardedInstance() + SHINYALLOCATOR_ALIGNMENT - 1U) & ~(SHINYALLOCATOR_ALIGNMENT - 1U);
+        const size_t arenaSize = headerSize + shardSize * shards;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        EXPECT_EQ(shinyInitSharded(arena, arenaSize, 0U), (shinyAllocatorShardedInstance *)NULL);
+        EXPECT_EQ(shinyInitSharded(arena, 100U, shards), (shinyAllocatorShardedInstance *)NULL);
+
+        auto pool = shinyInitSharded(arena, arenaSize, shards);
+        ASSERT_NE(pool, (shinyAllocatorShardedInstance *)NULL);
+        const size_t capacity = shinyGetDiagnosticsSharded(pool).capacity;
+        EXPECT_GE(capacity, KiB32 * shards);
+        EXPECT_EQ(shinyAllocateSharded(pool, KiB32 * 2U), (void *)NULL);
+
+        // Requests spill over to the other shards once the first one is full
+        std::vector<void *> blocks;
+        for (void *block = shinyAllocateSharded(pool, KiB); block != NULL; block = shinyAllocateSharded(pool, KiB))
+        {
+            blocks.push_back(block);
+        }
+        EXPECT_GE(blocks.size(), (KiB32 / footprint(KiB) - 1U) * shards);
+        EXPECT_EQ(shinyGetDiagnosticsSharded(pool).allocated, blocks.size() * footprint(KiB));
+
+        std::vector<std::thread> workers;
+        const size_t threads = 4U;
+        for (size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([pool, &blocks, t, threads]()
+                                 {
+                for (size_t i = t; i < blocks.size(); i += threads)
+                {
+                    EXPECT_EQ(shinyFreeSharded(pool, blocks[i]), SHINYALLOCATOR_OK);
+                }
+                for (size_t i = 0; i < 1000U; i++)
+                {
+                    void *block = shinyAllocateSharded(pool, 1U + (i % 300U));
+                    EXPECT_NE(block, (void *)NULL);
+                    EXPECT_EQ(shinyFreeSharded(pool, block), SHINYALLOCATOR_OK);
+                } });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        EXPECT_EQ(shinyFreeSharded(pool, NULL), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsSharded(pool).allocated, 0U);
+        EXPECT_EQ(shinyDeinitSharded(pool), SHINYALLOCATOR_OK);
+        free(arena);
+    }
+
+#if SHINYALLOCATOR_LARGE_MAPPINGS
+    /**
+     * @brief shinyFreeSharded() of blocks with a mapping of their own, which may lie below or above the arena
+     */
+    TEST(shinyShardedTest, mappedBlockVerification)
+    {
+        const size_t arenaSize = MiB * 64;
+        void *arena = (char *)aligned_alloc(128, arenaSize);
+        auto pool = shinyInitSharded(arena, arenaSize, 2U);
+        ASSERT_NE(pool, (shinyAllocatorShardedInstance *)NULL);
+
+        std::vector<char *> blocks;
+        for (size_t i = 0; i < 4U; i++)
+        {
+            char *const block = (char *)shinyAllocateSharded(pool, MiB * 16);
+            ASSERT_NE(block, (char *)NULL);
+            EXPECT_TRUE((block + MiB * 16 <= (char *)arena) || (block >= (char *)arena + arenaSize));
+            memset(block, 0x5A, MiB * 16);
+            blocks.push_back(block);
+        }
+        EXPECT_GE(shinyGetDiagnosticsSharded(pool).mapped, MiB * 64);
+        EXPECT_EQ(shinyGetDiagnosticsSharded(pool).allocated, 0U);
+        for (auto block : blocks)
+        {
+            EXPECT_EQ(shinyFreeSharded(pool, block), SHINYALLOCATOR_OK);
+        }
+        // Blocks queued for a shard are released by its next allocation
+        void *const block = shinyAllocateSharded(pool, 1U);
+        EXPECT_NE(block, (void *)NULL);
+        EXPECT_EQ(shinyFreeSharded(pool, block), SHINYALLOCATOR_OK);
+        EXPECT_EQ(shinyGetDiagnosticsSharded(pool).mapped, 0U);
+        EXPECT_EQ(shinyGetDiagnosticsSharded(pool).outOfMemeoryCount, 0U);
+        EXPECT_EQ(shinyDeinitSharded(pool), SHINYALLOCATOR_OK);
+        free(arena);
     }
-}
\ No newline at end of file
+#endif
+}